@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <phmap.h>
+#include "LittleBigVector.h"
+#include "TwobitLittleBigVector.h"
+#include "MsatValueVector.h"
+
+// sequential and random get() over LittleBigVector and TwobitLittleBigVector, with the layouts they replaced as references
+// usage: LittleBigVectorBench [elements] [passes]
+
+// LittleBigVector before the big value bitmap, every read probes the hashmap first
+template <typename LittleType, typename BigType>
+class ProbeFirstLittleBigVector
+{
+public:
+	void resize(size_t size)
+	{
+		littles.resize(size);
+	}
+	BigType get(size_t i) const
+	{
+		auto found = bigs.find(i);
+		if (found != bigs.end()) return found->second;
+		return littles[i];
+	}
+	void set(size_t i, BigType v)
+	{
+		if (v <= (BigType)std::numeric_limits<LittleType>::max())
+		{
+			auto found = bigs.find(i);
+			if (found != bigs.end()) bigs.erase(found);
+			littles[i] = (LittleType)v;
+			return;
+		}
+		bigs[i] = v;
+	}
+private:
+	std::vector<LittleType> littles;
+	phmap::flat_hash_map<uint32_t, BigType> bigs;
+};
+
+// TwobitLittleBigVector before MsatValueVector::has, every read calls MsatValueVector::get and compares to the missing value
+class GetFirstTwobitLittleBigVector
+{
+public:
+	void resize(size_t size)
+	{
+		littles.resize((size+3)/4);
+		bigs.resize(size);
+	}
+	uint16_t get(size_t i) const
+	{
+		auto got = bigs.get(i);
+		if (got != 65535) return got;
+		return (littles[i / 4] >> ((i % 4) * 2)) & 3;
+	}
+	void set(size_t i, uint16_t v)
+	{
+		if (v <= 3)
+		{
+			littles[i / 4] &= ~(3 << ((i % 4) * 2));
+			littles[i / 4] |= v << ((i % 4) * 2);
+			return;
+		}
+		bigs.set(i, v);
+	}
+private:
+	std::vector<uint8_t> littles;
+	MsatValueVector bigs;
+};
+
+template <typename Vector>
+void fill(Vector& vec, const std::vector<uint16_t>& values)
+{
+	vec.resize(values.size());
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		vec.set(i, values[i]);
+	}
+}
+
+// sums the values so the reads are not optimized away
+template <typename Vector>
+void timeGets(const std::string& name, const Vector& vec, const std::vector<uint32_t>& order, const size_t passes)
+{
+	auto start = std::chrono::steady_clock::now();
+	size_t sum = 0;
+	for (size_t pass = 0; pass < passes; pass++)
+	{
+		for (uint32_t i : order)
+		{
+			sum += vec.get(i);
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000000.0;
+	std::cout << name << "\t" << seconds << " s\t" << (seconds * 1000000000.0 / (order.size() * passes)) << " ns/get\t(sum " << sum << ")" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	size_t numElements = 20000000;
+	size_t passes = 5;
+	if (argc > 1) numElements = std::stoull(argv[1]);
+	if (argc > 2) passes = std::stoull(argv[2]);
+	std::mt19937_64 rand { 1 };
+	// k-mer coverages: mostly below 256 with a tail of high coverage repeats
+	std::vector<uint16_t> coverages;
+	// hpc run lengths: mostly 1-3 with some microsatellite runs
+	std::vector<uint16_t> runLengths;
+	coverages.resize(numElements);
+	runLengths.resize(numElements);
+	for (size_t i = 0; i < numElements; i++)
+	{
+		coverages[i] = (rand() % 100 == 0) ? 256 + rand() % 10000 : rand() % 64;
+		runLengths[i] = (rand() % 100 == 0) ? 4 + rand() % 1000 : rand() % 4;
+	}
+	std::vector<uint32_t> sequential;
+	sequential.resize(numElements);
+	for (size_t i = 0; i < numElements; i++)
+	{
+		sequential[i] = i;
+	}
+	std::vector<uint32_t> random { sequential };
+	std::shuffle(random.begin(), random.end(), rand);
+	std::cout << numElements << " elements, " << passes << " passes" << std::endl;
+	{
+		LittleBigVector<uint8_t, size_t> vec;
+		fill(vec, coverages);
+		timeGets("LittleBigVector sequential", vec, sequential, passes);
+		timeGets("LittleBigVector random", vec, random, passes);
+	}
+	{
+		ProbeFirstLittleBigVector<uint8_t, size_t> vec;
+		fill(vec, coverages);
+		timeGets("probe first LittleBigVector sequential", vec, sequential, passes);
+		timeGets("probe first LittleBigVector random", vec, random, passes);
+	}
+	{
+		TwobitLittleBigVector<uint16_t> vec;
+		fill(vec, runLengths);
+		timeGets("TwobitLittleBigVector sequential", vec, sequential, passes);
+		timeGets("TwobitLittleBigVector random", vec, random, passes);
+	}
+	{
+		GetFirstTwobitLittleBigVector vec;
+		fill(vec, runLengths);
+		timeGets("get first TwobitLittleBigVector sequential", vec, sequential, passes);
+		timeGets("get first TwobitLittleBigVector random", vec, random, passes);
+	}
+}
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <cassert>
+#include "CompactEdgeContainer.h"
+#include "ParallelHelper.h"
+
+CompactEdgeContainer::CompactEdgeContainer() :
+	nodeCount(0),
+	offsets(1, 0)
+{
+}
+
+CompactEdgeContainer::CompactEdgeContainer(const HashList& hashlist, const size_t minCoverage, const size_t numThreads) :
+	nodeCount(hashlist.size())
+{
+	build(numThreads, [&hashlist, minCoverage](std::pair<size_t, bool> from)
+	{
+		std::vector<std::pair<std::pair<size_t, bool>, size_t>> result;
+		for (auto edge : hashlist.getEdgeCoverages(from))
+		{
+			if (edge.second < minCoverage) continue;
+			result.push_back(edge);
+		}
+		return result;
+	});
+}
+
+CompactEdgeContainer::CompactEdgeContainer(const SparseEdgeContainer& edges, const size_t numThreads) :
+	nodeCount(edges.size())
+{
+	build(numThreads, [&edges](std::pair<size_t, bool> from)
+	{
+		std::vector<std::pair<std::pair<size_t, bool>, size_t>> result;
+		for (auto to : edges[from])
+		{
+			result.emplace_back(to, 0);
+		}
+		return result;
+	});
+}
+
+// replaces counts[0, size) with their prefix sums and returns the total, ranges are summed in parallel
+uint32_t prefixSumMultithreaded(std::vector<uint32_t>& counts, const size_t size, const size_t numThreads)
+{
+	std::vector<size_t> rangeTotal;
+	rangeTotal.resize(getNumRanges(size, numThreads)+1, 0);
+	iterateRangesMultithreaded(size, numThreads, [&counts, &rangeTotal](size_t range, size_t start, size_t end)
+	{
+		size_t total = 0;
+		for (size_t i = start; i < end; i++)
+		{
+			total += counts[i];
+		}
+		rangeTotal[range+1] = total;
+	});
+	for (size_t i = 1; i < rangeTotal.size(); i++)
+	{
+		rangeTotal[i] += rangeTotal[i-1];
+	}
+	assert(rangeTotal.back() <= (size_t)std::numeric_limits<uint32_t>::max());
+	iterateRangesMultithreaded(size, numThreads, [&counts, &rangeTotal](size_t range, size_t start, size_t end)
+	{
+		size_t pos = rangeTotal[range];
+		for (size_t i = start; i < end; i++)
+		{
+			size_t count = counts[i];
+			counts[i] = pos;
+			pos += count;
+		}
+	});
+	return rangeTotal.back();
+}
+
+template <typename F>
+void CompactEdgeContainer::build(const size_t numThreads, F getEdges)
+{
+	// an edge is usually found from only one of its ends, so the reverse edge usually belongs to another thread's node range
+	// edges are counted per side first, then written with an atomic cursor per side straight into a candidate array
+	// candidates are (target << 32) + coverage so sorting a side sorts by target, duplicates are edges found from both ends or from a node side to its own reverse
+	assert(nodeCount < ((size_t)1 << 31));
+	const size_t numSides = nodeCount * 2;
+	std::vector<std::atomic<uint32_t>> sideCursor(numSides);
+	iterateChunksMultithreaded(nodeCount, numThreads, 1024, [this, &getEdges, &sideCursor](size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			for (std::pair<size_t, bool> from : { std::make_pair(i, true), std::make_pair(i, false) })
+			{
+				for (auto edge : getEdges(from))
+				{
+					sideCursor[sideIndex(from)] += 1;
+					sideCursor[sideIndex(reverse(edge.first))] += 1;
+				}
+			}
+		}
+	});
+	std::vector<uint32_t> candidateOffsets;
+	candidateOffsets.resize(numSides+1);
+	iterateChunksMultithreaded(numSides, numThreads, 4096, [&sideCursor, &candidateOffsets](size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			candidateOffsets[i] = sideCursor[i].load(std::memory_order_relaxed);
+		}
+	});
+	candidateOffsets[numSides] = prefixSumMultithreaded(candidateOffsets, numSides, numThreads);
+	iterateChunksMultithreaded(numSides, numThreads, 4096, [&sideCursor, &candidateOffsets](size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			sideCursor[i].store(candidateOffsets[i], std::memory_order_relaxed);
+		}
+	});
+	std::vector<uint64_t> candidates;
+	candidates.resize(candidateOffsets[numSides]);
+	iterateChunksMultithreaded(nodeCount, numThreads, 1024, [this, &getEdges, &sideCursor, &candidates](size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			for (std::pair<size_t, bool> from : { std::make_pair(i, true), std::make_pair(i, false) })
+			{
+				for (auto edge : getEdges(from))
+				{
+					uint64_t coverage = std::min(edge.second, (size_t)std::numeric_limits<uint32_t>::max());
+					candidates[sideCursor[sideIndex(from)]++] = ((uint64_t)packEdgeTarget(edge.first) << 32) + coverage;
+					candidates[sideCursor[sideIndex(reverse(edge.first))]++] = ((uint64_t)packEdgeTarget(reverse(from)) << 32) + coverage;
+				}
+			}
+		}
+	});
+	{
+		std::vector<std::atomic<uint32_t>> tmp;
+		std::swap(tmp, sideCursor);
+	}
+	offsets.resize(numSides+1);
+	iterateChunksMultithreaded(numSides, numThreads, 4096, [this, &candidates, &candidateOffsets](size_t start, size_t end)
+	{
+		for (size_t side = start; side < end; side++)
+		{
+			auto sideStart = candidates.begin() + candidateOffsets[side];
+			auto sideEnd = candidates.begin() + candidateOffsets[side+1];
+			std::sort(sideStart, sideEnd);
+			// keeps the smallest coverage of duplicates
+			auto newEnd = std::unique(sideStart, sideEnd, [](uint64_t left, uint64_t right) { return (left >> 32) == (right >> 32); });
+			offsets[side] = newEnd - sideStart;
+		}
+	});
+	offsets[numSides] = prefixSumMultithreaded(offsets, numSides, numThreads);
+	targets.resize(offsets[numSides]);
+	coverages.resize(offsets[numSides]);
+	iterateChunksMultithreaded(numSides, numThreads, 4096, [this, &candidates, &candidateOffsets](size_t start, size_t end)
+	{
+		for (size_t side = start; side < end; side++)
+		{
+			for (size_t i = 0; i < offsets[side+1] - offsets[side]; i++)
+			{
+				uint64_t candidate = candidates[candidateOffsets[side] + i];
+				targets[offsets[side] + i] = (uint32_t)(candidate >> 32);
+				coverages[offsets[side] + i] = (uint32_t)(candidate & 0xFFFFFFFF);
+			}
+		}
+	});
+}
+
+size_t CompactEdgeContainer::sideIndex(std::pair<size_t, bool> index) const
+{
+	return index.first * 2 + (index.second ? 1 : 0);
+}
+
+CompactEdgeView CompactEdgeContainer::operator[](std::pair<size_t, bool> index) const
+{
+	assert(index.first < nodeCount);
+	size_t side = sideIndex(index);
+	return CompactEdgeView { targets.data() + offsets[side], targets.data() + offsets[side+1] };
+}
+
+size_t CompactEdgeContainer::size() const
+{
+	return nodeCount;
+}
+
+size_t CompactEdgeContainer::numEdges() const
+{
+	return targets.size();
+}
+
+CompactEdgeContainer CompactEdgeContainer::filterByCoverage(const size_t minCoverage, const size_t numThreads) const
+{
+	const size_t numSides = nodeCount * 2;
+	CompactEdgeContainer result;
+	result.nodeCount = nodeCount;
+	result.offsets.resize(numSides + 1);
+	iterateChunksMultithreaded(numSides, numThreads, 4096, [this, &result, minCoverage](size_t start, size_t end)
+	{
+		for (size_t side = start; side < end; side++)
+		{
+			uint32_t count = 0;
+			for (size_t i = offsets[side]; i < offsets[side+1]; i++)
+			{
+				if (coverages[i] >= minCoverage) count += 1;
+			}
+			result.offsets[side] = count;
+		}
+	});
+	result.offsets[numSides] = prefixSumMultithreaded(result.offsets, numSides, numThreads);
+	result.targets.resize(result.offsets[numSides]);
+	result.coverages.resize(result.offsets[numSides]);
+	iterateChunksMultithreaded(numSides, numThreads, 4096, [this, &result, minCoverage](size_t start, size_t end)
+	{
+		for (size_t side = start; side < end; side++)
+		{
+			size_t pos = result.offsets[side];
+			for (size_t i = offsets[side]; i < offsets[side+1]; i++)
+			{
+				if (coverages[i] < minCoverage) continue;
+				result.targets[pos] = targets[i];
+				result.coverages[pos] = coverages[i];
+				pos += 1;
+			}
+			assert(pos == result.offsets[side+1]);
+		}
+	});
+	return result;
+}
+
+void CompactEdgeContainer::filter(const RankBitvector& kept)
+{
+	if (kept.size() == 0) return;
+	assert(kept.size() == nodeCount);
+	size_t newSize = kept.getRank(kept.size()-1) + (kept.get(kept.size()-1) ? 1 : 0);
+	if (newSize == nodeCount) return;
+	std::vector<uint32_t> newOffsets;
+	std::vector<uint32_t> newTargets;
+	std::vector<uint32_t> newCoverages;
+	newOffsets.resize(newSize * 2 + 1);
+	newTargets.reserve(targets.size());
+	newCoverages.reserve(coverages.size());
+	for (size_t i = 0; i < nodeCount; i++)
+	{
+		if (!kept.get(i)) continue;
+		size_t newNode = kept.getRank(i);
+		for (size_t offset = 0; offset < 2; offset++)
+		{
+			size_t side = i * 2 + offset;
+			newOffsets[newNode * 2 + offset] = newTargets.size();
+			for (size_t j = offsets[side]; j < offsets[side+1]; j++)
+			{
+				std::pair<size_t, bool> target = unpackEdgeTarget(targets[j]);
+				if (!kept.get(target.first)) continue;
+				// ranks are monotonic so the edges stay sorted
+				newTargets.push_back(packEdgeTarget(std::make_pair(kept.getRank(target.first), target.second)));
+				newCoverages.push_back(coverages[j]);
+			}
+		}
+	}
+	newOffsets[newSize * 2] = newTargets.size();
+	nodeCount = newSize;
+	std::swap(offsets, newOffsets);
+	std::swap(targets, newTargets);
+	std::swap(coverages, newCoverages);
+}
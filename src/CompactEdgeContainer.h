@@ -0,0 +1,106 @@
+#ifndef CompactEdgeContainer_h
+#define CompactEdgeContainer_h
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "RankBitvector.h"
+#include "HashList.h"
+#include "SparseEdgeContainer.h"
+
+// node side packed into 32 bits as (node << 1) + forward, sorts the same as std::pair<size_t, bool>
+inline uint32_t packEdgeTarget(std::pair<size_t, bool> target)
+{
+	assert(target.first < ((size_t)1 << 31));
+	return (uint32_t)((target.first << 1) + (target.second ? 1 : 0));
+}
+
+inline std::pair<size_t, bool> unpackEdgeTarget(uint32_t packed)
+{
+	return std::make_pair((size_t)(packed >> 1), (packed & 1) == 1);
+}
+
+// the edges of one node side, decoded from the packed targets on access
+class CompactEdgeView
+{
+public:
+	class Iterator
+	{
+	public:
+		Iterator(const uint32_t* pos) :
+			pos(pos)
+		{
+		}
+		std::pair<size_t, bool> operator*() const
+		{
+			return unpackEdgeTarget(*pos);
+		}
+		Iterator& operator++()
+		{
+			pos += 1;
+			return *this;
+		}
+		bool operator!=(const Iterator& other) const
+		{
+			return pos != other.pos;
+		}
+	private:
+		const uint32_t* pos;
+	};
+	CompactEdgeView(const uint32_t* start, const uint32_t* end) :
+		start(start),
+		stop(end)
+	{
+	}
+	size_t size() const
+	{
+		return stop - start;
+	}
+	std::pair<size_t, bool> operator[](size_t pos) const
+	{
+		assert(pos < size());
+		return unpackEdgeTarget(start[pos]);
+	}
+	Iterator begin() const
+	{
+		return Iterator { start };
+	}
+	Iterator end() const
+	{
+		return Iterator { stop };
+	}
+private:
+	const uint32_t* start;
+	const uint32_t* stop;
+};
+
+// immutable adjacency lists of the k-mer graph, laid out as one offset array and one edge array
+// edges of each node side are sorted, each edge is stored from both of its ends
+// node sides are packed into 32 bits, so there can be at most 2^31 nodes and 2^32 stored edges
+class CompactEdgeContainer
+{
+public:
+	CompactEdgeContainer();
+	// all edges of hashlist with coverage at least minCoverage
+	CompactEdgeContainer(const HashList& hashlist, const size_t minCoverage, const size_t numThreads);
+	// all edges of a unitig graph, coverages are not stored and are zero
+	CompactEdgeContainer(const SparseEdgeContainer& edges, const size_t numThreads);
+	CompactEdgeView operator[](std::pair<size_t, bool> index) const;
+	size_t size() const;
+	size_t numEdges() const;
+	CompactEdgeContainer filterByCoverage(const size_t minCoverage, const size_t numThreads) const;
+	// remove nodes which are not in kept and renumber the rest to their rank, same as HashList::filter
+	void filter(const RankBitvector& kept);
+private:
+	// getEdges(from) returns the (to, coverage) pairs of edges starting at from
+	template <typename F>
+	void build(const size_t numThreads, F getEdges);
+	size_t sideIndex(std::pair<size_t, bool> index) const;
+	size_t nodeCount;
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> targets;
+	std::vector<uint32_t> coverages;
+};
+
+#endif
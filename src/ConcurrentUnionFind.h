@@ -0,0 +1,58 @@
+#ifndef ConcurrentUnionFind_h
+#define ConcurrentUnionFind_h
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+// union-find over [0, size) where merge and find can be called from multiple threads at the same time
+// roots are always linked towards the smaller index, so once all merges are done the root of a set is its smallest item
+class ConcurrentUnionFind
+{
+public:
+	ConcurrentUnionFind(size_t size) :
+		numItems(size),
+		parent(new std::atomic<size_t>[size])
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			parent[i].store(i, std::memory_order_relaxed);
+		}
+	}
+	size_t size() const
+	{
+		return numItems;
+	}
+	size_t find(size_t item)
+	{
+		assert(item < numItems);
+		while (true)
+		{
+			size_t itemParent = parent[item].load();
+			if (itemParent == item) return item;
+			size_t grandParent = parent[itemParent].load();
+			// path halving, losing the race only means the path is not shortened
+			if (grandParent != itemParent) parent[item].compare_exchange_weak(itemParent, grandParent);
+			item = grandParent;
+		}
+	}
+	void merge(size_t left, size_t right)
+	{
+		while (true)
+		{
+			left = find(left);
+			right = find(right);
+			if (left == right) return;
+			if (left < right) std::swap(left, right);
+			size_t expected = left;
+			// fails if another thread linked left somewhere in the meantime, then retry from the new roots
+			if (parent[left].compare_exchange_strong(expected, right)) return;
+		}
+	}
+private:
+	size_t numItems;
+	std::unique_ptr<std::atomic<size_t>[]> parent;
+};
+
+#endif
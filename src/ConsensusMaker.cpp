@@ -1,6 +1,8 @@
+#include <algorithm>
 #include <unordered_map>
 #include "ConsensusMaker.h"
 #include "ErrorMaskHelper.h"
+#include "ParallelHelper.h"
 
 ConsensusMaker::~ConsensusMaker()
 {
@@ -8,6 +10,10 @@ ConsensusMaker::~ConsensusMaker()
 	{
 		delete simpleSequenceMutexes[i];
 	}
+	for (size_t i = 0; i < stringIndexMutexes.size(); i++)
+	{
+		delete stringIndexMutexes[i];
+	}
 }
 
 void ConsensusMaker::init(const std::vector<size_t>& unitigLengths)
@@ -26,10 +32,99 @@ void ConsensusMaker::init(const std::vector<size_t>& unitigLengths)
 	{
 		totalLength += unitigLengths[i];
 		assert(unitigLengths[i] >= 1);
+		assert(unitigLengths[i] <= std::numeric_limits<uint32_t>::max());
 		compressedSequences[i].resize(unitigLengths[i]);
-		simpleCounts[i].resize(unitigLengths[i]);
+		simpleCounts[i] = std::vector<std::atomic<uint16_t>>(unitigLengths[i]);
 	}
 	stringIndex.init(maxCode());
+	for (size_t i = 0; i < maxCode(); i++)
+	{
+		stringIndexMutexes.emplace_back(new std::mutex);
+	}
+}
+
+uint32_t ConsensusMaker::getStringIndex(uint16_t compressed, const std::string& raw, size_t start, size_t length, bool fw)
+{
+	// homopolymer runs are indexed by their length and don't touch the string maps
+	if (compressed <= 3) return stringIndex.getIndex(compressed, raw, start, length, fw);
+	std::lock_guard<std::mutex> guard { *stringIndexMutexes[std::min(compressed, complement(compressed))] };
+	return stringIndex.getIndex(compressed, raw, start, length, fw);
+}
+
+std::pair<uint8_t, uint8_t> ConsensusMaker::getSimpleCount(size_t unitig, size_t offset) const
+{
+	uint16_t packed = simpleCounts[unitig][offset].load(std::memory_order_relaxed);
+	return std::make_pair((uint8_t)(packed >> 8), (uint8_t)(packed & 255));
+}
+
+void ConsensusMaker::compactComplexCountLog(std::vector<std::tuple<size_t, uint32_t, uint32_t, uint32_t>>& log)
+{
+	std::sort(log.begin(), log.end());
+	size_t kept = 0;
+	for (size_t i = 0; i < log.size(); i++)
+	{
+		if (kept > 0 && std::get<0>(log[kept-1]) == std::get<0>(log[i]) && std::get<1>(log[kept-1]) == std::get<1>(log[i]) && std::get<2>(log[kept-1]) == std::get<2>(log[i]))
+		{
+			std::get<3>(log[kept-1]) += std::get<3>(log[i]);
+			continue;
+		}
+		log[kept] = log[i];
+		kept += 1;
+	}
+	log.resize(kept);
+	// logs are compacted when full, so grow a log which didn't shrink enough to not compact again right away
+	if (log.size() > log.capacity() / 2) log.reserve(log.capacity() * 2);
+}
+
+void ConsensusMaker::mergeComplexCountLogs(const size_t numThreads)
+{
+	complexCounts.resize(simpleCounts.size());
+	for (auto& log : complexCountLogs.getBuffers())
+	{
+		for (auto entry : *log)
+		{
+			complexCounts[std::get<0>(entry)].emplace_back(std::get<1>(entry), std::get<2>(entry), std::get<3>(entry));
+		}
+		std::vector<std::tuple<size_t, uint32_t, uint32_t, uint32_t>> tmp;
+		std::swap(tmp, *log);
+	}
+	iterateChunksMultithreaded(complexCounts.size(), numThreads, 256, [this](size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			std::vector<std::tuple<uint32_t, uint32_t, uint32_t>>& counts = complexCounts[i];
+			if (counts.size() == 0) continue;
+			std::sort(counts.begin(), counts.end());
+			size_t kept = 0;
+			for (size_t j = 0; j < counts.size(); j++)
+			{
+				if (kept > 0 && std::get<0>(counts[kept-1]) == std::get<0>(counts[j]) && std::get<1>(counts[kept-1]) == std::get<1>(counts[j]))
+				{
+					std::get<2>(counts[kept-1]) += std::get<2>(counts[j]);
+					continue;
+				}
+				counts[kept] = counts[j];
+				kept += 1;
+			}
+			counts.resize(kept);
+			counts.shrink_to_fit();
+		}
+	});
+}
+
+std::pair<size_t, size_t> ConsensusMaker::getComplexCountRange(size_t unitig, size_t offset, size_t& cursor) const
+{
+	const std::vector<std::tuple<uint32_t, uint32_t, uint32_t>>& counts = complexCounts[unitig];
+	size_t start = cursor;
+	if (start > counts.size() || (start > 0 && std::get<0>(counts[start-1]) >= offset))
+	{
+		start = std::lower_bound(counts.begin(), counts.end(), std::make_tuple((uint32_t)offset, (uint32_t)0, (uint32_t)0)) - counts.begin();
+	}
+	while (start < counts.size() && std::get<0>(counts[start]) < offset) start += 1;
+	size_t end = start;
+	while (end < counts.size() && std::get<0>(counts[end]) == offset) end += 1;
+	cursor = end;
+	return std::make_pair(start, end);
 }
 
 void ConsensusMaker::addEdgeOverlap(std::pair<size_t, bool> from, std::pair<size_t, bool> to, size_t overlap)
@@ -152,100 +247,80 @@ void ConsensusMaker::prepareEdgeOverlap(std::pair<size_t, bool> from, std::pair<
 	}
 }
 
-std::pair<std::vector<CompressedSequenceType>, StringIndex> ConsensusMaker::getSequences()
+std::pair<std::vector<CompressedSequenceType>, StringIndex> ConsensusMaker::getSequences(const size_t numThreads)
 {
 	for (auto pair : needsComplementVerification)
 	{
 		auto found = find(pair.first, pair.second);
 		assert(complement(compressedSequences[std::get<0>(found)].get(std::get<1>(found))) == compressedSequences[std::get<0>(found)].get(std::get<1>(found)));
 	}
-	for (size_t i = 0; i < simpleCounts.size(); i++)
-	{
-		for (size_t j = 0; j < simpleCounts[i].size(); j++)
-		{
-			auto found = find(i, j);
-			size_t realI = std::get<0>(found);
-			size_t realJ = std::get<1>(found);
-			if (realI != i || realJ != j)
-			{
-				if (std::get<2>(found))
-				{
-					compressedSequences[i].set(j, compressedSequences[realI].get(realJ));
-				}
-				else
-				{
-					compressedSequences[i].set(j, complement(compressedSequences[realI].get(realJ)));
-				}
-			}
-			else
-			{
-				assert(std::get<2>(found));
-			}
-		}
-	}
-	stringIndex.buildReverseIndex();
+	copyCompressedFromParents(numThreads);
+	stringIndex.buildReverseIndex(numThreads);
+	mergeComplexCountLogs(numThreads);
 	std::vector<CompressedSequenceType> result;
 	result.resize(simpleCounts.size());
-	for (size_t i = 0; i < simpleCounts.size(); i++)
+	// unitigs only read the counts and the string index here, each writes only its own result
+	iterateChunksMultithreaded(simpleCounts.size(), numThreads, 64, [this, &result](size_t start, size_t end)
 	{
-		std::vector<uint8_t> simpleExpanded;
-		simpleExpanded.resize(simpleCounts[i].size(), 0);
-		result[i].setCompressedAndClearInputVectorAndResizeExpanded(compressedSequences[i]);
-		for (size_t j = 0; j < simpleCounts[i].size(); j++)
+		for (size_t i = start; i < end; i++)
 		{
-			auto found = find(i, j);
-			size_t realI = std::get<0>(found);
-			size_t realJ = std::get<1>(found);
-			size_t maxCount = simpleCounts[realI][realJ].second;
-			uint32_t maxIndex = simpleCounts[realI][realJ].first;
-			uint16_t compressed = result[i].getCompressed(j);
-			if (complexCounts.count(realI) == 1)
+			std::vector<uint8_t> simpleExpanded;
+			simpleExpanded.resize(simpleCounts[i].size(), 0);
+			result[i].setCompressedAndClearInputVectorAndResizeExpanded(compressedSequences[i]);
+			size_t complexCursor = 0;
+			for (size_t j = 0; j < simpleCounts[i].size(); j++)
 			{
-				if (complexCounts.at(realI).count(realJ) == 1)
+				auto found = find(i, j);
+				size_t realI = std::get<0>(found);
+				size_t realJ = std::get<1>(found);
+				std::pair<uint8_t, uint8_t> simpleCount = getSimpleCount(realI, realJ);
+				size_t maxCount = simpleCount.second;
+				uint32_t maxIndex = simpleCount.first;
+				uint16_t compressed = result[i].getCompressed(j);
+				size_t otherCursor = 0;
+				std::pair<size_t, size_t> complexRange = getComplexCountRange(realI, realJ, realI == i ? complexCursor : otherCursor);
+				for (size_t k = complexRange.first; k < complexRange.second; k++)
 				{
-					for (auto pair : complexCounts.at(realI).at(realJ))
+					uint32_t index = std::get<1>(complexCounts[realI][k]);
+					uint32_t count = std::get<2>(complexCounts[realI][k]);
+					if (index == simpleCount.first) count += (uint32_t)(simpleCount.second);
+					if (count < maxCount) continue;
+					if (count == maxCount)
 					{
-						uint32_t index = pair.first;
-						uint32_t count = pair.second;
-						if (index == simpleCounts[realI][realJ].first) count += (uint32_t)(simpleCounts[realI][realJ].second);
-						if (count < maxCount) continue;
-						if (count == maxCount)
+						if (std::get<2>(found))
 						{
-							if (std::get<2>(found))
-							{
-								if (stringIndex.getString(compressed, index) < stringIndex.getString(compressed, maxIndex)) continue;
-							}
-							else if (compressed == complement(compressed))
-							{
-								if (stringIndex.getString(compressed, index) < stringIndex.getString(compressed, maxIndex)) continue;
-							}
-							else
-							{
-								if (stringIndex.getString(complement(compressed), stringIndex.getReverseIndex(compressed, index)) < stringIndex.getString(complement(compressed), stringIndex.getReverseIndex(compressed, maxIndex))) continue;
-							}
+							if (stringIndex.getString(compressed, index) < stringIndex.getString(compressed, maxIndex)) continue;
+						}
+						else if (compressed == complement(compressed))
+						{
+							if (stringIndex.getString(compressed, index) < stringIndex.getString(compressed, maxIndex)) continue;
+						}
+						else
+						{
+							if (stringIndex.getString(complement(compressed), stringIndex.getReverseIndex(compressed, index)) < stringIndex.getString(complement(compressed), stringIndex.getReverseIndex(compressed, maxIndex))) continue;
 						}
-						maxIndex = index;
-						maxCount = count;
 					}
+					maxIndex = index;
+					maxCount = count;
 				}
-			}
-			if (!std::get<2>(found))
-			{
-				if (compressed == complement(compressed))
+				if (!std::get<2>(found))
 				{
-					maxIndex = stringIndex.getReverseIndex(compressed, maxIndex);
-				}
-				else
-				{
-					assert(maxIndex == stringIndex.getReverseIndex(compressed, maxIndex));
+					if (compressed == complement(compressed))
+					{
+						maxIndex = stringIndex.getReverseIndex(compressed, maxIndex);
+					}
+					else
+					{
+						assert(maxIndex == stringIndex.getReverseIndex(compressed, maxIndex));
+					}
 				}
+				assert(maxCount > 0);
+				assert(stringIndex.getString(compressed, maxIndex) != "");
+				result[i].setCompressed(j, compressed);
+				result[i].setExpanded(j, maxIndex);
 			}
-			assert(maxCount > 0);
-			assert(stringIndex.getString(compressed, maxIndex) != "");
-			result[i].setCompressed(j, compressed);
-			result[i].setExpanded(j, maxIndex);
 		}
-	}
+	});
 	assert(result.size() == compressedSequences.size());
 	return std::make_pair(std::move(result), stringIndex);
 }
@@ -444,44 +519,69 @@ void ConsensusMaker::findParentLinks()
 	}
 }
 
-void ConsensusMaker::prepareHpcVariants(const std::vector<bool>& checkUnitig)
+void ConsensusMaker::copyCompressedFromParents(const size_t numThreads)
 {
-	for (auto pair : needsComplementVerification)
-	{
-		auto found = find(pair.first, pair.second);
-		if (!checkUnitig[std::get<0>(found)]) continue;
-		assert(complement(compressedSequences[std::get<0>(found)].get(std::get<1>(found))) == compressedSequences[std::get<0>(found)].get(std::get<1>(found)));
-	}
-	for (size_t i = 0; i < simpleCounts.size(); i++)
+	// all positions are read before any is written, since the parent of a position can be in a unitig which another thread is writing
+	std::vector<std::vector<std::pair<size_t, uint16_t>>> copied;
+	copied.resize(simpleCounts.size());
+	iterateChunksMultithreaded(simpleCounts.size(), numThreads, 256, [this, &copied](size_t start, size_t end)
 	{
-		for (size_t j = 0; j < simpleCounts[i].size(); j++)
+		for (size_t i = start; i < end; i++)
 		{
-			auto found = find(i, j);
-			size_t realI = std::get<0>(found);
-			size_t realJ = std::get<1>(found);
-			if (realI != i || realJ != j)
+			for (size_t j = 0; j < simpleCounts[i].size(); j++)
 			{
-				if (std::get<2>(found))
+				auto found = find(i, j);
+				size_t realI = std::get<0>(found);
+				size_t realJ = std::get<1>(found);
+				if (realI != i || realJ != j)
 				{
-					compressedSequences[i].set(j, compressedSequences[realI].get(realJ));
+					if (std::get<2>(found))
+					{
+						copied[i].emplace_back(j, compressedSequences[realI].get(realJ));
+					}
+					else
+					{
+						copied[i].emplace_back(j, complement(compressedSequences[realI].get(realJ)));
+					}
 				}
 				else
 				{
-					compressedSequences[i].set(j, complement(compressedSequences[realI].get(realJ)));
+					assert(std::get<2>(found));
 				}
 			}
-			else
+		}
+	});
+	iterateChunksMultithreaded(simpleCounts.size(), numThreads, 256, [this, &copied](size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			for (auto pair : copied[i])
 			{
-				assert(std::get<2>(found));
+				compressedSequences[i].set(pair.first, pair.second);
 			}
+			std::vector<std::pair<size_t, uint16_t>> tmp;
+			std::swap(tmp, copied[i]);
 		}
+	});
+}
+
+void ConsensusMaker::prepareHpcVariants(const std::vector<bool>& checkUnitig, const size_t numThreads)
+{
+	for (auto pair : needsComplementVerification)
+	{
+		auto found = find(pair.first, pair.second);
+		if (!checkUnitig[std::get<0>(found)]) continue;
+		assert(complement(compressedSequences[std::get<0>(found)].get(std::get<1>(found))) == compressedSequences[std::get<0>(found)].get(std::get<1>(found)));
 	}
-	stringIndex.buildReverseIndex();
+	copyCompressedFromParents(numThreads);
+	stringIndex.buildReverseIndex(numThreads);
+	mergeComplexCountLogs(numThreads);
 }
 
 std::vector<std::pair<size_t, std::vector<size_t>>> ConsensusMaker::getHpcVariants(const size_t unitig, const size_t minCoverage)
 {
 	std::vector<std::pair<size_t, std::vector<size_t>>> result;
+	size_t complexCursor = 0;
 	for (size_t j = 0; j < simpleCounts[unitig].size(); j++)
 	{
 		auto found = find(unitig, j);
@@ -489,21 +589,18 @@ std::vector<std::pair<size_t, std::vector<size_t>>> ConsensusMaker::getHpcVarian
 		size_t realJ = std::get<1>(found);
 		uint16_t compressed = compressedSequences[unitig].get(j);
 		std::unordered_map<size_t, size_t> lengthCounts;
-		if (simpleCounts[realI][realJ].second > 0)
+		std::pair<uint8_t, uint8_t> simpleCount = getSimpleCount(realI, realJ);
+		if (simpleCount.second > 0)
 		{
-			lengthCounts[stringIndex.getString(compressed, simpleCounts[realI][realJ].first).size()] = simpleCounts[realI][realJ].second;
+			lengthCounts[stringIndex.getString(compressed, simpleCount.first).size()] = simpleCount.second;
 		}
-		if (complexCounts.count(realI) == 1)
+		size_t otherCursor = 0;
+		std::pair<size_t, size_t> complexRange = getComplexCountRange(realI, realJ, realI == unitig ? complexCursor : otherCursor);
+		for (size_t k = complexRange.first; k < complexRange.second; k++)
 		{
-			if (complexCounts.at(realI).count(realJ) == 1)
-			{
-				for (auto pair : complexCounts.at(realI).at(realJ))
-				{
-					uint32_t index = pair.first;
-					uint32_t count = pair.second;
-					lengthCounts[stringIndex.getString(compressed, index).size()] += count;
-				}
-			}
+			uint32_t index = std::get<1>(complexCounts[realI][k]);
+			uint32_t count = std::get<2>(complexCounts[realI][k]);
+			lengthCounts[stringIndex.getString(compressed, index).size()] += count;
 		}
 		std::vector<std::pair<size_t, size_t>> lengthCountsVec { lengthCounts.begin(), lengthCounts.end() };
 		std::sort(lengthCountsVec.begin(), lengthCountsVec.end(), [](const std::pair<size_t, size_t>& left, const std::pair<size_t, size_t>& right) { return left.first < right.first; });
@@ -4,11 +4,15 @@
 #include <vector>
 #include <string>
 #include <mutex>
+#include <atomic>
+#include <tuple>
 #include <cassert>
 #include <phmap.h>
 #include "MBGCommon.h"
 #include "StringIndex.h"
 #include "ErrorMaskHelper.h"
+#include "Validation.h"
+#include "ParallelHelper.h"
 
 class ConsensusMaker
 {
@@ -16,94 +20,108 @@ private:
 public:
 	~ConsensusMaker();
 	void init(const std::vector<size_t>& unitigLens);
-	std::pair<std::vector<CompressedSequenceType>, StringIndex> getSequences();
+	std::pair<std::vector<CompressedSequenceType>, StringIndex> getSequences(const size_t numThreads);
 	void findParentLinks();
+	// can be called from multiple threads at the same time
+	// the string index is locked per compressed code, simple counts are updated lock-free, complex counts go to the calling thread's log
+	// only the writes to compressedSequences lock the unitig
+	// sequenceGetter(i) returns (compressed, start, length) of the expanded sequence of unitig position unitigStart+i in rawSeq, reverse complemented if !rawFw
 	template <typename F>
-	void addStrings(size_t unitig, size_t unitigStart, size_t unitigEnd, F sequenceGetter)
+	void addStrings(size_t unitig, size_t unitigStart, size_t unitigEnd, const std::string& rawSeq, const bool rawFw, F sequenceGetter)
 	{
 		assert(unitig < simpleCounts.size());
 		assert(unitigEnd > unitigStart);
 		assert(unitigEnd <= simpleCounts[unitig].size());
-		std::vector<std::pair<uint16_t, uint32_t>> sequences;
+		std::vector<std::tuple<size_t, size_t, uint16_t, uint32_t>> sequences;
 		sequences.resize(unitigEnd - unitigStart);
-		{
-			std::lock_guard guard { stringIndexMutex };
-			for (size_t i = 0; i < unitigEnd - unitigStart; i++)
-			{
-				uint16_t compressed;
-				std::variant<size_t, std::string> expanded;
-				std::tie(compressed, expanded) = sequenceGetter(i);
-				uint32_t expandedIndex = stringIndex.getIndex(compressed, expanded);
-				sequences[i].first = compressed;
-				sequences[i].second = expandedIndex;
-			}
-		}
-		std::vector<std::tuple<size_t, size_t, size_t>> complexes;
-		size_t currentUnitig = std::numeric_limits<size_t>::max();
 		for (size_t i = 0; i < unitigEnd - unitigStart; i++)
 		{
-			uint16_t compressed = sequences[i].first;
-			size_t expandedIndex = sequences[i].second;
+			uint16_t compressed;
+			size_t expandedStart;
+			size_t expandedLength;
+			std::tie(compressed, expandedStart, expandedLength) = sequenceGetter(i);
+			uint32_t expandedIndex = getStringIndex(compressed, rawSeq, expandedStart, expandedLength, rawFw);
 			size_t off = unitigStart + i;
 			// no find because it might mutate parent, instead rely on parent being correct already
 			auto found = getParent(unitig, off);
-			assert(std::get<0>(getParent(std::get<0>(found), std::get<1>(found))) == std::get<0>(found));
-			assert(std::get<1>(getParent(std::get<0>(found), std::get<1>(found))) == std::get<1>(found));
-			size_t realUnitig = std::get<0>(found);
-			size_t realOff = std::get<1>(found);
+			assertFull(std::get<0>(getParent(std::get<0>(found), std::get<1>(found))) == std::get<0>(found));
+			assertFull(std::get<1>(getParent(std::get<0>(found), std::get<1>(found))) == std::get<1>(found));
 			if (!std::get<2>(found))
 			{
 				expandedIndex = stringIndex.getReverseIndex(compressed, expandedIndex); // thread safe so no lock
 				compressed = complement(compressed);
 			}
+			sequences[i] = std::make_tuple(std::get<0>(found), std::get<1>(found), compressed, expandedIndex);
+		}
+		size_t currentUnitig = std::numeric_limits<size_t>::max();
+		for (size_t i = 0; i < sequences.size(); i++)
+		{
+			size_t realUnitig = std::get<0>(sequences[i]);
+			size_t realOff = std::get<1>(sequences[i]);
+			uint16_t compressed = std::get<2>(sequences[i]);
 			if (realUnitig != currentUnitig)
 			{
 				if (currentUnitig != std::numeric_limits<size_t>::max()) simpleSequenceMutexes[currentUnitig]->unlock();
 				simpleSequenceMutexes[realUnitig]->lock();
 				currentUnitig = realUnitig;
 			}
-			assert(compressedSequences[realUnitig].get(realOff) == 0 || compressedSequences[realUnitig].get(realOff) == compressed);
+			assertCheap(compressedSequences[realUnitig].get(realOff) == 0 || compressedSequences[realUnitig].get(realOff) == compressed);
 			compressedSequences[realUnitig].set(realOff, compressed);
-			bool didSimple = false;
-			if (expandedIndex < 256)
-			{
-				if (simpleCounts[realUnitig][realOff].second == 0 || (expandedIndex == simpleCounts[realUnitig][realOff].first && simpleCounts[realUnitig][realOff].second < 255))
-				{
-					simpleCounts[realUnitig][realOff].first = expandedIndex;
-					simpleCounts[realUnitig][realOff].second += 1;
-					didSimple = true;
-				}
-			}
-			if (!didSimple)
-			{
-				complexes.emplace_back(realUnitig, realOff, expandedIndex);
-			}
 		}
 		if (currentUnitig != std::numeric_limits<size_t>::max()) simpleSequenceMutexes[currentUnitig]->unlock();
-		if (complexes.size() > 0)
+		std::vector<std::tuple<size_t, uint32_t, uint32_t, uint32_t>>* complexes = nullptr;
+		for (size_t i = 0; i < sequences.size(); i++)
 		{
-			std::lock_guard<std::mutex> guard { complexCountMutex };
-			for (auto tuple : complexes)
-			{
-				complexCounts[std::get<0>(tuple)][std::get<1>(tuple)][std::get<2>(tuple)] += 1;
-			}
+			size_t realUnitig = std::get<0>(sequences[i]);
+			size_t realOff = std::get<1>(sequences[i]);
+			uint32_t expandedIndex = std::get<3>(sequences[i]);
+			if (expandedIndex < 256 && addSimpleCount(simpleCounts[realUnitig][realOff], expandedIndex)) continue;
+			if (complexes == nullptr) complexes = &complexCountLogs.local();
+			if (complexes->size() == complexes->capacity() && complexes->size() >= 65536) compactComplexCountLog(*complexes);
+			complexes->emplace_back(realUnitig, (uint32_t)realOff, expandedIndex, 1);
 		}
 	}
 	void prepareEdgeOverlap(std::pair<size_t, bool> from, std::pair<size_t, bool> to, size_t overlap);
 	void addEdgeOverlap(std::pair<size_t, bool> from, std::pair<size_t, bool> to, size_t overlap);
-	void prepareHpcVariants(const std::vector<bool>& checkUnitig);
+	void prepareHpcVariants(const std::vector<bool>& checkUnitig, const size_t numThreads);
 	std::vector<std::pair<size_t, std::vector<size_t>>> getHpcVariants(const size_t unitig, const size_t minCoverage);
 	uint16_t getCompressed(const size_t unitig, const size_t offset) const;
 private:
+	uint32_t getStringIndex(uint16_t compressed, const std::string& raw, size_t start, size_t length, bool fw);
+	// simple counts are packed as (expandedIndex << 8) + count
+	// adds one to the count if the slot is empty or already has expandedIndex and isn't saturated, returns false if not counted
+	static bool addSimpleCount(std::atomic<uint16_t>& slot, uint32_t expandedIndex)
+	{
+		assert(expandedIndex < 256);
+		uint16_t old = slot.load(std::memory_order_relaxed);
+		while (true)
+		{
+			uint16_t count = old & 255;
+			if (count != 0 && ((uint32_t)(old >> 8) != expandedIndex || count == 255)) return false;
+			uint16_t replacement = (uint16_t)((expandedIndex << 8) + count + 1);
+			if (slot.compare_exchange_weak(old, replacement, std::memory_order_relaxed)) return true;
+		}
+	}
+	std::pair<uint8_t, uint8_t> getSimpleCount(size_t unitig, size_t offset) const;
+	// sorts a log of (unitig, offset, expandedIndex, count) and merges entries of the same position and string
+	static void compactComplexCountLog(std::vector<std::tuple<size_t, uint32_t, uint32_t, uint32_t>>& log);
+	void mergeComplexCountLogs(const size_t numThreads);
+	// sets the compressed codes of positions which have a parent elsewhere from the parent
+	void copyCompressedFromParents(const size_t numThreads);
+	// complexCounts[unitig][result.first, result.second) are the counts of offset
+	// cursor is where the previous lookup in the same unitig ended, so a unitig scanned in order is a linear merge
+	std::pair<size_t, size_t> getComplexCountRange(size_t unitig, size_t offset, size_t& cursor) const;
 	size_t unitigLength(size_t unitig) const;
 	std::tuple<size_t, size_t, bool> getParent(size_t unitig, size_t index) const;
 	std::tuple<size_t, size_t, bool> find(size_t unitig, size_t index);
 	StringIndex stringIndex;
-	std::vector<std::vector<std::pair<uint8_t, uint8_t>>> simpleCounts;
-	phmap::flat_hash_map<size_t, phmap::flat_hash_map<size_t, phmap::flat_hash_map<uint32_t, uint32_t>>> complexCounts;
+	std::vector<std::vector<std::atomic<uint16_t>>> simpleCounts;
+	// per unitig (offset, expandedIndex, count) sorted by offset and expandedIndex, built from the logs by mergeComplexCountLogs
+	std::vector<std::vector<std::tuple<uint32_t, uint32_t, uint32_t>>> complexCounts;
+	PerThreadBuffers<std::vector<std::tuple<size_t, uint32_t, uint32_t, uint32_t>>> complexCountLogs;
 	std::vector<std::mutex*> simpleSequenceMutexes;
-	std::mutex complexCountMutex;
-	std::mutex stringIndexMutex;
+	// indexed by the smaller of a code and its complement, since those share a string map
+	std::vector<std::mutex*> stringIndexMutexes;
 	std::vector<TwobitLittleBigVector<uint16_t>> compressedSequences;
 	std::vector<std::pair<size_t, size_t>> needsComplementVerification;
 	mutable std::vector<std::vector<std::tuple<size_t, size_t, size_t, size_t, bool>>> parent;
@@ -8,43 +8,17 @@
 
 void addCounts(ConsensusMaker& consensusMaker, const SequenceCharType& seq, const SequenceLengthType& poses, const std::string& rawSeq, const size_t seqStart, const size_t seqEnd, const size_t unitig, const size_t unitigStart, const size_t unitigEnd, const bool fw)
 {
-	consensusMaker.addStrings(unitig, unitigStart, unitigEnd, [seqStart, seqEnd, &consensusMaker, &seq, &poses, &rawSeq, fw](size_t i)
+	consensusMaker.addStrings(unitig, unitigStart, unitigEnd, rawSeq, fw, [seqStart, seqEnd, &seq, &poses, fw](size_t i)
 	{
 		size_t seqOff = seqStart + i;
 		if (!fw) seqOff = seqEnd - 1 - i;
 		assert(seqOff < seq.size());
 		uint16_t compressed = seq[seqOff];
 		if (!fw) compressed = complement(compressed);
-		std::variant<size_t, std::string> expanded;
-		if (fw)
-		{
-			size_t expandedStart = poses[seqOff];
-			size_t expandedEnd = poses[seqOff+1];
-			assert(expandedEnd > expandedStart);
-			if (compressed <= 3)
-			{
-				expanded = expandedEnd - expandedStart;
-			}
-			else
-			{
-				expanded = rawSeq.substr(expandedStart, expandedEnd - expandedStart);
-			}
-		}
-		else
-		{
-			size_t expandedStart = poses[seqOff];
-			size_t expandedEnd = poses[seqOff+1];
-			assert(expandedEnd > expandedStart);
-			if (compressed <= 3)
-			{
-				expanded = expandedEnd - expandedStart;
-			}
-			else
-			{
-				expanded = revCompRaw(rawSeq.substr(expandedStart, expandedEnd - expandedStart));
-			}
-		}
-		return std::make_pair(compressed, expanded);
+		size_t expandedStart = poses[seqOff];
+		size_t expandedEnd = poses[seqOff+1];
+		assert(expandedEnd > expandedStart);
+		return std::make_tuple(compressed, expandedStart, expandedEnd - expandedStart);
 	});
 }
 
@@ -296,25 +270,22 @@ void initializeHelpers(ConsensusMaker& consensusMaker, std::vector<size_t>& unit
 	consensusMaker.findParentLinks();
 }
 
-std::pair<std::vector<CompressedSequenceType>, StringIndex> getHPCUnitigSequences(const HashList& hashlist, const UnitigGraph& unitigs, std::vector<ReadPath>& readPaths, const size_t kmerSize, const ReadpartIterator& partIterator, const size_t numThreads)
+// getPathsOfRead(readName) returns the (index, path) pairs of the paths of a read part, the expanded read positions of the paths are set to readPaths at those indices
+template <typename PathContainer, typename F>
+std::pair<std::vector<CompressedSequenceType>, StringIndex> buildHPCUnitigSequences(const HashList& hashlist, const UnitigGraph& unitigs, PathContainer& readPaths, F getPathsOfRead, const size_t kmerSize, const ReadpartIterator& partIterator, const size_t numThreads)
 {
 	ConsensusMaker consensusMaker;
 	std::vector<size_t> unitigLengths;
 	std::vector<std::vector<size_t>> bpOffsets;
 	initializeHelpers(consensusMaker, unitigLengths, bpOffsets, hashlist, unitigs, kmerSize, partIterator, numThreads);
-	std::mutex expandedPosMutex;
-	std::unordered_map<ReadName, std::vector<size_t>> pathsPerRead;
-	for (size_t i = 0; i < readPaths.size(); i++)
+	partIterator.iterateParts([&consensusMaker, &readPaths, &getPathsOfRead, &hashlist, &unitigLengths, &unitigs, &bpOffsets, kmerSize](const ReadInfo& read, const SequenceCharType& seq, const SequenceLengthType& poses, const std::string& rawSeq)
 	{
-		pathsPerRead[readPaths[i].readName].push_back(i);
-	}
-	partIterator.iterateParts([&consensusMaker, &readPaths, &expandedPosMutex, &hashlist, &unitigLengths, &unitigs, &bpOffsets, &pathsPerRead, kmerSize](const ReadInfo& read, const SequenceCharType& seq, const SequenceLengthType& poses, const std::string& rawSeq)
-	{
-		if (pathsPerRead.count(read.readName) == 0) return;
+		std::vector<std::pair<size_t, ReadPath>> paths = getPathsOfRead(read.readName);
+		if (paths.size() == 0) return;
 		std::vector<std::tuple<size_t, size_t, size_t, size_t, bool, size_t, size_t>> matchBlocks;
-		for (size_t pathi : pathsPerRead.at(read.readName))
+		for (const auto& path : paths)
 		{
-			auto add = getMatchBlocks(bpOffsets, unitigs, readPaths[pathi], unitigLengths, kmerSize, pathi);
+			auto add = getMatchBlocks(bpOffsets, unitigs, path.second, unitigLengths, kmerSize, path.first);
 			matchBlocks.insert(matchBlocks.end(), add.begin(), add.end());
 		}
 		for (auto block : matchBlocks)
@@ -328,19 +299,46 @@ std::pair<std::vector<CompressedSequenceType>, StringIndex> getHPCUnitigSequence
 			if (std::get<5>(block) != std::numeric_limits<size_t>::max() || std::get<6>(block) != std::numeric_limits<size_t>::max())
 			{
 				assert(readStartPos + matchLength < poses.size());
-				std::lock_guard<std::mutex> lock { expandedPosMutex };
 				if (std::get<5>(block) != std::numeric_limits<size_t>::max())
 				{
-					readPaths[std::get<5>(block)].expandedReadPosStart = poses[readStartPos];
+					readPaths.setExpandedReadPosStart(std::get<5>(block), poses[readStartPos]);
 				}
 				if (std::get<6>(block) != std::numeric_limits<size_t>::max())
 				{
-					readPaths[std::get<6>(block)].expandedReadPosEnd = poses[readStartPos + matchLength];
+					readPaths.setExpandedReadPosEnd(std::get<6>(block), poses[readStartPos + matchLength]);
 				}
 			}
 		}
 	});
-	return consensusMaker.getSequences();
+	return consensusMaker.getSequences(numThreads);
+}
+
+std::pair<std::vector<CompressedSequenceType>, StringIndex> getHPCUnitigSequences(const HashList& hashlist, const UnitigGraph& unitigs, ReadPathStore& readPaths, const size_t kmerSize, const ReadpartIterator& partIterator, const size_t numThreads)
+{
+	std::unordered_map<ReadName, std::vector<size_t>> pathsPerRead;
+	for (size_t i = 0; i < readPaths.size(); i++)
+	{
+		pathsPerRead[readPaths.readName(i)].push_back(i);
+	}
+	return buildHPCUnitigSequences(hashlist, unitigs, readPaths, [&readPaths, &pathsPerRead](const ReadName& readName)
+	{
+		std::vector<std::pair<size_t, ReadPath>> result;
+		auto found = pathsPerRead.find(readName);
+		if (found == pathsPerRead.end()) return result;
+		for (size_t pathi : found->second)
+		{
+			result.emplace_back(pathi, readPaths.get(pathi));
+		}
+		return result;
+	}, kmerSize, partIterator, numThreads);
+}
+
+std::pair<std::vector<CompressedSequenceType>, StringIndex> getHPCUnitigSequences(const HashList& hashlist, const UnitigGraph& unitigs, SpilledReadPaths& readPaths, const size_t kmerSize, const ReadpartIterator& partIterator, const size_t numThreads)
+{
+	return buildHPCUnitigSequences(hashlist, unitigs, readPaths, [&readPaths](const ReadName& readName)
+	{
+		return readPaths.getPaths(readName);
+	}, kmerSize, partIterator, numThreads);
 }
 
 void getHpcVariantsAndReadPaths(const HashList& hashlist, const UnitigGraph& unitigs, const size_t kmerSize, ReadpartIterator& partIterator, const size_t numThreads, const double minUnitigCoverage, const size_t minVariantCoverage)
@@ -389,7 +387,7 @@ void getHpcVariantsAndReadPaths(const HashList& hashlist, const UnitigGraph& uni
 		nodeToHash[pair.second] = pair.first;
 		assert(nodeToHash[pair.second] != 0);
 	}
-	consensusMaker.prepareHpcVariants(checkUnitig);
+	consensusMaker.prepareHpcVariants(checkUnitig, numThreads);
 	for (size_t i = 0; i < unitigs.unitigs.size(); i++)
 	{
 		if (!checkUnitig[i]) continue;
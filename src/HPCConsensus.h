@@ -10,8 +10,10 @@
 #include "MBGCommon.h"
 #include "StringIndex.h"
 #include "UnitigResolver.h"
+#include "SpilledReadPaths.h"
 
-std::pair<std::vector<CompressedSequenceType>, StringIndex> getHPCUnitigSequences(const HashList& hash, const UnitigGraph& unitigs, std::vector<ReadPath>& readPaths, const size_t kmerSize, const ReadpartIterator& partIterator, const size_t numThreads);
+std::pair<std::vector<CompressedSequenceType>, StringIndex> getHPCUnitigSequences(const HashList& hash, const UnitigGraph& unitigs, ReadPathStore& readPaths, const size_t kmerSize, const ReadpartIterator& partIterator, const size_t numThreads);
+std::pair<std::vector<CompressedSequenceType>, StringIndex> getHPCUnitigSequences(const HashList& hash, const UnitigGraph& unitigs, SpilledReadPaths& readPaths, const size_t kmerSize, const ReadpartIterator& partIterator, const size_t numThreads);
 void getHpcVariantsAndReadPaths(const HashList& hash, const UnitigGraph& unitigs, const size_t kmerSize, ReadpartIterator& partIterator, const size_t numThreads, const double minUnitigCoverage, const size_t minVariantCoverage);
 
 #endif
@@ -2,6 +2,7 @@
 #include <thread>
 #include <chrono>
 #include "HashList.h"
+#include "ParallelHelper.h"
 
 HashList::HashList(size_t kmerSize) :
 	kmerSize(kmerSize)
@@ -242,114 +243,143 @@ std::pair<size_t, bool> HashList::getHashNode(HashType fwHash) const
 	return result;
 }
 
-std::vector<size_t> HashList::sortByHash()
+// parallel MSD radix pass on the top bits of the hashes, then a comparison sort within each bucket
+void radixSortHashes(std::vector<std::pair<HashType, size_t>>& items, const size_t numThreads)
 {
-	std::vector<HashType> hashes;
-	hashes.reserve(hashToNode.size());
-	for (auto pair : hashToNode)
+	const size_t bucketBits = 16;
+	const size_t numBuckets = (size_t)1 << bucketBits;
+	const size_t bucketShift = sizeof(HashType) * 8 - bucketBits;
+	const size_t numRanges = getNumRanges(items.size(), numThreads);
+	std::vector<std::vector<size_t>> bucketPositions;
+	bucketPositions.resize(numRanges);
+	iterateRangesMultithreaded(items.size(), numThreads, [&items, &bucketPositions, numBuckets, bucketShift](size_t range, size_t start, size_t end)
 	{
-		hashes.emplace_back(pair.first);
-	}
-	std::sort(hashes.begin(), hashes.end());
-	std::vector<size_t> mapping;
-	mapping.resize(hashes.size(), std::numeric_limits<size_t>::max());
-	for (size_t i = 0; i < hashes.size(); i++)
+		bucketPositions[range].resize(numBuckets, 0);
+		for (size_t i = start; i < end; i++)
+		{
+			bucketPositions[range][(size_t)(items[i].first >> bucketShift)] += 1;
+		}
+	});
+	std::vector<size_t> bucketStart;
+	bucketStart.resize(numBuckets+1, 0);
+	size_t pos = 0;
+	for (size_t bucket = 0; bucket < numBuckets; bucket++)
 	{
-		assert(mapping[hashToNode.at(hashes[i])] == std::numeric_limits<size_t>::max());
-		mapping[hashToNode.at(hashes[i])] = i;
+		bucketStart[bucket] = pos;
+		for (size_t range = 0; range < numRanges; range++)
+		{
+			size_t count = bucketPositions[range][bucket];
+			bucketPositions[range][bucket] = pos;
+			pos += count;
+		}
 	}
-	for (size_t i = 0; i < hashes.size(); i++)
+	bucketStart[numBuckets] = pos;
+	assert(pos == items.size());
+	std::vector<std::pair<HashType, size_t>> sorted;
+	sorted.resize(items.size());
+	iterateRangesMultithreaded(items.size(), numThreads, [&items, &sorted, &bucketPositions, bucketShift](size_t range, size_t start, size_t end)
 	{
-		assert(mapping[i] != std::numeric_limits<size_t>::max());
-		assert(mapping[i] < hashes.size());
-	}
+		std::vector<size_t>& positions = bucketPositions[range];
+		for (size_t i = start; i < end; i++)
+		{
+			size_t bucket = (size_t)(items[i].first >> bucketShift);
+			sorted[positions[bucket]] = items[i];
+			positions[bucket] += 1;
+		}
+	});
+	// canonical hashes are the smaller of two hashes so the low buckets are fuller, hand out buckets in small chunks
+	iterateChunksMultithreaded(numBuckets, numThreads, 256, [&sorted, &bucketStart](size_t start, size_t end)
 	{
-		std::vector<bool> newTipKmer;
-		newTipKmer.resize(tipKmer.size());
-		for (size_t i = 0; i < tipKmer.size(); i++)
+		for (size_t bucket = start; bucket < end; bucket++)
 		{
-			newTipKmer[mapping[i]] = tipKmer[i];
+			std::sort(sorted.begin() + bucketStart[bucket], sorted.begin() + bucketStart[bucket+1]);
 		}
-		std::swap(tipKmer, newTipKmer);
+	});
+	std::swap(items, sorted);
+}
+
+std::vector<HashType> HashList::getHashes() const
+{
+	std::vector<HashType> result;
+	result.resize(size());
+	assert(hashToNode.size() == size());
+	for (auto pair : hashToNode)
+	{
+		result[pair.second] = pair.first;
 	}
+	return result;
+}
+
+void HashList::renumber(const std::vector<size_t>& mapping, const size_t numThreads)
+{
+	assert(mapping.size() == size());
+	assert(tipKmer.size() == size());
+	assert(coverage.size() == size());
+	std::vector<size_t> inverse;
+	inverse.resize(mapping.size(), std::numeric_limits<size_t>::max());
+	iterateRangesMultithreaded(mapping.size(), numThreads, [&mapping, &inverse](size_t range, size_t start, size_t end)
 	{
-		phmap::flat_hash_map<HashType, size_t> newHashToNode;
-		for (size_t i = 0; i < hashes.size(); i++)
+		for (size_t i = start; i < end; i++)
 		{
-			newHashToNode[hashes[i]] = i;
+			inverse[mapping[i]] = i;
 		}
-		std::swap(hashToNode, newHashToNode);
-	}
+	});
+	// the hash index can't be split between threads, update it in its own thread while the others permute the vectors
+	std::thread hashToNodeThread { [this, &mapping]()
 	{
-		LittleBigVector<uint8_t, size_t> newCoverage;
-		newCoverage.resize(coverage.size());
-		for (size_t i = 0; i < coverage.size(); i++)
+		for (auto& pair : hashToNode)
 		{
-			newCoverage.set(mapping[i], coverage.get(i));
+			pair.second = mapping[pair.second];
 		}
-		std::swap(coverage, newCoverage);
-	}
+	}};
 	{
-		MostlySparse2DHashmap<uint8_t, size_t> newEdgeCoverage;
-		newEdgeCoverage.resize(edgeCoverage.size());
-		for (size_t i = 0; i < edgeCoverage.size(); i++)
+		std::vector<bool> newTipKmer;
+		newTipKmer.resize(tipKmer.size());
+		// bits are packed in words, each thread must write whole words
+		iterateRangesMultithreaded((tipKmer.size() + 63) / 64, numThreads, [this, &newTipKmer, &inverse](size_t range, size_t start, size_t end)
 		{
-			auto values = edgeCoverage.getValues(std::make_pair(i, true));
-			for (auto value : values)
-			{
-				std::pair<size_t, bool> from = std::make_pair(i, true);
-				std::pair<size_t, bool> to = value.first;
-				from.first = mapping[from.first];
-				to.first = mapping[to.first];
-				size_t coverage = value.second;
-				auto key = canon(from, to);
-				newEdgeCoverage.set(key.first, key.second, coverage);
-			}
-			values = edgeCoverage.getValues(std::make_pair(i, false));
-			for (auto value : values)
+			for (size_t i = start * 64; i < end * 64 && i < newTipKmer.size(); i++)
 			{
-				std::pair<size_t, bool> from = std::make_pair(i, false);
-				std::pair<size_t, bool> to = value.first;
-				from.first = mapping[from.first];
-				to.first = mapping[to.first];
-				size_t coverage = value.second;
-				auto key = canon(from, to);
-				newEdgeCoverage.set(key.first, key.second, coverage);
+				newTipKmer[i] = tipKmer[inverse[i]];
 			}
-		}
-		std::swap(edgeCoverage, newEdgeCoverage);
+		});
+		std::swap(tipKmer, newTipKmer);
 	}
 	{
-		MostlySparse2DHashmap<uint16_t, size_t> newSequenceOverlap;
-		newSequenceOverlap.resize(sequenceOverlap.size());
-		for (size_t i = 0; i < sequenceOverlap.size(); i++)
+		LittleBigVector<uint8_t, size_t> newCoverage;
+		newCoverage.resize(coverage.size());
+		// setting a little value only writes its own element, big values go to a hashmap and are set after the threads are done
+		std::vector<std::vector<std::pair<size_t, size_t>>> bigCoverages;
+		bigCoverages.resize(getNumRanges(coverage.size(), numThreads));
+		iterateRangesMultithreaded(coverage.size(), numThreads, [this, &newCoverage, &bigCoverages, &inverse](size_t range, size_t start, size_t end)
 		{
-			auto values = sequenceOverlap.getValues(std::make_pair(i, true));
-			for (auto value : values)
+			for (size_t i = start; i < end; i++)
 			{
-				std::pair<size_t, bool> from = std::make_pair(i, true);
-				std::pair<size_t, bool> to = value.first;
-				from.first = mapping[from.first];
-				to.first = mapping[to.first];
-				size_t overlap = value.second;
-				auto key = canon(from, to);
-				newSequenceOverlap.set(key.first, key.second, overlap);
+				size_t value = coverage.get(inverse[i]);
+				if (value > (size_t)std::numeric_limits<uint8_t>::max())
+				{
+					bigCoverages[range].emplace_back(i, value);
+					continue;
+				}
+				newCoverage.set(i, value);
 			}
-			values = sequenceOverlap.getValues(std::make_pair(i, false));
-			for (auto value : values)
+		});
+		for (size_t range = 0; range < bigCoverages.size(); range++)
+		{
+			for (auto pair : bigCoverages[range])
 			{
-				std::pair<size_t, bool> from = std::make_pair(i, false);
-				std::pair<size_t, bool> to = value.first;
-				from.first = mapping[from.first];
-				to.first = mapping[to.first];
-				size_t overlap = value.second;
-				auto key = canon(from, to);
-				newSequenceOverlap.set(key.first, key.second, overlap);
+				newCoverage.set(pair.first, pair.second);
 			}
 		}
-		std::swap(sequenceOverlap, newSequenceOverlap);
+		std::swap(coverage, newCoverage);
 	}
-	return mapping;
+	auto remapKey = [&mapping](std::pair<size_t, bool> from, std::pair<size_t, bool> to)
+	{
+		return canon(std::make_pair(mapping[from.first], from.second), std::make_pair(mapping[to.first], to.second));
+	};
+	edgeCoverage = edgeCoverage.renumbered(remapKey, numThreads);
+	sequenceOverlap = sequenceOverlap.renumbered(remapKey, numThreads);
+	hashToNodeThread.join();
 }
 
 void HashList::clear()
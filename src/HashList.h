@@ -35,7 +35,10 @@ public:
 	std::pair<size_t, bool> addNode(HashType fwHash);
 	void filter(const RankBitvector& kept);
 	std::pair<size_t, bool> getHashNode(HashType hash) const;
-	std::vector<size_t> sortByHash();
+	// hash of each k-mer, indexed by k-mer id
+	std::vector<HashType> getHashes() const;
+	// mapping[oldId] = newId, must be a permutation
+	void renumber(const std::vector<size_t>& mapping, const size_t numThreads);
 	void clear();
 	LittleBigVector<uint8_t, size_t> coverage;
 	phmap::flat_hash_map<HashType, size_t> hashToNode;
@@ -47,4 +50,7 @@ private:
 	size_t kmerSize;
 };
 
+// sorts (hash, id) pairs by hash, hashes must be distinct
+void radixSortHashes(std::vector<std::pair<HashType, size_t>>& items, const size_t numThreads);
+
 #endif
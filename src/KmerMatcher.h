@@ -6,6 +6,7 @@
 #include "HashList.h"
 #include "UnitigGraph.h"
 #include "UnitigResolver.h"
+#include "Validation.h"
 
 std::vector<std::tuple<size_t, size_t, bool>> getKmerLocator(const UnitigGraph& graph);
 
@@ -24,7 +25,7 @@ void iterateReadPaths(const UnitigGraph& graph, const HashList& hashlist, const
 	{
 		const size_t readPos = positions[i];
 		const HashType fwHash = hashes[i];
-		assert(readPos + kmerSize <= read.readLengthHpc);
+		assertCheap(readPos + kmerSize <= read.readLengthHpc);
 		std::pair<size_t, bool> kmer = hashlist.getNodeOrNull(fwHash);
 		if (kmer.first == std::numeric_limits<size_t>::max()) continue;
 		if (kmer.first >= kmerLocator.size() || std::get<0>(kmerLocator[kmer.first]) == std::numeric_limits<size_t>::max())
@@ -35,6 +36,7 @@ void iterateReadPaths(const UnitigGraph& graph, const HashList& hashlist, const
 				callback(current);
 			}
 			current.path.clear();
+			current.readPoses.clear();
 			current.readName = read.readName;
 			current.readLength = read.readLength;
 			current.readLengthHPC = read.readLengthHpc;
@@ -104,7 +106,7 @@ void iterateReadPaths(const UnitigGraph& graph, const HashList& hashlist, const
 		}
 		std::pair<size_t, bool> fromEdge { std::get<0>(lastPos), std::get<2>(lastPos) };
 		std::pair<size_t, bool> toEdge { std::get<0>(pos), std::get<2>(pos) };
-		assert(graph.edges.hasEdge(fromEdge, toEdge) == graph.edges.hasEdge(reverse(toEdge), reverse(fromEdge)));
+		assertFull(graph.edges.hasEdge(fromEdge, toEdge) == graph.edges.hasEdge(reverse(toEdge), reverse(fromEdge)));
 		if (graph.edges.hasEdge(fromEdge, toEdge) == 1 && std::get<1>(pos) == 0 && std::get<1>(lastPos) == graph.unitigs[std::get<0>(lastPos)].size()-1)
 		{
 			assert(current.rightClip == 0);
@@ -2,6 +2,7 @@
 #define LittleBigVector_h
 
 #include <cassert>
+#include <cstdint>
 #include <limits>
 #include <vector>
 #include <phmap.h>
@@ -13,32 +14,42 @@ class LittleBigVector
 public:
 	void resize(size_t size)
 	{
+		if (size < littles.size()) eraseBigsFrom(size);
 		littles.resize(size);
+		bigMask.resize((size+63)/64, 0);
 	}
 	void resize(size_t size, BigType v)
 	{
 		assert(v <= (BigType)std::numeric_limits<LittleType>::max());
+		if (size < littles.size()) eraseBigsFrom(size);
 		littles.resize(size, (LittleType)v);
+		bigMask.resize((size+63)/64, 0);
 	}
 	BigType get(size_t i) const
 	{
-		auto found = bigs.find(i);
-		if (found != bigs.end()) return found->second;
+		if (isBig(i)) return bigs.at(i);
 		return littles[i];
 	}
+	// setting a little value only writes littles[i] unless i held a big value,
+	// so little values can be set from multiple threads when no big values are set or removed at the same time
 	void set(size_t i, BigType v)
 	{
 		if (v <= (BigType)std::numeric_limits<LittleType>::max())
 		{
-			auto found = bigs.find(i);
-			if (found != bigs.end()) bigs.erase(found);
+			if (isBig(i))
+			{
+				bigs.erase(i);
+				bigMask[i / 64] &= ~((uint64_t)1 << (uint64_t)(i % 64));
+			}
 			littles[i] = (LittleType)v;
 			return;
 		}
 		bigs[i] = v;
+		bigMask[i / 64] |= (uint64_t)1 << (uint64_t)(i % 64);
 	}
 	void emplace_back(BigType v)
 	{
+		if (littles.size() == bigMask.size() * 64) bigMask.emplace_back(0);
 		if (v <= (BigType)std::numeric_limits<LittleType>::max())
 		{
 			littles.emplace_back((LittleType)v);
@@ -52,7 +63,26 @@ public:
 		return littles.size();
 	}
 private:
+	bool isBig(size_t i) const
+	{
+		return (bigMask[i / 64] >> (uint64_t)(i % 64)) & 1;
+	}
+	void eraseBigsFrom(size_t size)
+	{
+		std::vector<uint32_t> removed;
+		for (auto pair : bigs)
+		{
+			if (pair.first >= size) removed.push_back(pair.first);
+		}
+		for (auto index : removed)
+		{
+			bigs.erase(index);
+			bigMask[index / 64] &= ~((uint64_t)1 << (uint64_t)(index % 64));
+		}
+	}
 	std::vector<LittleType> littles;
+	// bit i is set if element i is in bigs, so reading a little value doesn't probe the hashmap
+	std::vector<uint64_t> bigMask;
 	phmap::flat_hash_map<uint32_t, BigType> bigs;
 };
 
@@ -10,6 +10,7 @@
 #include <cstdint>
 #include <phmap.h>
 #include <thread>
+#include <memory>
 #include "fastqloader.h"
 #include "CommonUtils.h"
 #include "MBGCommon.h"
@@ -17,6 +18,8 @@
 #include "VectorWithDirection.h"
 #include "FastHasher.h"
 #include "SparseEdgeContainer.h"
+#include "CompactEdgeContainer.h"
+#include "ParallelHelper.h"
 #include "HashList.h"
 #include "UnitigGraph.h"
 #include "BluntGraph.h"
@@ -27,9 +30,12 @@
 #include "StringIndex.h"
 #include "RankBitvector.h"
 #include "UnitigResolver.h"
+#include "ReadPathStore.h"
+#include "SpilledReadPaths.h"
 #include "UnitigHelper.h"
 #include "DumbSelect.h"
 #include "KmerMatcher.h"
+#include "Validation.h"
 
 struct AssemblyStats
 {
@@ -112,197 +118,155 @@ void updatePathRemaining(size_t& rleRemaining, size_t& expanded, bool fw, const
 	}
 }
 
-void writePaths(const HashList& hashlist, const UnitigGraph& unitigs, const std::vector<CompressedSequenceType>& unitigSequences, const StringIndex& stringIndex, const std::vector<DumbSelect>& unitigExpandedPoses, const std::vector<ReadPath>& readPaths, const size_t kmerSize, const std::string& outputSequencePaths, const std::string& nodeNamePrefix)
+void writePath(std::ostream& outPaths, const HashList& hashlist, const UnitigGraph& unitigs, const std::vector<DumbSelect>& unitigExpandedPoses, const ReadPath& path, const ReadNameDictionary& readNames, const size_t kmerSize, const std::string& nodeNamePrefix)
 {
-	std::ofstream outPaths { outputSequencePaths };
-	for (const auto& path : readPaths)
-	{
-		if (path.path.size() == 0) continue;
-		size_t readLength = path.readLength;
-		size_t readStart = path.expandedReadPosStart;
-		size_t readEnd = path.expandedReadPosEnd;
-		assert(readEnd > readStart);
-		assert(readEnd <= readLength);
-		std::string pathStr;
-		std::vector<std::pair<size_t, bool>> kmerPath;
-		for (size_t i = 0; i < path.path.size(); i++)
-		{
-			size_t skip = 0;
-			if (i > 0) skip = unitigs.edgeOverlap(path.path[i-1], path.path[i]);
-			for (size_t j = skip; j < unitigs.unitigs[path.path[i].id()].size(); j++)
+	size_t readLength = path.readLength;
+	size_t readStart = path.expandedReadPosStart;
+	size_t readEnd = path.expandedReadPosEnd;
+	assert(readEnd > readStart);
+	assert(readEnd <= readLength);
+	std::string pathStr;
+	std::vector<std::pair<size_t, bool>> kmerPath;
+	for (size_t i = 0; i < path.path.size(); i++)
+	{
+		size_t skip = 0;
+		if (i > 0) skip = unitigs.edgeOverlap(path.path[i-1], path.path[i]);
+		for (size_t j = skip; j < unitigs.unitigs[path.path[i].id()].size(); j++)
+		{
+			if (!path.path[i].forward())
 			{
-				if (!path.path[i].forward())
-				{
-					kmerPath.push_back(reverse(unitigs.unitigs[path.path[i].id()][unitigs.unitigs[path.path[i].id()].size() - 1 - j]));
-				}
-				else
-				{
-					kmerPath.push_back(unitigs.unitigs[path.path[i].id()][j]);
-				}
+				kmerPath.push_back(reverse(unitigs.unitigs[path.path[i].id()][unitigs.unitigs[path.path[i].id()].size() - 1 - j]));
 			}
-		}
-		size_t pathLengthRLE = 0;
-		for (size_t i = 0; i < kmerPath.size(); i++)
-		{
-			pathLengthRLE += kmerSize;
-			if (i > 0) pathLengthRLE -= hashlist.getOverlap(kmerPath[i-1], kmerPath[i]);
-		}
-		size_t pathLeftClipRLE = 0;
-		for (size_t i = 0; i < path.leftClip; i++)
-		{
-			pathLeftClipRLE += kmerSize - hashlist.getOverlap(kmerPath[i], kmerPath[i+1]);
-		}
-		size_t pathRightClipRLE = 0;
-		for (size_t i = 0; i < path.rightClip; i++)
-		{
-			pathRightClipRLE += kmerSize - hashlist.getOverlap(kmerPath[kmerPath.size()-2-i], kmerPath[kmerPath.size()-1-i]);
-		}
-		size_t pathUnitigLeftClipRLE = path.path[0].forward() ? unitigs.leftClip[path.path[0].id()] : unitigs.rightClip[path.path[0].id()];
-		size_t pathUnitigRightClipRLE = path.path.back().forward() ? unitigs.rightClip[path.path.back().id()] : unitigs.leftClip[path.path.back().id()];
-		assert(pathLengthRLE > pathUnitigRightClipRLE + pathUnitigLeftClipRLE);
-		pathLengthRLE -= pathUnitigLeftClipRLE + pathUnitigRightClipRLE;
-		size_t readLeftClip = 0;
-		size_t readRightClip = 0;
-		if (pathLeftClipRLE > pathUnitigLeftClipRLE)
-		{
-			pathLeftClipRLE -= pathUnitigLeftClipRLE;
-		}
-		else
-		{
-			readLeftClip = pathUnitigLeftClipRLE - pathLeftClipRLE;
-			pathLeftClipRLE = 0;
-		}
-		if (pathRightClipRLE > pathUnitigRightClipRLE)
-		{
-			pathRightClipRLE -= pathUnitigRightClipRLE;
-		}
-		else
-		{
-			readRightClip = pathUnitigRightClipRLE - pathRightClipRLE;
-			pathRightClipRLE = 0;
-		}
-		for (size_t i = 0; i < path.path.size(); i++)
-		{
-			pathStr += (path.path[i].forward() ? ">" : "<");
-			pathStr += nodeNamePrefix;
-			pathStr += std::to_string(path.path[i].id()+1);
-		}
-		assert(readEnd - readStart > readRightClip + readLeftClip);
-		// todo fix: readLeftClip and readRightClip are rle, readStart and readEnd are not
-		readStart += readLeftClip;
-		readEnd -= readRightClip;
-		assert(pathLengthRLE >= kmerSize);
-		assert(pathLeftClipRLE + pathRightClipRLE < pathLengthRLE);
-		size_t pathStartExpanded = 0;
-		size_t pathEndExpanded = 0;
-		size_t pathLengthExpanded = 0;
-		size_t startRemaining = pathLeftClipRLE;
-		size_t endRemaining = pathLengthRLE - pathRightClipRLE;
-		size_t lenRemaining = pathLengthRLE;
-		for (size_t i = 0; i < path.path.size(); i++)
-		{
-			size_t overlap = 0;
-			if (i > 0)
+			else
 			{
-				overlap = getUnitigOverlap(hashlist, kmerSize, unitigs, path.path[i-1], path.path[i]);
+				kmerPath.push_back(unitigs.unitigs[path.path[i].id()][j]);
 			}
-			updatePathRemaining(startRemaining, pathStartExpanded, path.path[i].forward(), unitigExpandedPoses[path.path[i].id()], overlap);
-			updatePathRemaining(endRemaining, pathEndExpanded, path.path[i].forward(), unitigExpandedPoses[path.path[i].id()], overlap);
-			updatePathRemaining(lenRemaining, pathLengthExpanded, path.path[i].forward(), unitigExpandedPoses[path.path[i].id()], overlap);
-		}
-		assert(startRemaining == std::numeric_limits<size_t>::max());
-		assert(endRemaining == std::numeric_limits<size_t>::max());
-		assert(lenRemaining == std::numeric_limits<size_t>::max());
-		assert(pathLeftClipRLE == 0 || pathStartExpanded != 0);
-		assert(pathEndExpanded != 0);
-		assert(pathLengthExpanded != 0);
-		assert(pathEndExpanded > pathStartExpanded);
-		assert(pathEndExpanded <= pathLengthExpanded);
-		assert(pathLengthExpanded >= pathLengthRLE);
-		size_t mapq = 60;
-		outPaths << path.readName.first << "\t" << readLength << "\t" << readStart << "\t" << readEnd << "\t+\t" << pathStr << "\t" << pathLengthExpanded << "\t" << pathStartExpanded << "\t" << pathEndExpanded << "\t" << (pathEndExpanded - pathStartExpanded) << "\t" << (pathEndExpanded - pathStartExpanded) << "\t" << mapq << std::endl;
+		}
+	}
+	size_t pathLengthRLE = 0;
+	for (size_t i = 0; i < kmerPath.size(); i++)
+	{
+		pathLengthRLE += kmerSize;
+		if (i > 0) pathLengthRLE -= hashlist.getOverlap(kmerPath[i-1], kmerPath[i]);
+	}
+	size_t pathLeftClipRLE = 0;
+	for (size_t i = 0; i < path.leftClip; i++)
+	{
+		pathLeftClipRLE += kmerSize - hashlist.getOverlap(kmerPath[i], kmerPath[i+1]);
 	}
+	size_t pathRightClipRLE = 0;
+	for (size_t i = 0; i < path.rightClip; i++)
+	{
+		pathRightClipRLE += kmerSize - hashlist.getOverlap(kmerPath[kmerPath.size()-2-i], kmerPath[kmerPath.size()-1-i]);
+	}
+	size_t pathUnitigLeftClipRLE = path.path[0].forward() ? unitigs.leftClip[path.path[0].id()] : unitigs.rightClip[path.path[0].id()];
+	size_t pathUnitigRightClipRLE = path.path.back().forward() ? unitigs.rightClip[path.path.back().id()] : unitigs.leftClip[path.path.back().id()];
+	assert(pathLengthRLE > pathUnitigRightClipRLE + pathUnitigLeftClipRLE);
+	pathLengthRLE -= pathUnitigLeftClipRLE + pathUnitigRightClipRLE;
+	size_t readLeftClip = 0;
+	size_t readRightClip = 0;
+	if (pathLeftClipRLE > pathUnitigLeftClipRLE)
+	{
+		pathLeftClipRLE -= pathUnitigLeftClipRLE;
+	}
+	else
+	{
+		readLeftClip = pathUnitigLeftClipRLE - pathLeftClipRLE;
+		pathLeftClipRLE = 0;
+	}
+	if (pathRightClipRLE > pathUnitigRightClipRLE)
+	{
+		pathRightClipRLE -= pathUnitigRightClipRLE;
+	}
+	else
+	{
+		readRightClip = pathUnitigRightClipRLE - pathRightClipRLE;
+		pathRightClipRLE = 0;
+	}
+	for (size_t i = 0; i < path.path.size(); i++)
+	{
+		pathStr += (path.path[i].forward() ? ">" : "<");
+		pathStr += nodeNamePrefix;
+		pathStr += std::to_string(path.path[i].id()+1);
+	}
+	assert(readEnd - readStart > readRightClip + readLeftClip);
+	// todo fix: readLeftClip and readRightClip are rle, readStart and readEnd are not
+	readStart += readLeftClip;
+	readEnd -= readRightClip;
+	assert(pathLengthRLE >= kmerSize);
+	assert(pathLeftClipRLE + pathRightClipRLE < pathLengthRLE);
+	size_t pathStartExpanded = 0;
+	size_t pathEndExpanded = 0;
+	size_t pathLengthExpanded = 0;
+	size_t startRemaining = pathLeftClipRLE;
+	size_t endRemaining = pathLengthRLE - pathRightClipRLE;
+	size_t lenRemaining = pathLengthRLE;
+	for (size_t i = 0; i < path.path.size(); i++)
+	{
+		size_t overlap = 0;
+		if (i > 0)
+		{
+			overlap = getUnitigOverlap(hashlist, kmerSize, unitigs, path.path[i-1], path.path[i]);
+		}
+		updatePathRemaining(startRemaining, pathStartExpanded, path.path[i].forward(), unitigExpandedPoses[path.path[i].id()], overlap);
+		updatePathRemaining(endRemaining, pathEndExpanded, path.path[i].forward(), unitigExpandedPoses[path.path[i].id()], overlap);
+		updatePathRemaining(lenRemaining, pathLengthExpanded, path.path[i].forward(), unitigExpandedPoses[path.path[i].id()], overlap);
+	}
+	assert(startRemaining == std::numeric_limits<size_t>::max());
+	assert(endRemaining == std::numeric_limits<size_t>::max());
+	assert(lenRemaining == std::numeric_limits<size_t>::max());
+	assert(pathLeftClipRLE == 0 || pathStartExpanded != 0);
+	assert(pathEndExpanded != 0);
+	assert(pathLengthExpanded != 0);
+	assert(pathEndExpanded > pathStartExpanded);
+	assert(pathEndExpanded <= pathLengthExpanded);
+	assert(pathLengthExpanded >= pathLengthRLE);
+	size_t mapq = 60;
+	readNames.writeName(outPaths, path.readName.first);
+	outPaths << "\t" << readLength << "\t" << readStart << "\t" << readEnd << "\t+\t" << pathStr << "\t" << pathLengthExpanded << "\t" << pathStartExpanded << "\t" << pathEndExpanded << "\t" << (pathEndExpanded - pathStartExpanded) << "\t" << (pathEndExpanded - pathStartExpanded) << "\t" << mapq << std::endl;
 }
 
-void startUnitig(UnitigGraph& result, const UnitigGraph& old, std::pair<size_t, bool> start, const VectorWithDirection<std::unordered_set<std::pair<size_t, bool>>>& edges, std::vector<std::pair<size_t, bool>>& belongsToUnitig, VectorWithDirection<bool>& unitigStart, VectorWithDirection<bool>& unitigEnd)
+void writePaths(const HashList& hashlist, const UnitigGraph& unitigs, const std::vector<CompressedSequenceType>& unitigSequences, const StringIndex& stringIndex, const std::vector<DumbSelect>& unitigExpandedPoses, const ReadPathStore& readPaths, const ReadNameDictionary& readNames, const size_t kmerSize, const std::string& outputSequencePaths, const std::string& nodeNamePrefix)
 {
-	size_t currentUnitig = result.unitigs.size();
-	result.unitigs.emplace_back();
-	result.unitigCoverage.emplace_back();
-	result.edges.emplace_back();
-	result.edgeCov.emplace_back();
-	result.edgeOvlp.emplace_back();
-	result.leftClip.emplace_back(0);
-	result.rightClip.emplace_back(0);
-	assert(old.leftClip[start.first] == 0);
-	assert(old.rightClip[start.first] == 0);
-	std::pair<size_t, bool> pos = start;
-	unitigStart[start] = true;
-	unitigEnd[reverse(start)] = true;
-	assert(belongsToUnitig.at(pos.first).first == std::numeric_limits<size_t>::max());
-	belongsToUnitig[pos.first] = std::make_pair(currentUnitig, pos.second);
-	if (pos.second)
-	{
-		result.unitigs.back().insert(result.unitigs.back().end(), old.unitigs[pos.first].begin(), old.unitigs[pos.first].end());
-		result.unitigCoverage.back().insert(result.unitigCoverage.back().end(), old.unitigCoverage[pos.first].begin(), old.unitigCoverage[pos.first].end());
+	std::ofstream outPaths { outputSequencePaths };
+	for (size_t pathi = 0; pathi < readPaths.size(); pathi++)
+	{
+		ReadPath path = readPaths.get(pathi);
+		if (path.path.size() == 0) continue;
+		writePath(outPaths, hashlist, unitigs, unitigExpandedPoses, path, readNames, kmerSize, nodeNamePrefix);
 	}
-	else
+}
+
+// reads are written in the same order as sortPaths sorts them, fetching one read's paths at a time
+void writePaths(const HashList& hashlist, const UnitigGraph& unitigs, const std::vector<CompressedSequenceType>& unitigSequences, const StringIndex& stringIndex, const std::vector<DumbSelect>& unitigExpandedPoses, const SpilledReadPaths& readPaths, const ReadNameDictionary& readNames, const size_t kmerSize, const std::string& outputSequencePaths, const std::string& nodeNamePrefix)
+{
+	std::vector<uint32_t> nameRank = readNames.getSortedRanks();
+	std::vector<uint32_t> readsInNameOrder;
+	readsInNameOrder.resize(nameRank.size());
+	for (size_t i = 0; i < nameRank.size(); i++)
 	{
-		for (size_t i = old.unitigs[pos.first].size()-1; i < old.unitigs[pos.first].size(); i--)
-		{
-			result.unitigs.back().emplace_back(old.unitigs[pos.first][i].first, !old.unitigs[pos.first][i].second);
-			result.unitigCoverage.back().emplace_back(old.unitigCoverage[pos.first][i]);
-		}
+		readsInNameOrder[nameRank[i]] = i;
 	}
-	while (true)
+	std::ofstream outPaths { outputSequencePaths };
+	for (uint32_t read : readsInNameOrder)
 	{
-		if (edges.at(pos).size() != 1) break;
-		auto newPos = *edges.at(pos).begin();
-		auto revPos = std::make_pair(newPos.first, !newPos.second);
-		if (edges.at(revPos).size() != 1) break;
-		if (newPos == start)
-		{
-			result.edges.addEdge(std::make_pair(currentUnitig, true), std::make_pair(currentUnitig, true));
-			result.edges.addEdge(std::make_pair(currentUnitig, false), std::make_pair(currentUnitig, false));
-			result.setEdgeCoverage(currentUnitig, true, currentUnitig, true, old.edgeCoverage(pos.first, pos.second, newPos.first, newPos.second));
-			result.setEdgeOverlap(currentUnitig, true, currentUnitig, true, old.edgeOverlap(pos.first, pos.second, newPos.first, newPos.second));
-			break;
-		}
-		if (belongsToUnitig.at(newPos.first).first != std::numeric_limits<size_t>::max())
-		{
-			assert(newPos.first == pos.first);
-			assert(newPos.second != pos.second);
-			assert(belongsToUnitig.at(newPos.first).first == currentUnitig);
-			assert(belongsToUnitig.at(newPos.first).second != newPos.second);
-			result.edges.addEdge(std::make_pair(currentUnitig, belongsToUnitig.at(pos.first).second == pos.second), std::make_pair(currentUnitig, !(belongsToUnitig.at(pos.first).second == pos.second)));
-			result.setEdgeCoverage(currentUnitig, belongsToUnitig.at(pos.first).second == pos.second, currentUnitig, !(belongsToUnitig.at(pos.first).second == pos.second), old.edgeCoverage(pos.first, pos.second, newPos.first, newPos.second));
-			result.setEdgeOverlap(currentUnitig, belongsToUnitig.at(pos.first).second == pos.second, currentUnitig, !(belongsToUnitig.at(pos.first).second == pos.second), old.edgeOverlap(pos.first, pos.second, newPos.first, newPos.second));
-			break;
-		}
-		pos = newPos;
-		assert(old.leftClip[pos.first] == 0);
-		assert(old.rightClip[pos.first] == 0);
-		assert(belongsToUnitig.at(pos.first).first == std::numeric_limits<size_t>::max());
-		belongsToUnitig[pos.first] = std::make_pair(currentUnitig, pos.second);
-		if (pos.second)
+		if (read >= readPaths.numReads()) continue;
+		std::vector<std::pair<size_t, ReadPath>> paths = readPaths.getPaths(read);
+		std::stable_sort(paths.begin(), paths.end(), [](const std::pair<size_t, ReadPath>& left, const std::pair<size_t, ReadPath>& right)
 		{
-			result.unitigs.back().insert(result.unitigs.back().end(), old.unitigs[pos.first].begin(), old.unitigs[pos.first].end());
-			result.unitigCoverage.back().insert(result.unitigCoverage.back().end(), old.unitigCoverage[pos.first].begin(), old.unitigCoverage[pos.first].end());
-		}
-		else
+			if (left.second.readName.second < right.second.readName.second) return true;
+			if (left.second.readName.second > right.second.readName.second) return false;
+			return left.second.expandedReadPosStart < right.second.expandedReadPosStart;
+		});
+		for (const auto& path : paths)
 		{
-			for (size_t i = old.unitigs[pos.first].size()-1; i < old.unitigs[pos.first].size(); i--)
-			{
-				result.unitigs.back().emplace_back(old.unitigs[pos.first][i].first, !old.unitigs[pos.first][i].second);
-				result.unitigCoverage.back().emplace_back(old.unitigCoverage[pos.first][i]);
-			}
+			if (path.second.path.size() == 0) continue;
+			writePath(outPaths, hashlist, unitigs, unitigExpandedPoses, path.second, readNames, kmerSize, nodeNamePrefix);
 		}
 	}
-	unitigEnd[pos] = true;
-	unitigStart[reverse(pos)] = true;
 }
 
-std::vector<std::pair<size_t, bool>> getUnitigHashes(const std::pair<size_t, bool> start, const SparseEdgeContainer& edges)
+std::vector<std::pair<size_t, bool>> getUnitigHashes(const std::pair<size_t, bool> start, const CompactEdgeContainer& edges)
 {
 	std::vector<std::pair<size_t, bool>> result;
 	result.emplace_back(start);
@@ -319,7 +283,7 @@ std::vector<std::pair<size_t, bool>> getUnitigHashes(const std::pair<size_t, boo
 	return result;
 }
 
-void checkUnitigHashes(const std::pair<size_t, bool> start, const SparseEdgeContainer& edges, std::vector<bool>& checked, const HashList& hashlist, const double minUnitigCoverage, RankBitvector& kept)
+void checkUnitigHashes(const std::pair<size_t, bool> start, const CompactEdgeContainer& edges, std::vector<bool>& checked, const HashList& hashlist, const double minUnitigCoverage, RankBitvector& kept)
 {
 	std::vector<std::pair<size_t, bool>> hashes = getUnitigHashes(start, edges);
 	for (auto node : hashes)
@@ -343,7 +307,7 @@ void checkUnitigHashes(const std::pair<size_t, bool> start, const SparseEdgeCont
 	}
 }
 
-void startUnitig(UnitigGraph& result, std::pair<size_t, bool> start, const SparseEdgeContainer& edges, std::vector<bool>& belongsToUnitig, const HashList& hashlist, size_t minCoverage)
+void startUnitig(UnitigGraph& result, std::pair<size_t, bool> start, const CompactEdgeContainer& edges, std::vector<bool>& belongsToUnitig, const HashList& hashlist, size_t minCoverage)
 {
 	std::vector<std::pair<size_t, bool>> hashes = getUnitigHashes(start, edges);
 	result.unitigs.emplace_back();
@@ -364,31 +328,7 @@ void startUnitig(UnitigGraph& result, std::pair<size_t, bool> start, const Spars
 	}
 }
 
-SparseEdgeContainer getCoveredEdges(const HashList& hashlist, size_t minCoverage)
-{
-	SparseEdgeContainer result { hashlist.coverage.size() };
-	for (size_t i = 0; i < hashlist.coverage.size(); i++)
-	{
-		std::pair<size_t, bool> fw { i, true };
-		std::pair<size_t, bool> bw { i, false };
-		for (auto edge : hashlist.getEdgeCoverages(fw))
-		{
-			if (edge.second < minCoverage) continue;
-			result.addEdge(fw, edge.first);
-			result.addEdge(reverse(edge.first), reverse(fw));
-		}
-		for (auto edge : hashlist.getEdgeCoverages(bw))
-		{
-			if (edge.second < minCoverage) continue;
-			result.addEdge(bw, edge.first);
-			result.addEdge(reverse(edge.first), reverse(bw));
-		}
-	}
-	return result;
-}
-
-
-std::unordered_set<std::pair<size_t, bool>> findReachableNewTips(const RankBitvector& kept, const SparseEdgeContainer& edges, const HashList& hashlist, const VectorWithDirection<bool>& newlyTip, const std::pair<size_t, bool> start)
+std::unordered_set<std::pair<size_t, bool>> findReachableNewTips(const RankBitvector& kept, const CompactEdgeContainer& edges, const HashList& hashlist, const VectorWithDirection<bool>& newlyTip, const std::pair<size_t, bool> start)
 {
 	assert(kept.get(start.first));
 	std::vector<std::pair<size_t, bool>> stack;
@@ -417,7 +357,7 @@ std::unordered_set<std::pair<size_t, bool>> findReachableNewTips(const RankBitve
 	return result;
 }
 
-void keepReachableNewTips(const RankBitvector& kept, const SparseEdgeContainer& edges, const HashList& hashlist, const VectorWithDirection<bool>& newlyTip, const std::pair<size_t, bool> start, const std::unordered_set<std::pair<size_t, bool>>& reachableTips, std::unordered_set<size_t>& newlyKept)
+void keepReachableNewTips(const RankBitvector& kept, const CompactEdgeContainer& edges, const HashList& hashlist, const VectorWithDirection<bool>& newlyTip, const std::pair<size_t, bool> start, const std::unordered_set<std::pair<size_t, bool>>& reachableTips, std::unordered_set<size_t>& newlyKept)
 {
 	std::unordered_set<std::pair<size_t, bool>> reachableFw;
 	std::unordered_set<std::pair<size_t, bool>> reachableBw;
@@ -460,7 +400,7 @@ void keepReachableNewTips(const RankBitvector& kept, const SparseEdgeContainer&
 	}
 }
 
-bool isTipGap(const RankBitvector& kept, const SparseEdgeContainer& edges, const HashList& hashlist, const std::pair<size_t, bool> start)
+bool isTipGap(const RankBitvector& kept, const CompactEdgeContainer& edges, const HashList& hashlist, const std::pair<size_t, bool> start)
 {
 	if (!kept.get(start.first)) return false;
 	if (edges[start].size() == 0) return false;
@@ -471,7 +411,7 @@ bool isTipGap(const RankBitvector& kept, const SparseEdgeContainer& edges, const
 	return true;
 }
 
-void keepTipGaps(RankBitvector& kept, const SparseEdgeContainer& edges, const HashList& hashlist)
+void keepTipGaps(RankBitvector& kept, const CompactEdgeContainer& edges, const HashList& hashlist)
 {
 	VectorWithDirection<bool> newlyTip;
 	newlyTip.resize(hashlist.size(), false);
@@ -526,7 +466,7 @@ void keepTipGaps(RankBitvector& kept, const SparseEdgeContainer& edges, const Ha
 
 }
 
-std::pair<size_t, bool> extendOneCoverageKmers(HashList& hashlist, std::pair<size_t, bool> pos, const SparseEdgeContainer& edges)
+std::pair<size_t, bool> extendOneCoverageKmers(HashList& hashlist, std::pair<size_t, bool> pos, const CompactEdgeContainer& edges)
 {
 	auto start = pos;
 	size_t iterations = 0;
@@ -545,9 +485,8 @@ std::pair<size_t, bool> extendOneCoverageKmers(HashList& hashlist, std::pair<siz
 	}
 }
 
-void removeOnecovNodes(HashList& hashlist, const bool onlyTips)
+void removeOnecovNodes(HashList& hashlist, CompactEdgeContainer& edges, const bool onlyTips)
 {
-	auto edges = getCoveredEdges(hashlist, 1);
 	RankBitvector kept { hashlist.size() };
 	std::vector<bool> checked;
 	checked.resize(hashlist.size(), false);
@@ -623,18 +562,21 @@ void removeOnecovNodes(HashList& hashlist, const bool onlyTips)
 	{
 		kept.buildRanks();
 		hashlist.filter(kept);
+		edges.filter(kept);
 	}
 }
 
-UnitigGraph getUnitigGraph(HashList& hashlist, const size_t minCoverage, const double minUnitigCoverage, const bool keepGaps, const bool oneCovHeuristic)
+UnitigGraph getUnitigGraph(HashList& hashlist, const size_t minCoverage, const double minUnitigCoverage, const bool keepGaps, const bool oneCovHeuristic, const size_t numThreads)
 {
+	// the covered edges are built once and then filtered along with the hashlist instead of being rebuilt after each filtering
+	CompactEdgeContainer edges { hashlist, oneCovHeuristic ? 1 : minCoverage, numThreads };
 	if (oneCovHeuristic)
 	{
-		removeOnecovNodes(hashlist, true);
-		removeOnecovNodes(hashlist, false);
+		removeOnecovNodes(hashlist, edges, true);
+		removeOnecovNodes(hashlist, edges, false);
+		edges = edges.filterByCoverage(minCoverage, numThreads);
 	}
 	{
-		auto edges = getCoveredEdges(hashlist, minCoverage);
 		RankBitvector kept { hashlist.size() };
 		std::vector<bool> checked;
 		checked.resize(hashlist.size(), false);
@@ -685,12 +627,12 @@ UnitigGraph getUnitigGraph(HashList& hashlist, const size_t minCoverage, const d
 		if (keepGaps) keepTipGaps(kept, edges, hashlist);
 		kept.buildRanks();
 		hashlist.filter(kept);
+		edges.filter(kept);
 	}
 	UnitigGraph result;
 	std::vector<bool> belongsToUnitig;
 	belongsToUnitig.resize(hashlist.coverage.size(), false);
 	std::unordered_map<std::pair<size_t, bool>, std::pair<size_t, bool>> unitigTip;
-	auto edges = getCoveredEdges(hashlist, minCoverage);
 	for (size_t i = 0; i < hashlist.coverage.size(); i++)
 	{
 		if (hashlist.coverage.get(i) < minCoverage) continue;
@@ -779,97 +721,124 @@ UnitigGraph getUnitigGraph(HashList& hashlist, const size_t minCoverage, const d
 	return result;
 }
 
-UnitigGraph getUnitigs(const UnitigGraph& oldgraph)
+UnitigGraph getUnitigs(const UnitigGraph& oldgraph, const size_t numThreads)
 {
-	UnitigGraph result;
-	VectorWithDirection<std::unordered_set<std::pair<size_t, bool>>> edges;
-	edges.resize(oldgraph.unitigs.size());
-	for (size_t i = 0; i < oldgraph.edges.size(); i++)
-	{
-		std::pair<size_t, bool> fw { i, true };
-		std::pair<size_t, bool> bw { i, false };
-		for (auto to : oldgraph.edges[fw])
-		{
-			edges[fw].emplace(to);
-			edges[reverse(to)].emplace(reverse(fw));
+	CompactEdgeContainer edges { oldgraph.edges, numThreads };
+	const size_t nodeCount = oldgraph.unitigs.size();
+	// whether getUnitigHashes walking from the predecessor of side would continue into side
+	auto continuesInto = [&edges](std::pair<size_t, bool> side)
+	{
+		auto bwEdges = edges[reverse(side)];
+		if (bwEdges.size() != 1) return false;
+		auto prev = reverse(bwEdges[0]);
+		if (edges[prev].size() != 1) return false;
+		if (prev.first == side.first) return false;
+		return true;
+	};
+	// chains are walked in parallel from every side where a unitig can start
+	// a chain which can start from both of its ends is kept only from the smaller start so each node is in one chain
+	std::vector<std::vector<std::vector<std::pair<size_t, bool>>>> rangeChains;
+	rangeChains.resize(getNumRanges(nodeCount, numThreads));
+	iterateRangesMultithreaded(nodeCount, numThreads, [&edges, &rangeChains, &continuesInto](size_t range, size_t start, size_t end)
+	{
+		for (size_t node = start; node < end; node++)
+		{
+			for (std::pair<size_t, bool> side : { std::make_pair(node, false), std::make_pair(node, true) })
+			{
+				if (continuesInto(side)) continue;
+				std::vector<std::pair<size_t, bool>> chain = getUnitigHashes(side, edges);
+				auto otherStart = reverse(chain.back());
+				if (!continuesInto(otherStart) && otherStart < side) continue;
+				rangeChains[range].emplace_back(std::move(chain));
+			}
 		}
-		for (auto to : oldgraph.edges[bw])
+	});
+	std::vector<std::vector<std::pair<size_t, bool>>> chains;
+	for (size_t range = 0; range < rangeChains.size(); range++)
+	{
+		for (size_t i = 0; i < rangeChains[range].size(); i++)
 		{
-			edges[bw].emplace(to);
-			edges[reverse(to)].emplace(reverse(bw));
+			chains.emplace_back(std::move(rangeChains[range][i]));
 		}
 	}
 	std::vector<std::pair<size_t, bool>> belongsToUnitig;
-	belongsToUnitig.resize(oldgraph.unitigs.size(), std::make_pair(std::numeric_limits<size_t>::max(), true));
-	VectorWithDirection<bool> unitigStart;
-	VectorWithDirection<bool> unitigEnd;
-	unitigStart.resize(oldgraph.unitigs.size(), false);
-	unitigEnd.resize(oldgraph.unitigs.size(), false);
-	for (size_t node = 0; node < oldgraph.unitigs.size(); node++)
-	{
-		auto fw = std::make_pair(node, true);
-		auto bw = std::make_pair(node, false);
-		if (edges.at(fw).size() != 1)
-		{
-			for (auto start : edges.at(fw))
-			{
-				if (belongsToUnitig.at(start.first).first != std::numeric_limits<size_t>::max()) continue;
-				startUnitig(result, oldgraph, start, edges, belongsToUnitig, unitigStart, unitigEnd);
-			}
-			if (belongsToUnitig.at(node).first == std::numeric_limits<size_t>::max()) startUnitig(result, oldgraph, bw, edges, belongsToUnitig, unitigStart, unitigEnd);
-		}
-		if (edges.at(bw).size() != 1)
+	belongsToUnitig.resize(nodeCount, std::make_pair(std::numeric_limits<size_t>::max(), true));
+	iterateRangesMultithreaded(chains.size(), numThreads, [&chains, &belongsToUnitig](size_t range, size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
 		{
-			for (auto start : edges.at(bw))
+			for (auto pos : chains[i])
 			{
-				if (belongsToUnitig.at(start.first).first != std::numeric_limits<size_t>::max()) continue;
-				startUnitig(result, oldgraph, start, edges, belongsToUnitig, unitigStart, unitigEnd);
+				assert(belongsToUnitig[pos.first].first == std::numeric_limits<size_t>::max());
+				belongsToUnitig[pos.first] = std::make_pair(i, pos.second);
 			}
-			if (belongsToUnitig.at(node).first == std::numeric_limits<size_t>::max()) startUnitig(result, oldgraph, fw, edges, belongsToUnitig, unitigStart, unitigEnd);
 		}
-	}
-	for (size_t node = 0; node < oldgraph.unitigs.size(); node++)
-	{
-		auto fw = std::make_pair(node, true);
-		if (belongsToUnitig.at(node).first == std::numeric_limits<size_t>::max()) startUnitig(result, oldgraph, fw, edges, belongsToUnitig, unitigStart, unitigEnd);
-	}
-	for (size_t i = 0; i < oldgraph.edges.size(); i++)
+	});
+	// the rest are in cycles with no start
+	for (size_t node = 0; node < nodeCount; node++)
 	{
-		auto fw = std::make_pair(i, true);
-		if (unitigEnd[fw])
+		if (belongsToUnitig[node].first != std::numeric_limits<size_t>::max()) continue;
+		chains.emplace_back(getUnitigHashes(std::make_pair(node, true), edges));
+		for (auto pos : chains.back())
 		{
-			for (auto curr : oldgraph.edges[fw])
+			assert(belongsToUnitig[pos.first].first == std::numeric_limits<size_t>::max());
+			belongsToUnitig[pos.first] = std::make_pair(chains.size()-1, pos.second);
+		}
+	}
+	UnitigGraph result;
+	result.unitigs.resize(chains.size());
+	result.unitigCoverage.resize(chains.size());
+	result.edges.resize(chains.size());
+	result.edgeCov.resize(chains.size());
+	result.edgeOvlp.resize(chains.size());
+	result.leftClip.resize(chains.size(), 0);
+	result.rightClip.resize(chains.size(), 0);
+	std::vector<std::vector<std::tuple<std::pair<size_t, bool>, std::pair<size_t, bool>, size_t, size_t>>> rangeEdges;
+	rangeEdges.resize(getNumRanges(chains.size(), numThreads));
+	iterateRangesMultithreaded(chains.size(), numThreads, [&oldgraph, &edges, &chains, &belongsToUnitig, &result, &rangeEdges](size_t range, size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			for (auto pos : chains[i])
+			{
+				assert(oldgraph.leftClip[pos.first] == 0);
+				assert(oldgraph.rightClip[pos.first] == 0);
+				if (pos.second)
+				{
+					result.unitigs[i].insert(result.unitigs[i].end(), oldgraph.unitigs[pos.first].begin(), oldgraph.unitigs[pos.first].end());
+					result.unitigCoverage[i].insert(result.unitigCoverage[i].end(), oldgraph.unitigCoverage[pos.first].begin(), oldgraph.unitigCoverage[pos.first].end());
+				}
+				else
+				{
+					for (size_t j = oldgraph.unitigs[pos.first].size()-1; j < oldgraph.unitigs[pos.first].size(); j--)
+					{
+						result.unitigs[i].emplace_back(oldgraph.unitigs[pos.first][j].first, !oldgraph.unitigs[pos.first][j].second);
+						result.unitigCoverage[i].emplace_back(oldgraph.unitigCoverage[pos.first][j]);
+					}
+				}
+			}
+			for (auto unitigEnd : { std::make_pair(chains[i].back(), true), std::make_pair(reverse(chains[i][0]), false) })
 			{
-				assert(unitigStart[curr]);
-				auto from = belongsToUnitig.at(fw.first);
-				bool prevFw = fw.second;
-				auto to = belongsToUnitig.at(curr.first);
-				bool currFw = curr.second;
-				from.second = !(from.second ^ prevFw);
-				to.second = !(to.second ^ currFw);
-				result.edges.addEdge(from, to);
-				result.edges.addEdge(reverse(to), reverse(from));
-				result.setEdgeCoverage(from, to, oldgraph.edgeCoverage(fw, curr));
-				result.setEdgeOverlap(from, to, oldgraph.edgeOverlap(fw, curr));
+				std::pair<size_t, bool> from { i, unitigEnd.second };
+				for (auto curr : edges[unitigEnd.first])
+				{
+					auto to = belongsToUnitig[curr.first];
+					to.second = !(to.second ^ curr.second);
+					rangeEdges[range].emplace_back(from, to, oldgraph.edgeCoverage(unitigEnd.first, curr), oldgraph.edgeOverlap(unitigEnd.first, curr));
+				}
 			}
 		}
-		auto bw = std::make_pair(i, false);
-		if (unitigEnd[bw])
+	});
+	for (size_t range = 0; range < rangeEdges.size(); range++)
+	{
+		for (auto t : rangeEdges[range])
 		{
-			for (auto curr : oldgraph.edges[bw])
-			{
-				assert(unitigStart[curr]);
-				auto from = belongsToUnitig.at(bw.first);
-				bool prevFw = bw.second;
-				auto to = belongsToUnitig.at(curr.first);
-				bool currFw = curr.second;
-				from.second = !(from.second ^ prevFw);
-				to.second = !(to.second ^ currFw);
-				result.edges.addEdge(from, to);
-				result.edges.addEdge(reverse(to), reverse(from));
-				result.setEdgeCoverage(from, to, oldgraph.edgeCoverage(bw, curr));
-				result.setEdgeOverlap(from, to, oldgraph.edgeOverlap(bw, curr));
-			}
+			std::pair<size_t, bool> from = std::get<0>(t);
+			std::pair<size_t, bool> to = std::get<1>(t);
+			result.edges.addEdge(from, to);
+			result.edges.addEdge(reverse(to), reverse(from));
+			result.setEdgeCoverage(from, to, std::get<2>(t));
+			result.setEdgeOverlap(from, to, std::get<3>(t));
 		}
 	}
 	return result;
@@ -1056,38 +1025,84 @@ void printUnitigKmerCount(const UnitigGraph& unitigs)
 	std::cerr << unitigKmers << " distinct selected k-mers in unitigs after filtering" << std::endl;
 }
 
-void sortKmersByHashes(UnitigGraph& unitigs, HashList& reads)
+// assigns k-mer ids in unitig traversal order so loops which walk along unitigs touch contiguous k-mer data
+// unitigs are ordered and oriented by the hashes of their end k-mers, and k-mers outside unitigs are ordered by hash, so the ids don't depend on k-mer loading order
+// UnitigGraph::sort then sees the same order and orientation in the new ids as it would with ids sorted by hash
+void sortKmersByUnitigs(UnitigGraph& unitigs, HashList& reads, const size_t numThreads)
 {
-	std::vector<size_t> kmerMapping = reads.sortByHash();
-	unitigs.sort(kmerMapping);
+	std::vector<size_t> kmerMapping;
+	kmerMapping.resize(reads.size(), std::numeric_limits<size_t>::max());
+	size_t nextId = 0;
+	{
+		std::vector<HashType> hashes = reads.getHashes();
+		std::vector<size_t> unitigOrder;
+		unitigOrder.resize(unitigs.unitigs.size());
+		for (size_t i = 0; i < unitigOrder.size(); i++)
+		{
+			unitigOrder[i] = i;
+		}
+		sortMultithreaded(unitigOrder, numThreads, [&unitigs, &hashes](size_t left, size_t right)
+		{
+			return std::min(hashes[unitigs.unitigs[left][0].first], hashes[unitigs.unitigs[left].back().first]) < std::min(hashes[unitigs.unitigs[right][0].first], hashes[unitigs.unitigs[right].back().first]);
+		});
+		for (size_t i : unitigOrder)
+		{
+			const auto& unitig = unitigs.unitigs[i];
+			bool flip = hashes[unitig.back().first] < hashes[unitig[0].first];
+			for (size_t j = 0; j < unitig.size(); j++)
+			{
+				size_t kmer = flip ? unitig[unitig.size()-1-j].first : unitig[j].first;
+				if (kmerMapping[kmer] != std::numeric_limits<size_t>::max()) continue;
+				kmerMapping[kmer] = nextId;
+				nextId += 1;
+			}
+		}
+		std::vector<std::pair<HashType, size_t>> notInUnitigs;
+		for (size_t i = 0; i < kmerMapping.size(); i++)
+		{
+			if (kmerMapping[i] != std::numeric_limits<size_t>::max()) continue;
+			notInUnitigs.emplace_back(hashes[i], i);
+		}
+		radixSortHashes(notInUnitigs, numThreads);
+		for (const auto& pair : notInUnitigs)
+		{
+			kmerMapping[pair.second] = nextId;
+			nextId += 1;
+		}
+	}
+	assert(nextId == reads.size());
+	reads.renumber(kmerMapping, numThreads);
+	unitigs.sort(kmerMapping, numThreads);
 }
 
-void filterKmersToUnitigKmers(UnitigGraph& unitigs, HashList& reads, const size_t kmerSize, const bool filterWithinUnitig)
+void filterKmersToUnitigKmers(UnitigGraph& unitigs, HashList& reads, const size_t kmerSize, const bool filterWithinUnitig, const size_t numThreads)
 {
 	std::vector<bool> reverseContig;
 	reverseContig.resize(unitigs.unitigs.size(), false);
 	{
-		std::unordered_map<size_t, std::pair<size_t, bool>> kmerPosition;
+		// kmerPosition[kmer] = unitig * 2 + (last k-mer ? 1 : 0)
+		phmap::flat_hash_map<size_t, size_t> kmerPosition;
+		kmerPosition.reserve(unitigs.unitigs.size() * 2);
 		std::vector<HashType> firstHash;
 		std::vector<HashType> lastHash;
 		for (size_t i = 0; i < unitigs.unitigs.size(); i++)
 		{
-			kmerPosition[unitigs.unitigs[i][0].first] = std::make_pair(i, false);
-			kmerPosition[unitigs.unitigs[i].back().first] = std::make_pair(i, true);
+			kmerPosition[unitigs.unitigs[i][0].first] = i * 2;
+			kmerPosition[unitigs.unitigs[i].back().first] = i * 2 + 1;
 		}
 		firstHash.resize(unitigs.unitigs.size());
 		lastHash.resize(unitigs.unitigs.size());
 		for (auto pair : reads.hashToNode)
 		{
-			if (kmerPosition.count(pair.second) == 0) continue;
-			auto pos = kmerPosition.at(pair.second);
-			if (pos.second)
+			auto found = kmerPosition.find(pair.second);
+			if (found == kmerPosition.end()) continue;
+			if (found->second % 2 == 1)
 			{
-				lastHash[pos.first] = pair.first;
+				lastHash[found->second / 2] = pair.first;
 			}
 			else
 			{
-				firstHash[pos.first] = pair.first;
+				firstHash[found->second / 2] = pair.first;
 			}
 		}
 		for (size_t i = 0; i < unitigs.unitigs.size(); i++)
@@ -1095,92 +1110,108 @@ void filterKmersToUnitigKmers(UnitigGraph& unitigs, HashList& reads, const size_
 			reverseContig[i] = lastHash[i] < firstHash[i];
 		}
 	}
-	RankBitvector kept { reads.coverage.size() };
-	std::vector<std::tuple<std::pair<size_t, bool>, std::pair<size_t, bool>, size_t>> newOverlaps;
-	for (size_t i = 0; i < unitigs.unitigs.size(); i++)
+	// unitigs are filtered independently, only the kept bits and the new overlaps are collected per range and applied afterwards
+	std::vector<std::vector<std::tuple<std::pair<size_t, bool>, std::pair<size_t, bool>, size_t>>> newOverlaps;
+	newOverlaps.resize(getNumRanges(unitigs.unitigs.size(), numThreads));
+	iterateRangesMultithreaded(unitigs.unitigs.size(), numThreads, [&unitigs, &reads, &reverseContig, &newOverlaps, kmerSize, filterWithinUnitig](size_t range, size_t start, size_t end)
 	{
-		if (reverseContig[i])
-		{
-			std::reverse(unitigs.unitigs[i].begin(), unitigs.unitigs[i].end());
-			std::reverse(unitigs.unitigCoverage[i].begin(), unitigs.unitigCoverage[i].end());
-			for (size_t j = 0; j < unitigs.unitigs[i].size(); j++)
-			{
-				unitigs.unitigs[i][j] = reverse(unitigs.unitigs[i][j]);
-			}
-		}
-		std::vector<std::pair<size_t, bool>> newUnitig;
-		std::vector<size_t> newCoverage;
-		newUnitig.reserve(unitigs.unitigs[i].size());
-		newCoverage.reserve(unitigs.unitigs[i].size());
-		size_t lastStart = 0;
-		size_t currentPos = 0;
-		std::pair<size_t, bool> lastKmer { std::numeric_limits<size_t>::max(), true };
-		for (size_t j = 0; j < unitigs.unitigs[i].size(); j++)
+		for (size_t i = start; i < end; i++)
 		{
-			if (j > 0) currentPos += kmerSize - reads.getOverlap(unitigs.unitigs[i][j-1], unitigs.unitigs[i][j]);
-			bool skip = filterWithinUnitig;
-			if (reads.isTipKmer(unitigs.unitigs[i][j].first))
+			if (reverseContig[i])
 			{
-				skip = false;
-			}
-			else if (j == 0 || j == unitigs.unitigs[i].size()-1)
-			{
-				skip = false;
+				std::reverse(unitigs.unitigs[i].begin(), unitigs.unitigs[i].end());
+				std::reverse(unitigs.unitigCoverage[i].begin(), unitigs.unitigCoverage[i].end());
+				for (size_t j = 0; j < unitigs.unitigs[i].size(); j++)
+				{
+					unitigs.unitigs[i][j] = reverse(unitigs.unitigs[i][j]);
+				}
 			}
-			else
+			std::vector<std::pair<size_t, bool>> newUnitig;
+			std::vector<size_t> newCoverage;
+			newUnitig.reserve(unitigs.unitigs[i].size());
+			newCoverage.reserve(unitigs.unitigs[i].size());
+			size_t lastStart = 0;
+			size_t currentPos = 0;
+			std::pair<size_t, bool> lastKmer { std::numeric_limits<size_t>::max(), true };
+			for (size_t j = 0; j < unitigs.unitigs[i].size(); j++)
 			{
-				assert(j+1 < unitigs.unitigs[i].size());
-				if (currentPos + (kmerSize - reads.getOverlap(unitigs.unitigs[i][j], unitigs.unitigs[i][j+1])) >= lastStart + kmerSize)
+				if (j > 0) currentPos += kmerSize - reads.getOverlap(unitigs.unitigs[i][j-1], unitigs.unitigs[i][j]);
+				bool skip = filterWithinUnitig;
+				if (reads.isTipKmer(unitigs.unitigs[i][j].first))
 				{
 					skip = false;
 				}
+				else if (j == 0 || j == unitigs.unitigs[i].size()-1)
+				{
+					skip = false;
+				}
+				else
+				{
+					assert(j+1 < unitigs.unitigs[i].size());
+					if (currentPos + (kmerSize - reads.getOverlap(unitigs.unitigs[i][j], unitigs.unitigs[i][j+1])) >= lastStart + kmerSize)
+					{
+						skip = false;
+					}
+				}
+				if (!skip)
+				{
+					std::pair<size_t, bool> thisKmer = unitigs.unitigs[i][j];
+					if (lastKmer.first != std::numeric_limits<size_t>::max())
+					{
+						assert(currentPos > lastStart);
+						assert(currentPos - lastStart < kmerSize);
+						newOverlaps[range].emplace_back(lastKmer, thisKmer, kmerSize - (currentPos - lastStart));
+					}
+					newUnitig.push_back(thisKmer);
+					newCoverage.push_back(unitigs.unitigCoverage[i][j]);
+					lastStart = currentPos;
+					lastKmer = thisKmer;
+				}
 			}
-			assert(!kept.get(unitigs.unitigs[i][j].first));
-			if (!skip)
+			newUnitig.shrink_to_fit();
+			newCoverage.shrink_to_fit();
+			if (reverseContig[i])
 			{
-				kept.set(unitigs.unitigs[i][j].first, true);
-				assert(kept.get(unitigs.unitigs[i][j].first));
-				std::pair<size_t, bool> thisKmer = unitigs.unitigs[i][j];
-				if (lastKmer.first != std::numeric_limits<size_t>::max())
+				std::reverse(newUnitig.begin(), newUnitig.end());
+				std::reverse(newCoverage.begin(), newCoverage.end());
+				for (size_t j = 0; j < newUnitig.size(); j++)
 				{
-					assert(currentPos > lastStart);
-					assert(currentPos - lastStart < kmerSize);
-					newOverlaps.emplace_back(lastKmer, thisKmer, kmerSize - (currentPos - lastStart));
+					newUnitig[j] = reverse(newUnitig[j]);
 				}
-				newUnitig.push_back(thisKmer);
-				newCoverage.push_back(unitigs.unitigCoverage[i][j]);
-				lastStart = currentPos;
-				lastKmer = thisKmer;
 			}
+			std::swap(unitigs.unitigs[i], newUnitig);
+			std::swap(unitigs.unitigCoverage[i], newCoverage);
 		}
-		newUnitig.shrink_to_fit();
-		newCoverage.shrink_to_fit();
-		if (reverseContig[i])
+	});
+	RankBitvector kept { reads.coverage.size() };
+	for (size_t i = 0; i < unitigs.unitigs.size(); i++)
+	{
+		for (size_t j = 0; j < unitigs.unitigs[i].size(); j++)
 		{
-			std::reverse(newUnitig.begin(), newUnitig.end());
-			std::reverse(newCoverage.begin(), newCoverage.end());
-			for (size_t j = 0; j < newUnitig.size(); j++)
-			{
-				newUnitig[j] = reverse(newUnitig[j]);
-			}
+			assert(!kept.get(unitigs.unitigs[i][j].first));
+			kept.set(unitigs.unitigs[i][j].first, true);
 		}
-		std::swap(unitigs.unitigs[i], newUnitig);
-		std::swap(unitigs.unitigCoverage[i], newCoverage);
 	}
 	kept.buildRanks();
-	for (size_t i = 0; i < unitigs.unitigs.size(); i++)
+	iterateRangesMultithreaded(unitigs.unitigs.size(), numThreads, [&unitigs, &kept](size_t range, size_t start, size_t end)
 	{
-		for (size_t j = 0; j < unitigs.unitigs[i].size(); j++)
+		for (size_t i = start; i < end; i++)
 		{
-			unitigs.unitigs[i][j].first = kept.getRank(unitigs.unitigs[i][j].first);
+			for (size_t j = 0; j < unitigs.unitigs[i].size(); j++)
+			{
+				unitigs.unitigs[i][j].first = kept.getRank(unitigs.unitigs[i][j].first);
+			}
 		}
-	}
+	});
 	reads.filter(kept);
-	for (auto t : newOverlaps)
+	for (size_t range = 0; range < newOverlaps.size(); range++)
 	{
-		std::pair<size_t, bool> from { kept.getRank(std::get<0>(t).first), std::get<0>(t).second };
-		std::pair<size_t, bool> to { kept.getRank(std::get<1>(t).first), std::get<1>(t).second };
-		reads.addSequenceOverlap(from, to, std::get<2>(t));
+		for (auto t : newOverlaps[range])
+		{
+			std::pair<size_t, bool> from { kept.getRank(std::get<0>(t).first), std::get<0>(t).second };
+			std::pair<size_t, bool> to { kept.getRank(std::get<1>(t).first), std::get<1>(t).second };
+			reads.addSequenceOverlap(from, to, std::get<2>(t));
+		}
 	}
 }
 
@@ -1232,22 +1263,19 @@ void verifyEdgeConsistency(const UnitigGraph& unitigs, const HashList& hashlist,
 	}
 }
 
-std::vector<ReadPath> getReadPaths(const UnitigGraph& graph, const HashList& hashlist, const size_t numThreads, const ReadpartIterator& partIterator, const size_t kmerSize)
+ReadPathStore getReadPaths(const UnitigGraph& graph, const HashList& hashlist, const size_t numThreads, const ReadpartIterator& partIterator, const size_t kmerSize)
 {
 	std::vector<std::tuple<size_t, size_t, bool>> kmerLocator = getKmerLocator(graph);
-	std::vector<ReadPath> result;
-	std::mutex resultMutex;
-	partIterator.iterateOnlyHashes([&result, &resultMutex, &kmerLocator, kmerSize, &graph, &hashlist](const ReadInfo& read, const std::vector<size_t>& positions, const std::vector<HashType>& hashes)
+	PerThreadBuffers<ReadPathStore> threadPaths;
+	partIterator.iterateOnlyHashes([&threadPaths, &kmerLocator, kmerSize, &graph, &hashlist](const ReadInfo& read, const std::vector<size_t>& positions, const std::vector<HashType>& hashes)
 	{
-		iterateReadPaths(graph, hashlist, kmerSize, kmerLocator, read, positions, hashes, [&result, &resultMutex](ReadPath path)
+		ReadPathStore& paths = threadPaths.local();
+		iterateReadPaths(graph, hashlist, kmerSize, kmerLocator, read, positions, hashes, [&paths](const ReadPath& path)
 		{
-			std::lock_guard<std::mutex> lock { resultMutex };
-			result.emplace_back();
-			std::swap(result.back(), path);
+			paths.push_back(path);
 		});
 	});
-
-	return result;
+	return ReadPathStore::concatenate(threadPaths.getBuffers(), numThreads);
 }
 
 std::vector<double> getRawKmerCoverages(const UnitigGraph& unitigs, const std::vector<CompressedSequenceType>& unitigSequences, const HashList& reads, const size_t kmerSize)
@@ -1395,20 +1423,32 @@ std::vector<double> getRawKmerCoverages(const UnitigGraph& unitigs, const std::v
 	return result;
 }
 
-void sortPaths(std::vector<ReadPath>& readPaths)
+// sorted by read name, not by read ordinal
+void sortPaths(ReadPathStore& readPaths, const ReadNameDictionary& readNames)
 {
-	std::stable_sort(readPaths.begin(), readPaths.end(), [](const ReadPath& left, const ReadPath& right)
-	{
-		if (&left == &right) return false;
-		if (left.readName < right.readName) return true;
-		if (left.readName > right.readName) return false;
-		assert(left.readName == right.readName);
-		assert(left.expandedReadPosStart < left.readLength);
-		assert(right.expandedReadPosStart < left.readLength);
-		if (left.expandedReadPosStart < right.expandedReadPosStart) return true;
-		if (left.expandedReadPosStart > right.expandedReadPosStart) return false;
+	std::vector<uint32_t> nameRank = readNames.getSortedRanks();
+	std::vector<size_t> order;
+	order.reserve(readPaths.size());
+	for (size_t i = 0; i < readPaths.size(); i++)
+	{
+		order.push_back(i);
+	}
+	std::stable_sort(order.begin(), order.end(), [&nameRank, &readPaths](size_t left, size_t right)
+	{
+		if (left == right) return false;
+		std::pair<uint32_t, size_t> leftKey { nameRank[readPaths.readName(left).first], readPaths.readName(left).second };
+		std::pair<uint32_t, size_t> rightKey { nameRank[readPaths.readName(right).first], readPaths.readName(right).second };
+		if (leftKey < rightKey) return true;
+		if (leftKey > rightKey) return false;
+		assert(readPaths.readName(left) == readPaths.readName(right));
+		assert(readPaths.expandedReadPosStart(left) < readPaths.readLength(left));
+		assert(readPaths.expandedReadPosStart(right) < readPaths.readLength(left));
+		if (readPaths.expandedReadPosStart(left) < readPaths.expandedReadPosStart(right)) return true;
+		if (readPaths.expandedReadPosStart(left) > readPaths.expandedReadPosStart(right)) return false;
 		assert(false);
+		return false;
 	});
+	readPaths = readPaths.permuted(order);
 }
 
 void outputNodeHomology(const HashList& reads, const UnitigGraph& unitigGraph, const size_t kmerSize, const std::vector<std::vector<size_t>>& kmerStartPositions, const std::vector<CompressedSequenceType>& unitigSequences, const StringIndex& stringIndex, const std::vector<DumbSelect>& unitigExpandedPoses, std::ostream& output, std::pair<size_t, size_t> leftPosition, std::pair<size_t, size_t> rightPosition)
@@ -1535,7 +1575,7 @@ std::vector<DumbSelect> getUnitigExpandedPoses(const HashList& hashlist, const U
 	return unitigExpandedPoses;
 }
 
-void runMBG(const std::vector<std::string>& inputReads, const std::string& outputGraph, const size_t kmerSize, const size_t windowSize, const size_t minCoverage, const double minUnitigCoverage, const ErrorMasking errorMasking, const size_t numThreads, const bool includeEndKmers, const std::string& outputSequencePaths, const size_t maxResolveLength, const bool blunt, const size_t maxUnconditionalResolveLength, const std::string& nodeNamePrefix, const std::string& sequenceCacheFile, const bool keepGaps, const double hpcVariantOnecopyCoverage, const bool guesswork, const bool copycountFilterHeuristic, const bool onlyLocalResolve, const std::string& outputHomologyMap, const bool filterWithinUnitig, const bool doCleaning)
+void runMBG(const std::vector<std::string>& inputReads, const std::string& outputGraph, const size_t kmerSize, const size_t windowSize, const size_t minCoverage, const double minUnitigCoverage, const ErrorMasking errorMasking, const size_t numThreads, const bool includeEndKmers, const std::string& outputSequencePaths, const size_t maxResolveLength, const bool blunt, const size_t maxUnconditionalResolveLength, const std::string& nodeNamePrefix, const std::string& sequenceCacheFile, const bool keepGaps, const double hpcVariantOnecopyCoverage, const bool guesswork, const bool copycountFilterHeuristic, const bool onlyLocalResolve, const std::string& outputHomologyMap, const bool filterWithinUnitig, const bool doCleaning, const std::string& readPathFile, const std::string& resolutionCheckpointFile, const size_t resolutionCheckpointInterval, const bool resumeResolution)
 {
 	// check that all files actually exist
 	for (const std::string& name : inputReads)
@@ -1554,12 +1594,12 @@ void runMBG(const std::vector<std::string>& inputReads, const std::string& outpu
 	{
 		std::cerr << "Collecting hpc variant k-mers" << std::endl;
 		loadReadsAsHashesMultithread(reads, kmerSize, partIterator, numThreads, std::cerr);
-		auto unitigs = getUnitigGraph(reads, minCoverage, minUnitigCoverage, keepGaps, false);
+		auto unitigs = getUnitigGraph(reads, minCoverage, minUnitigCoverage, keepGaps, false, numThreads);
 		if (minUnitigCoverage > minCoverage)
 		{
-			unitigs = getUnitigs(unitigs.filterUnitigsByCoverage(minUnitigCoverage, keepGaps));
+			unitigs = getUnitigs(unitigs.filterUnitigsByCoverage(minUnitigCoverage, keepGaps), numThreads);
 		}
-		sortKmersByHashes(unitigs, reads);
+		sortKmersByUnitigs(unitigs, reads, numThreads);
 		getHpcVariantsAndReadPaths(reads, unitigs, kmerSize, partIterator, numThreads, hpcVariantOnecopyCoverage * 1.5, hpcVariantOnecopyCoverage * 0.5);
 		reads.clear();
 		partIterator.clearCacheHashes();
@@ -1569,38 +1609,53 @@ void runMBG(const std::vector<std::string>& inputReads, const std::string& outpu
 	loadReadsAsHashesMultithread(reads, kmerSize, partIterator, numThreads, std::cerr);
 	auto beforeUnitigs = getTime();
 	std::cerr << "Unitigifying" << std::endl;
-	auto unitigs = getUnitigGraph(reads, minCoverage, minUnitigCoverage, keepGaps, (minUnitigCoverage >= 2) && (maxResolveLength > 0) && guesswork);
+	auto unitigs = getUnitigGraph(reads, minCoverage, minUnitigCoverage, keepGaps, (minUnitigCoverage >= 2) && (maxResolveLength > 0) && guesswork, numThreads);
 	auto beforeFilter = getTime();
 	if (minUnitigCoverage > minCoverage)
 	{
 		std::cerr << "Filtering by unitig coverage" << std::endl;
-		unitigs = getUnitigs(unitigs.filterUnitigsByCoverage(minUnitigCoverage, keepGaps));
+		unitigs = getUnitigs(unitigs.filterUnitigsByCoverage(minUnitigCoverage, keepGaps), numThreads);
 	}
-	filterKmersToUnitigKmers(unitigs, reads, kmerSize, filterWithinUnitig);
-	sortKmersByHashes(unitigs, reads);
+	filterKmersToUnitigKmers(unitigs, reads, kmerSize, filterWithinUnitig, numThreads);
+	auto beforeRenumber = getTime();
+	sortKmersByUnitigs(unitigs, reads, numThreads);
 	printUnitigKmerCount(unitigs);
 	auto beforePaths = getTime();
-	std::vector<ReadPath> readPaths;
+	ReadPathStore readPaths;
 	std::cerr << "Getting read paths" << std::endl;
 	readPaths = getReadPaths(unitigs, reads, numThreads, partIterator, kmerSize);
 	auto beforeResolve = getTime();
+	std::unique_ptr<SpilledReadPaths> spilledPaths;
 	if (maxResolveLength > 0)
 	{
 		std::cerr << "Resolving unitigs" << std::endl;
 		std::cerr << unitigs.unitigs.size() << " unitigs before resolving" << std::endl;
-		std::tie(unitigs, readPaths) = resolveUnitigs(unitigs, reads, readPaths, partIterator, minUnitigCoverage, kmerSize, maxResolveLength, maxUnconditionalResolveLength, keepGaps, guesswork, copycountFilterHeuristic, onlyLocalResolve, doCleaning, std::cerr);
+		std::tie(unitigs, readPaths, spilledPaths) = resolveUnitigs(unitigs, reads, std::move(readPaths), partIterator, minUnitigCoverage, kmerSize, maxResolveLength, maxUnconditionalResolveLength, keepGaps, guesswork, copycountFilterHeuristic, onlyLocalResolve, doCleaning, numThreads, readPathFile, resolutionCheckpointFile, resolutionCheckpointInterval, resumeResolution, std::cerr);
 		std::cerr << unitigs.unitigs.size() << " unitigs after resolving" << std::endl;
 	}
 	auto beforeSequences = getTime();
 	std::cerr << "Building unitig sequences" << std::endl;
 	std::vector<CompressedSequenceType> unitigSequences;
 	StringIndex stringIndex;
-	std::tie(unitigSequences, stringIndex) = getHPCUnitigSequences(reads, unitigs, readPaths, kmerSize, partIterator, numThreads);
+	if (readPathFile != "")
+	{
+		if (spilledPaths == nullptr)
+		{
+			std::cerr << "Moving read paths to " << readPathFile << std::endl;
+			spilledPaths = std::make_unique<SpilledReadPaths>(readPathFile, std::move(readPaths), partIterator.getReadNames().size());
+		}
+		std::tie(unitigSequences, stringIndex) = getHPCUnitigSequences(reads, unitigs, *spilledPaths, kmerSize, partIterator, numThreads);
+	}
+	else
+	{
+		std::tie(unitigSequences, stringIndex) = getHPCUnitigSequences(reads, unitigs, readPaths, kmerSize, partIterator, numThreads);
+	}
 	assert(unitigSequences.size() == unitigs.unitigs.size());
 	auto beforeConsistency = getTime();
 	AssemblyStats stats;
-	verifyEdgeConsistency(unitigs, reads, stringIndex, unitigSequences, kmerSize);
+	if (validationEnabled(ValidationLevel::Full)) verifyEdgeConsistency(unitigs, reads, stringIndex, unitigSequences, kmerSize);
 	auto beforeWrite = getTime();
+	auto afterRawCoverages = beforeWrite;
 	if (blunt)
 	{
 		BluntGraph bluntGraph { reads, unitigs, unitigSequences, stringIndex, kmerSize };
@@ -1610,6 +1665,7 @@ void runMBG(const std::vector<std::string>& inputReads, const std::string& outpu
 	else
 	{
 		std::vector<double> unitigRawKmerCoverages = getRawKmerCoverages(unitigs, unitigSequences, reads, kmerSize);
+		afterRawCoverages = getTime();
 		std::cerr << "Writing graph to " << outputGraph << std::endl;
 		stats = writeGraph(unitigs, outputGraph, reads, unitigSequences, stringIndex, kmerSize, unitigRawKmerCoverages, nodeNamePrefix);
 	}
@@ -1622,8 +1678,15 @@ void runMBG(const std::vector<std::string>& inputReads, const std::string& outpu
 	if (outputSequencePaths != "")
 	{
 		std::cerr << "Writing paths to " << outputSequencePaths << std::endl;
-		sortPaths(readPaths);
-		writePaths(reads, unitigs, unitigSequences, stringIndex, unitigExpandedPoses, readPaths, kmerSize, outputSequencePaths, nodeNamePrefix);
+		if (spilledPaths != nullptr)
+		{
+			writePaths(reads, unitigs, unitigSequences, stringIndex, unitigExpandedPoses, *spilledPaths, partIterator.getReadNames(), kmerSize, outputSequencePaths, nodeNamePrefix);
+		}
+		else
+		{
+			sortPaths(readPaths, partIterator.getReadNames());
+			writePaths(reads, unitigs, unitigSequences, stringIndex, unitigExpandedPoses, readPaths, partIterator.getReadNames(), kmerSize, outputSequencePaths, nodeNamePrefix);
+		}
 	}
 	auto afterPaths = getTime();
 	if (outputHomologyMap != "")
@@ -1635,11 +1698,13 @@ void runMBG(const std::vector<std::string>& inputReads, const std::string& outpu
 	if (hpcVariantOnecopyCoverage != 0) std::cerr << "selecting hpc variant k-mers took " << formatTime(beforeVariants, beforeKmers) << std::endl;
 	std::cerr << "selecting k-mers and building graph topology took " << formatTime(beforeKmers, beforeUnitigs) << std::endl;
 	std::cerr << "unitigifying took " << formatTime(beforeUnitigs, beforeFilter) << std::endl;
-	std::cerr << "filtering unitigs took " << formatTime(beforeFilter, beforePaths) << std::endl;
+	std::cerr << "filtering unitigs took " << formatTime(beforeFilter, beforeRenumber) << std::endl;
+	std::cerr << "renumbering k-mers by unitigs took " << formatTime(beforeRenumber, beforePaths) << std::endl;
 	std::cerr << "getting read paths took " << formatTime(beforePaths, beforeResolve) << std::endl;
 	if (maxResolveLength > 0) std::cerr << "resolving unitigs took " << formatTime(beforeResolve, beforeSequences) << std::endl;
 	std::cerr << "building unitig sequences took " << formatTime(beforeSequences, beforeConsistency) << std::endl;
-	if (errorMasking != ErrorMasking::No && errorMasking != ErrorMasking::Collapse) std::cerr << "forcing edge consistency took " << formatTime(beforeConsistency, beforeWrite) << std::endl;
+	if (validationEnabled(ValidationLevel::Full)) std::cerr << "verifying edge consistency took " << formatTime(beforeConsistency, beforeWrite) << std::endl;
+	if (!blunt) std::cerr << "calculating raw k-mer coverages took " << formatTime(beforeWrite, afterRawCoverages) << std::endl;
 	std::cerr << "writing the graph and calculating stats took " << formatTime(beforeWrite, afterWrite) << std::endl;
 	if (outputSequencePaths != "") std::cerr << "writing sequence paths took " << formatTime(afterWrite, afterPaths) << std::endl;
 	if (outputHomologyMap != "") std::cerr << "writing homology map took " << formatTime(afterPaths, afterHomologyMap) << std::endl;
@@ -93,28 +93,7 @@ std::string revCompRaw(const std::string& raw)
 	std::string result { raw.rbegin(), raw.rend() };
 	for (size_t i = 0; i < result.size(); i++)
 	{
-		switch (result[i])
-		{
-			case 'a':
-			case 'A':
-				result[i] = 'T';
-				break;
-			case 'c':
-			case 'C':
-				result[i] = 'G';
-				break;
-			case 'g':
-			case 'G':
-				result[i] = 'C';
-				break;
-			case 't':
-			case 'T':
-				result[i] = 'A';
-				break;
-			default:
-				assert(false);
-				break;
-		}
+		result[i] = complementRaw(result[i]);
 	}
 	return result;
 }
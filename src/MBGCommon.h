@@ -3,6 +3,7 @@
 
 #include <fstream>
 #include <tuple>
+#include <cassert>
 #include <vector>
 #include "VectorView.h"
 #include "CompressedSequence.h"
@@ -14,7 +15,8 @@ using LengthType = size_t;
 using SequenceCharType = std::vector<CharType>;
 using SequenceLengthType = std::vector<LengthType>;
 using CompressedSequenceType = CompressedSequence;
-using ReadName = std::pair<std::string, size_t>;
+// read ordinal from ReadNameDictionary, and the start position of the read part
+using ReadName = std::pair<uint32_t, size_t>;
 
 HashType hash(VectorView<uint16_t> sequence);
 HashType hash(VectorView<uint16_t> sequence, VectorView<uint16_t> reverseSequence);
@@ -24,6 +26,28 @@ std::istream& operator>>(std::istream& is, HashType& t);
 std::pair<size_t, bool> reverse(std::pair<size_t, bool> pos);
 std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>> canon(std::pair<size_t, bool> from, std::pair<size_t, bool> to);
 std::string revCompRaw(const std::string& seq);
+// complement of a single raw nucleotide, inline since it is used per base in consensus
+inline char complementRaw(char base)
+{
+	switch (base)
+	{
+		case 'a':
+		case 'A':
+			return 'T';
+		case 'c':
+		case 'C':
+			return 'G';
+		case 'g':
+		case 'G':
+			return 'C';
+		case 't':
+		case 'T':
+			return 'A';
+		default:
+			assert(false);
+			return 'N';
+	}
+}
 std::vector<std::pair<size_t, bool>> revCompPath(const std::vector<std::pair<size_t, bool>>& original);
 
 class PalindromicKmer : std::exception {};
@@ -59,6 +83,13 @@ namespace std
 			return hash<std::string>{}(x.first) ^ hash<size_t>{}(x.second);
 		}
 	};
+	template <> struct hash<std::pair<uint32_t, size_t>>
+	{
+		size_t operator()(const std::pair<uint32_t, size_t>& x) const
+		{
+			return hash<size_t>{}(((size_t)x.first << 32) ^ x.second);
+		}
+	};
 	template <> struct hash<std::pair<HashType, bool>>
 	{
 		size_t operator()(std::pair<HashType, bool> x) const
@@ -7,6 +7,7 @@
 #include <tuple>
 #include <phmap.h>
 #include "VectorWithDirection.h"
+#include "ParallelHelper.h"
 
 template <typename SmallType, typename BigType>
 class MostlySparse2DHashmap
@@ -101,6 +102,72 @@ public:
 		std::sort(result.begin(), result.end(), [](std::pair<std::pair<size_t, bool>, BigType> left, std::pair<std::pair<size_t, bool>, BigType> right) { return left.first.first < right.first.first || (left.first.first == right.first.first && left.first.second < right.first.second); });
 		return result;
 	}
+	// copy where each stored key pair (from, to) is replaced by remapKey(from, to)
+	// remapKey must map distinct key pairs to distinct key pairs and the new keys must be < size()
+	template <typename F>
+	MostlySparse2DHashmap renumbered(F remapKey, const size_t numThreads) const
+	{
+		typedef std::tuple<std::pair<size_t, bool>, std::pair<size_t, bool>, BigType> KeyValue;
+		MostlySparse2DHashmap result;
+		result.resize(size());
+		const size_t rangeSize = getRangeSize(size(), numThreads);
+		const size_t numRanges = getNumRanges(size(), numThreads);
+		// buffers[thread][range] has the remapped values whose new from-key is in range
+		std::vector<std::vector<std::vector<KeyValue>>> buffers;
+		buffers.resize(numRanges);
+		for (size_t i = 0; i < numRanges; i++)
+		{
+			buffers[i].resize(numRanges);
+		}
+		iterateRangesMultithreaded(size(), numThreads, [this, &remapKey, &buffers, rangeSize](size_t thread, size_t start, size_t end)
+		{
+			for (size_t i = start; i < end; i++)
+			{
+				for (std::pair<size_t, bool> from : { std::make_pair(i, true), std::make_pair(i, false) })
+				{
+					for (auto value : getValues(from))
+					{
+						auto key = remapKey(from, value.first);
+						assert(key.first.first < size());
+						buffers[thread][key.first.first / rangeSize].emplace_back(key.first, key.second, value.second);
+					}
+				}
+			}
+		});
+		// the first small value of each from-key only touches that key's slots in firstKey and firstValue so ranges can fill them in parallel
+		// the rest go to the shared hashmap afterwards, in the same order as a single threaded loop would insert them
+		std::vector<std::vector<KeyValue>> leftovers;
+		leftovers.resize(numRanges);
+		iterateRangesMultithreaded(size(), numThreads, [&result, &buffers, &leftovers, numRanges](size_t range, size_t start, size_t end)
+		{
+			for (size_t thread = 0; thread < numRanges; thread++)
+			{
+				for (const KeyValue& item : buffers[thread][range])
+				{
+					std::pair<size_t, bool> from = std::get<0>(item);
+					std::pair<size_t, bool> to = std::get<1>(item);
+					BigType value = std::get<2>(item);
+					if (result.firstKey[from] == std::numeric_limits<uint32_t>::max() && result.pairToInt(to) < std::numeric_limits<uint32_t>::max() && value >= (BigType)std::numeric_limits<SmallType>::min() && value <= (BigType)std::numeric_limits<SmallType>::max())
+					{
+						result.firstKey[from] = result.pairToInt(to);
+						result.firstValue[from] = (SmallType)value;
+						continue;
+					}
+					leftovers[range].push_back(item);
+				}
+				std::vector<KeyValue> tmp;
+				std::swap(tmp, buffers[thread][range]);
+			}
+		});
+		for (size_t range = 0; range < numRanges; range++)
+		{
+			for (const KeyValue& item : leftovers[range])
+			{
+				result.set(std::get<0>(item), std::get<1>(item), std::get<2>(item));
+			}
+		}
+		return result;
+	}
 private:
 	uint32_t pairToInt(std::pair<size_t, bool> value) const
 	{
@@ -16,6 +16,10 @@ class MsatValueVector
 		MsatValueChunk& operator=(MsatValueChunk&& other);
 		~MsatValueChunk();
 		uint16_t get(uint8_t index) const;
+		bool has(uint8_t index) const
+		{
+			return (filledIndices >> (uint64_t)index) & 1;
+		}
 		size_t size() const;
 		void set(uint8_t index, uint16_t value);
 		void erase(uint8_t index);
@@ -27,6 +31,11 @@ class MsatValueVector
 public:
 	MsatValueVector() = default;
 	uint16_t get(size_t index) const;
+	// inline bit test of the chunk's fill mask, use before get() to skip the call for indices with no value
+	bool has(size_t index) const
+	{
+		return chunks[index / 64].has(index % 64);
+	}
 	void set(size_t index, uint16_t val);
 	void resize(size_t newSize);
 	void erase(size_t index);
@@ -0,0 +1,184 @@
+#ifndef ParallelHelper_h
+#define ParallelHelper_h
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+// size of the contiguous ranges which iterateRangesMultithreaded splits [0, size) into
+// item i belongs to range i / getRangeSize(size, numThreads)
+inline size_t getRangeSize(const size_t size, const size_t numThreads)
+{
+	size_t numRanges = std::max((size_t)1, numThreads);
+	return std::max((size_t)1, (size + numRanges - 1) / numRanges);
+}
+
+inline size_t getNumRanges(const size_t size, const size_t numThreads)
+{
+	size_t rangeSize = getRangeSize(size, numThreads);
+	return std::max((size_t)1, (size + rangeSize - 1) / rangeSize);
+}
+
+// calls callback(rangeIndex, start, end) for each range of [0, size), each range in its own thread
+template <typename F>
+void iterateRangesMultithreaded(const size_t size, const size_t numThreads, F callback)
+{
+	size_t rangeSize = getRangeSize(size, numThreads);
+	size_t numRanges = getNumRanges(size, numThreads);
+	if (numRanges == 1)
+	{
+		callback((size_t)0, (size_t)0, size);
+		return;
+	}
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < numRanges; i++)
+	{
+		size_t start = i * rangeSize;
+		size_t end = std::min(size, (i+1) * rangeSize);
+		threads.emplace_back([&callback, i, start, end]()
+		{
+			callback(i, start, end);
+		});
+	}
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+}
+
+// calls callback(start, end) for chunks of chunkSize items of [0, size)
+// threads take the next unprocessed chunk when they finish one, so chunks with uneven work are balanced between threads
+template <typename F>
+void iterateChunksMultithreaded(const size_t size, const size_t numThreads, const size_t chunkSize, F callback)
+{
+	assert(chunkSize > 0);
+	size_t numChunks = (size + chunkSize - 1) / chunkSize;
+	size_t useThreads = std::min(std::max((size_t)1, numThreads), numChunks);
+	if (useThreads <= 1)
+	{
+		for (size_t start = 0; start < size; start += chunkSize)
+		{
+			callback(start, std::min(size, start + chunkSize));
+		}
+		return;
+	}
+	std::atomic<size_t> nextChunk { 0 };
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < useThreads; i++)
+	{
+		threads.emplace_back([&callback, &nextChunk, numChunks, chunkSize, size]()
+		{
+			while (true)
+			{
+				size_t chunk = nextChunk++;
+				if (chunk >= numChunks) break;
+				callback(chunk * chunkSize, std::min(size, (chunk+1) * chunkSize));
+			}
+		});
+	}
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+}
+
+// sorts items with comp, which must be a strict total order so that the result does not depend on numThreads
+// ranges are sorted in their own threads and then merged pairwise, each merge of a round in its own thread
+template <typename T, typename Compare>
+void sortMultithreaded(std::vector<T>& items, const size_t numThreads, Compare comp)
+{
+	const size_t rangeSize = getRangeSize(items.size(), numThreads);
+	const size_t numRanges = getNumRanges(items.size(), numThreads);
+	iterateRangesMultithreaded(items.size(), numThreads, [&items, &comp](size_t range, size_t start, size_t end)
+	{
+		std::sort(items.begin() + start, items.begin() + end, comp);
+	});
+	if (numRanges == 1) return;
+	std::vector<T> merged;
+	merged.resize(items.size());
+	for (size_t width = rangeSize; width < items.size(); width *= 2)
+	{
+		const size_t numMerges = (items.size() + width * 2 - 1) / (width * 2);
+		iterateChunksMultithreaded(numMerges, numThreads, 1, [&items, &merged, &comp, width](size_t startMerge, size_t endMerge)
+		{
+			for (size_t merge = startMerge; merge < endMerge; merge++)
+			{
+				const size_t start = merge * width * 2;
+				const size_t mid = std::min(items.size(), start + width);
+				const size_t end = std::min(items.size(), start + width * 2);
+				std::merge(items.begin() + start, items.begin() + mid, items.begin() + mid, items.begin() + end, merged.begin() + start, comp);
+			}
+		});
+		std::swap(items, merged);
+	}
+}
+
+// one T per thread which calls local(), for collecting results from worker threads without a shared lock per item
+// the buffers can be read with getBuffers() once the worker threads are done
+template <typename T>
+class PerThreadBuffers
+{
+public:
+	PerThreadBuffers() :
+		serial(nextSerial()),
+		buffersMutex(),
+		buffers(),
+		bufferOfThread()
+	{
+	}
+	PerThreadBuffers(const PerThreadBuffers& other) = delete;
+	PerThreadBuffers& operator=(const PerThreadBuffers& other) = delete;
+	// the owning thread of each buffer is kept here, the thread local cache only skips the lock
+	// the cache remembers a few instances so threads alternating between instances don't keep locking
+	T& local()
+	{
+		thread_local std::array<std::pair<size_t, T*>, CacheSize> cache {};
+		thread_local size_t nextCacheSlot = 0;
+		for (size_t i = 0; i < CacheSize; i++)
+		{
+			if (cache[i].first == serial) return *cache[i].second;
+		}
+		T* result = nullptr;
+		{
+			std::lock_guard<std::mutex> lock { buffersMutex };
+			auto found = bufferOfThread.find(std::this_thread::get_id());
+			if (found != bufferOfThread.end())
+			{
+				result = found->second;
+			}
+			else
+			{
+				buffers.emplace_back(new T);
+				result = buffers.back().get();
+				bufferOfThread[std::this_thread::get_id()] = result;
+			}
+		}
+		cache[nextCacheSlot] = std::make_pair(serial, result);
+		nextCacheSlot = (nextCacheSlot + 1) % CacheSize;
+		return *result;
+	}
+	std::vector<std::unique_ptr<T>>& getBuffers()
+	{
+		return buffers;
+	}
+private:
+	static constexpr size_t CacheSize = 4;
+	static size_t nextSerial()
+	{
+		static std::atomic<size_t> counter { 1 };
+		return counter++;
+	}
+	size_t serial;
+	std::mutex buffersMutex;
+	std::vector<std::unique_ptr<T>> buffers;
+	std::unordered_map<std::thread::id, T*> bufferOfThread;
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include <cassert>
 #include "RankBitvector.h"
+#include "Validation.h"
 
 int popcount(uint64_t x)
 {
@@ -90,11 +91,14 @@ void RankBitvector::buildRanks()
 	}
 	assert(bigRanks.size() == (bits.size() + SmallRanksPerBig - 1) / SmallRanksPerBig);
 	ranksBuilt = true;
-	size_t runningRank = 0;
-	for (size_t i = 0; i < size(); i++)
+	if (validationEnabled(ValidationLevel::Full))
 	{
-		assert(getRank(i) == runningRank);
-		if (get(i)) runningRank += 1;
+		size_t runningRank = 0;
+		for (size_t i = 0; i < size(); i++)
+		{
+			assert(getRank(i) == runningRank);
+			if (get(i)) runningRank += 1;
+		}
 	}
 }
 
@@ -15,7 +15,9 @@ ReadpartIterator::ReadpartIterator(const size_t kmerSize, const size_t windowSiz
 	hpcVariants(),
 	cacheItems(0),
 	cacheBuilt(false),
-	cache2Built(false)
+	cache2Built(false),
+	memoryReads(),
+	memoryReadCount(0)
 {
 	if (includeEndSmers)
 	{
@@ -98,7 +100,7 @@ void ReadpartIterator::setMemoryReads(const std::vector<std::pair<std::string, s
 	memoryReads.clear();
 	for (size_t i = 0; i < rawSeqs.size(); i++)
 	{
-		iterateHashesOfRead(rawSeqs[i].first, rawSeqs[i].second, [this](const ReadInfo& read, const SequenceCharType& seq, const SequenceLengthType& poses, const std::string& rawSeq, const std::vector<size_t>& positions, const std::vector<HashType>& hashes)
+		iterateHashesOfRead(i, rawSeqs[i].first, rawSeqs[i].second, [this](const ReadInfo& read, const SequenceCharType& seq, const SequenceLengthType& poses, const std::string& rawSeq, const std::vector<size_t>& positions, const std::vector<HashType>& hashes)
 		{
 			memoryReads.emplace_back();
 			memoryReads.back().readInfo = read;
@@ -109,11 +111,12 @@ void ReadpartIterator::setMemoryReads(const std::vector<std::pair<std::string, s
 			memoryReads.back().hashes = hashes;
 		});
 	}
+	memoryReadCount = rawSeqs.size();
 }
 
 void ReadpartIterator::addMemoryRead(const std::pair<std::string, std::string>& seq)
 {
-	iterateHashesOfRead(seq.first, seq.second, [this](const ReadInfo& read, const SequenceCharType& seq, const SequenceLengthType& poses, const std::string& rawSeq, const std::vector<size_t>& positions, const std::vector<HashType>& hashes)
+	iterateHashesOfRead(memoryReadCount, seq.first, seq.second, [this](const ReadInfo& read, const SequenceCharType& seq, const SequenceLengthType& poses, const std::string& rawSeq, const std::vector<size_t>& positions, const std::vector<HashType>& hashes)
 	{
 		memoryReads.emplace_back();
 		memoryReads.back().readInfo = read;
@@ -123,9 +126,15 @@ void ReadpartIterator::addMemoryRead(const std::pair<std::string, std::string>&
 		memoryReads.back().positions = positions;
 		memoryReads.back().hashes = hashes;
 	});
+	memoryReadCount += 1;
 }
 
 void ReadpartIterator::setMemoryReadIterables(const std::vector<size_t>& iterables)
 {
 	memoryIterables = iterables;
 }
+
+const ReadNameDictionary& ReadpartIterator::getReadNames() const
+{
+	return readNames;
+}
@@ -14,6 +14,7 @@
 #include "FastHasher.h"
 #include "ErrorMaskHelper.h"
 #include "Serializer.h"
+#include "ReadNameDictionary.h"
 
 extern thread_local std::vector<size_t> memoryIterables;
 
@@ -99,20 +100,22 @@ public:
 	std::vector<HashType> hashes;
 };
 
+// reads get their ordinal in input order, which is the same on every pass over the files
+// names are stored in readNames on the first pass
 template <typename F>
-void iterateReadsMultithreaded(const std::vector<std::string>& files, const size_t numThreads, F readCallback)
+void iterateReadsMultithreaded(const std::vector<std::string>& files, const size_t numThreads, ReadNameDictionary& readNames, F readCallback)
 {
 	std::atomic<bool> readDone;
 	readDone = false;
 	std::vector<std::thread> threads;
-	moodycamel::ConcurrentQueue<std::shared_ptr<FastQ>> sequenceQueue;
+	moodycamel::ConcurrentQueue<std::pair<std::shared_ptr<FastQ>, uint32_t>> sequenceQueue;
 	for (size_t i = 0; i < numThreads; i++)
 	{
 		threads.emplace_back([&readDone, &sequenceQueue, readCallback, i]()
 		{
 			while (true)
 			{
-				std::shared_ptr<FastQ> read;
+				std::pair<std::shared_ptr<FastQ>, uint32_t> read;
 				if (!sequenceQueue.try_dequeue(read))
 				{
 					bool tryBreaking = readDone;
@@ -123,22 +126,25 @@ void iterateReadsMultithreaded(const std::vector<std::string>& files, const size
 						continue;
 					}
 				}
-				assert(read != nullptr);
+				assert(read.first != nullptr);
 				ReadInfo info;
-				info.readName.first = read->seq_id;
+				info.readName.first = read.second;
 				info.readName.second = 0;
-				info.readLength = read->sequence.size();
-				readCallback(info, read->sequence);
+				info.readLength = read.first->sequence.size();
+				readCallback(info, read.first->sequence);
 			}
 		});
 	}
+	size_t nextOrdinal = 0;
 	for (const std::string& filename : files)
 	{
 		std::cerr << "Reading sequences from " << filename << std::endl;
-		FastQ::streamFastqFromFile(filename, false, [&sequenceQueue](FastQ& read)
+		FastQ::streamFastqFromFile(filename, false, [&sequenceQueue, &readNames, &nextOrdinal](FastQ& read)
 		{
-			std::shared_ptr<FastQ> ptr = std::make_shared<FastQ>();
-			std::swap(*ptr, read);
+			readNames.setName(nextOrdinal, read.seq_id);
+			std::pair<std::shared_ptr<FastQ>, uint32_t> ptr { std::make_shared<FastQ>(), nextOrdinal };
+			nextOrdinal += 1;
+			std::swap(*ptr.first, read);
 			bool queued = sequenceQueue.try_enqueue(ptr);
 			if (queued) return;
 			size_t triedSleeping = 0;
@@ -213,10 +219,11 @@ public:
 		}
 	}
 	template <typename F>
-	void iterateHashesOfRead(const std::string& name, const std::string& seq, F callback) const
+	void iterateHashesOfRead(const size_t ordinal, const std::string& name, const std::string& seq, F callback) const
 	{
+		readNames.setName(ordinal, name);
 		ReadInfo info;
-		info.readName.first = name;
+		info.readName.first = ordinal;
 		info.readName.second = 0;
 		info.readLength = seq.size();
 		errorMask(info, seq, [this, callback](const ReadInfo& read, const SequenceCharType& seq, const SequenceLengthType& poses, const std::string& rawSeq)
@@ -225,10 +232,11 @@ public:
 		});
 	}
 	template <typename F>
-	void iteratePartsOfRead(const std::string& name, const std::string& seq, F callback) const
+	void iteratePartsOfRead(const size_t ordinal, const std::string& name, const std::string& seq, F callback) const
 	{
+		readNames.setName(ordinal, name);
 		ReadInfo info;
-		info.readName.first = name;
+		info.readName.first = ordinal;
 		info.readName.second = 0;
 		info.readLength = seq.size();
 		errorMask(info, seq, callback);
@@ -239,6 +247,7 @@ public:
 	void setMemoryReads(const std::vector<std::pair<std::string, std::string>>& rawSeqs);
 	void addMemoryRead(const std::pair<std::string, std::string>& seq);
 	void setMemoryReadIterables(const std::vector<size_t>& iterables);
+	const ReadNameDictionary& getReadNames() const;
 private:
 	const size_t kmerSize;
 	const size_t windowSize;
@@ -252,6 +261,9 @@ private:
 	mutable bool cacheBuilt;
 	mutable bool cache2Built;
 	std::vector<ReadBundle> memoryReads;
+	// memory reads are given ordinals by their index in setMemoryReads and addMemoryRead order
+	size_t memoryReadCount;
+	mutable ReadNameDictionary readNames;
 	void collectEndSmers();
 	template <typename F>
 	void iteratePartsFromMemory(F callback) const
@@ -606,7 +618,7 @@ private:
 			Serializer::readMostlyTwobits(cache, readInfo->seq);
 			Serializer::readMonotoneIncreasing(cache, readInfo->poses);
 			Serializer::readTwobits(cache, readInfo->rawSeq);
-			std::string tmp;
+			uint32_t tmp;
 			Serializer::read(cachePart2, tmp);
 			if (tmp != readInfo->readInfo.readName.first)
 			{
@@ -773,13 +785,13 @@ private:
 						else
 						{
 							std::cerr << "The genome has a palindromic k-mer. Cannot build a graph. Try running with a different -w" << std::endl;
-							std::cerr << "Example read around the palindromic k-mer: " << read.readName.first << std::endl;
+							std::cerr << "Example read around the palindromic k-mer: " << readNames.getName(read.readName.first) << std::endl;
 							std::abort();
 						}
 					}
 					else
 					{
-						std::cerr << "Unhashable k-mer around read: " << read.readName.first << std::endl;
+						std::cerr << "Unhashable k-mer around read: " << readNames.getName(read.readName.first) << std::endl;
 						std::abort();
 					}
 				}
@@ -833,7 +845,7 @@ private:
 	template <typename F>
 	void iteratePartsFromFiles(F callback) const
 	{
-		iterateReadsMultithreaded(readFiles, numThreads, [this, callback](ReadInfo& read, const std::string& rawSeq)
+		iterateReadsMultithreaded(readFiles, numThreads, readNames, [this, callback](ReadInfo& read, const std::string& rawSeq)
 		{
 			if (rawSeq.size() < 32) return;
 			errorMask(read, rawSeq, callback);
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include "ReadNameDictionary.h"
+
+ReadNameDictionary::ReadNameDictionary() :
+	namesMutex(std::make_shared<std::mutex>()),
+	nameChars(),
+	nameStarts(1, 0)
+{
+}
+
+void ReadNameDictionary::setName(const size_t ordinal, const std::string& name)
+{
+	std::lock_guard<std::mutex> lock { *namesMutex };
+	if (ordinal+1 < nameStarts.size())
+	{
+		assert(name.size() == nameStarts[ordinal+1] - nameStarts[ordinal]);
+		assert(std::equal(name.begin(), name.end(), nameChars.begin() + nameStarts[ordinal]));
+		return;
+	}
+	assert(ordinal+1 == nameStarts.size());
+	assert(ordinal < (size_t)std::numeric_limits<uint32_t>::max());
+	nameChars.insert(nameChars.end(), name.begin(), name.end());
+	nameStarts.push_back(nameChars.size());
+}
+
+std::string ReadNameDictionary::getName(const size_t ordinal) const
+{
+	std::lock_guard<std::mutex> lock { *namesMutex };
+	assert(ordinal+1 < nameStarts.size());
+	return std::string { nameChars.begin() + nameStarts[ordinal], nameChars.begin() + nameStarts[ordinal+1] };
+}
+
+void ReadNameDictionary::writeName(std::ostream& stream, const size_t ordinal) const
+{
+	assert(ordinal+1 < nameStarts.size());
+	stream.write(nameChars.data() + nameStarts[ordinal], nameStarts[ordinal+1] - nameStarts[ordinal]);
+}
+
+size_t ReadNameDictionary::size() const
+{
+	std::lock_guard<std::mutex> lock { *namesMutex };
+	return nameStarts.size()-1;
+}
+
+std::vector<uint32_t> ReadNameDictionary::getSortedRanks() const
+{
+	std::lock_guard<std::mutex> lock { *namesMutex };
+	std::vector<uint32_t> order;
+	order.reserve(nameStarts.size()-1);
+	for (size_t i = 0; i+1 < nameStarts.size(); i++)
+	{
+		order.push_back(i);
+	}
+	std::stable_sort(order.begin(), order.end(), [this](uint32_t left, uint32_t right)
+	{
+		return std::lexicographical_compare(nameChars.begin() + nameStarts[left], nameChars.begin() + nameStarts[left+1], nameChars.begin() + nameStarts[right], nameChars.begin() + nameStarts[right+1], [](char a, char b) { return (unsigned char)a < (unsigned char)b; });
+	});
+	std::vector<uint32_t> result;
+	result.resize(order.size());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		result[order[i]] = i;
+	}
+	return result;
+}
@@ -0,0 +1,31 @@
+#ifndef ReadNameDictionary_h
+#define ReadNameDictionary_h
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// names of the input reads stored once, reads are referred to by their ordinal in input order everywhere else
+class ReadNameDictionary
+{
+public:
+	ReadNameDictionary();
+	// stores the name of read ordinal unless it is stored already, new ordinals must be stored in increasing order
+	// a read is given the same ordinal on every pass, so an ordinal which is already stored must have the same name
+	void setName(const size_t ordinal, const std::string& name);
+	std::string getName(const size_t ordinal) const;
+	// no locking or copying, only when no names are being added at the same time
+	void writeName(std::ostream& stream, const size_t ordinal) const;
+	size_t size() const;
+	// result[ordinal] is the position of the read when the names are sorted
+	std::vector<uint32_t> getSortedRanks() const;
+private:
+	std::shared_ptr<std::mutex> namesMutex;
+	std::vector<char> nameChars;
+	std::vector<size_t> nameStarts;
+};
+
+#endif
@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include "ReadPathStore.h"
+#include "ParallelHelper.h"
+#include "Serializer.h"
+
+void pushVarint(std::vector<uint8_t>& bytes, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		bytes.push_back((uint8_t)(value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	bytes.push_back((uint8_t)value);
+}
+
+uint64_t readVarint(const std::vector<uint8_t>& bytes, size_t& pos)
+{
+	uint64_t result = 0;
+	size_t shift = 0;
+	while (true)
+	{
+		assert(pos < bytes.size());
+		uint8_t byte = bytes[pos];
+		pos += 1;
+		result |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) break;
+		shift += 7;
+	}
+	return result;
+}
+
+uint32_t toUint32(size_t value)
+{
+	assert(value <= (size_t)std::numeric_limits<uint32_t>::max());
+	return (uint32_t)value;
+}
+
+ReadPathStore::ReadPathStore() :
+	pathOffsets(1, 0),
+	posOffsets(1, 0)
+{
+}
+
+ReadPathStore ReadPathStore::concatenate(std::vector<std::unique_ptr<ReadPathStore>>& parts, const size_t numThreads)
+{
+	std::vector<size_t> pathStart;
+	std::vector<size_t> nodeStart;
+	std::vector<size_t> posByteStart;
+	pathStart.resize(parts.size()+1, 0);
+	nodeStart.resize(parts.size()+1, 0);
+	posByteStart.resize(parts.size()+1, 0);
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		pathStart[i+1] = pathStart[i] + parts[i]->size();
+		nodeStart[i+1] = nodeStart[i] + parts[i]->nodes.size();
+		posByteStart[i+1] = posByteStart[i] + parts[i]->posBytes.size();
+	}
+	ReadPathStore result;
+	result.readOrdinals.resize(pathStart.back());
+	result.readPartStarts.resize(pathStart.back());
+	result.pathOffsets.resize(pathStart.back()+1);
+	result.nodes.resize(nodeStart.back());
+	result.posOffsets.resize(pathStart.back()+1);
+	result.posBytes.resize(posByteStart.back());
+	result.posCounts.resize(pathStart.back());
+	result.expandedStarts.resize(pathStart.back());
+	result.expandedEnds.resize(pathStart.back());
+	result.leftClips.resize(pathStart.back());
+	result.rightClips.resize(pathStart.back());
+	result.readLengths.resize(pathStart.back());
+	result.readLengthsHPC.resize(pathStart.back());
+	result.pathOffsets.back() = nodeStart.back();
+	result.posOffsets.back() = posByteStart.back();
+	iterateRangesMultithreaded(parts.size(), numThreads, [&result, &parts, &pathStart, &nodeStart, &posByteStart](size_t range, size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			result.appendPart(*parts[i], pathStart[i], nodeStart[i], posByteStart[i]);
+			ReadPathStore tmp;
+			std::swap(tmp, *parts[i]);
+		}
+	});
+	return result;
+}
+
+void ReadPathStore::appendPart(const ReadPathStore& part, size_t pathStart, size_t nodeStart, size_t posByteStart)
+{
+	std::copy(part.readOrdinals.begin(), part.readOrdinals.end(), readOrdinals.begin() + pathStart);
+	std::copy(part.readPartStarts.begin(), part.readPartStarts.end(), readPartStarts.begin() + pathStart);
+	std::copy(part.nodes.begin(), part.nodes.end(), nodes.begin() + nodeStart);
+	std::copy(part.posBytes.begin(), part.posBytes.end(), posBytes.begin() + posByteStart);
+	std::copy(part.posCounts.begin(), part.posCounts.end(), posCounts.begin() + pathStart);
+	std::copy(part.expandedStarts.begin(), part.expandedStarts.end(), expandedStarts.begin() + pathStart);
+	std::copy(part.expandedEnds.begin(), part.expandedEnds.end(), expandedEnds.begin() + pathStart);
+	std::copy(part.leftClips.begin(), part.leftClips.end(), leftClips.begin() + pathStart);
+	std::copy(part.rightClips.begin(), part.rightClips.end(), rightClips.begin() + pathStart);
+	std::copy(part.readLengths.begin(), part.readLengths.end(), readLengths.begin() + pathStart);
+	std::copy(part.readLengthsHPC.begin(), part.readLengthsHPC.end(), readLengthsHPC.begin() + pathStart);
+	for (size_t i = 0; i < part.size(); i++)
+	{
+		pathOffsets[pathStart + i] = nodeStart + part.pathOffsets[i];
+		posOffsets[pathStart + i] = posByteStart + part.posOffsets[i];
+	}
+}
+
+size_t ReadPathStore::size() const
+{
+	return readOrdinals.size();
+}
+
+void ReadPathStore::push_back(const ReadPath& path)
+{
+	assert(path.path.size() > 0);
+	assert(path.readPoses.size() > 0);
+	readOrdinals.push_back(path.readName.first);
+	readPartStarts.push_back(toUint32(path.readName.second));
+	nodes.insert(nodes.end(), path.path.begin(), path.path.end());
+	pathOffsets.push_back(nodes.size());
+	uint32_t lastPos = 0;
+	for (uint32_t pos : path.readPoses)
+	{
+		assert(pos >= lastPos);
+		pushVarint(posBytes, pos - lastPos);
+		lastPos = pos;
+	}
+	posOffsets.push_back(posBytes.size());
+	posCounts.push_back(toUint32(path.readPoses.size()));
+	expandedStarts.push_back(toUint32(path.expandedReadPosStart));
+	expandedEnds.push_back(toUint32(path.expandedReadPosEnd));
+	leftClips.push_back(toUint32(path.leftClip));
+	rightClips.push_back(toUint32(path.rightClip));
+	readLengths.push_back(toUint32(path.readLength));
+	readLengthsHPC.push_back(toUint32(path.readLengthHPC));
+}
+
+void ReadPathStore::push_back(const ReadPathStore& other, size_t index)
+{
+	assert(index < other.size());
+	readOrdinals.push_back(other.readOrdinals[index]);
+	readPartStarts.push_back(other.readPartStarts[index]);
+	nodes.insert(nodes.end(), other.nodes.begin() + other.pathOffsets[index], other.nodes.begin() + other.pathOffsets[index+1]);
+	pathOffsets.push_back(nodes.size());
+	posBytes.insert(posBytes.end(), other.posBytes.begin() + other.posOffsets[index], other.posBytes.begin() + other.posOffsets[index+1]);
+	posOffsets.push_back(posBytes.size());
+	posCounts.push_back(other.posCounts[index]);
+	expandedStarts.push_back(other.expandedStarts[index]);
+	expandedEnds.push_back(other.expandedEnds[index]);
+	leftClips.push_back(other.leftClips[index]);
+	rightClips.push_back(other.rightClips[index]);
+	readLengths.push_back(other.readLengths[index]);
+	readLengthsHPC.push_back(other.readLengthsHPC[index]);
+}
+
+ReadPath ReadPathStore::get(size_t index) const
+{
+	ReadPath result;
+	result.readName = readName(index);
+	result.path.insert(result.path.end(), nodes.begin() + pathOffsets[index], nodes.begin() + pathOffsets[index+1]);
+	result.readPoses = readPoses(index);
+	result.expandedReadPosStart = expandedStarts[index];
+	result.expandedReadPosEnd = expandedEnds[index];
+	result.leftClip = leftClips[index];
+	result.rightClip = rightClips[index];
+	result.readLength = readLengths[index];
+	result.readLengthHPC = readLengthsHPC[index];
+	return result;
+}
+
+ReadPathStore ReadPathStore::permuted(const std::vector<size_t>& order) const
+{
+	ReadPathStore result;
+	result.nodes.reserve(nodes.size());
+	result.posBytes.reserve(posBytes.size());
+	for (size_t i : order)
+	{
+		result.push_back(*this, i);
+	}
+	return result;
+}
+
+ReadName ReadPathStore::readName(size_t index) const
+{
+	return ReadName { readOrdinals[index], readPartStarts[index] };
+}
+
+VectorView<Node> ReadPathStore::path(size_t index) const
+{
+	return VectorView<Node> { nodes, pathOffsets[index], pathOffsets[index+1] };
+}
+
+std::vector<uint32_t> ReadPathStore::readPoses(size_t index) const
+{
+	std::vector<uint32_t> result;
+	result.reserve(posCounts[index]);
+	size_t pos = posOffsets[index];
+	uint32_t lastPos = 0;
+	while (pos < posOffsets[index+1])
+	{
+		lastPos += readVarint(posBytes, pos);
+		result.push_back(lastPos);
+	}
+	assert(result.size() == posCounts[index]);
+	return result;
+}
+
+size_t ReadPathStore::numReadPoses(size_t index) const
+{
+	return posCounts[index];
+}
+
+size_t ReadPathStore::firstReadPos(size_t index) const
+{
+	size_t pos = posOffsets[index];
+	return readVarint(posBytes, pos);
+}
+
+size_t ReadPathStore::expandedReadPosStart(size_t index) const
+{
+	return expandedStarts[index];
+}
+
+size_t ReadPathStore::expandedReadPosEnd(size_t index) const
+{
+	return expandedEnds[index];
+}
+
+size_t ReadPathStore::leftClip(size_t index) const
+{
+	return leftClips[index];
+}
+
+size_t ReadPathStore::rightClip(size_t index) const
+{
+	return rightClips[index];
+}
+
+size_t ReadPathStore::readLength(size_t index) const
+{
+	return readLengths[index];
+}
+
+size_t ReadPathStore::readLengthHPC(size_t index) const
+{
+	return readLengthsHPC[index];
+}
+
+void ReadPathStore::setExpandedReadPosStart(size_t index, size_t value)
+{
+	expandedStarts[index] = toUint32(value);
+}
+
+void ReadPathStore::setExpandedReadPosEnd(size_t index, size_t value)
+{
+	expandedEnds[index] = toUint32(value);
+}
+
+bool ReadPathStore::pathLess(size_t left, size_t right) const
+{
+	return std::lexicographical_compare(nodes.begin() + pathOffsets[left], nodes.begin() + pathOffsets[left+1], nodes.begin() + pathOffsets[right], nodes.begin() + pathOffsets[right+1]);
+}
+
+bool ReadPathStore::pathEqual(size_t left, size_t right) const
+{
+	return std::equal(nodes.begin() + pathOffsets[left], nodes.begin() + pathOffsets[left+1], nodes.begin() + pathOffsets[right], nodes.begin() + pathOffsets[right+1], [](const Node& a, const Node& b) { return !(a < b) && !(b < a); });
+}
+
+void ReadPathStore::write(std::ostream& stream) const
+{
+	Serializer::write(stream, readOrdinals);
+	Serializer::write(stream, readPartStarts);
+	Serializer::write(stream, pathOffsets);
+	Serializer::write(stream, nodes);
+	Serializer::write(stream, posOffsets);
+	Serializer::write(stream, posBytes);
+	Serializer::write(stream, posCounts);
+	Serializer::write(stream, expandedStarts);
+	Serializer::write(stream, expandedEnds);
+	Serializer::write(stream, leftClips);
+	Serializer::write(stream, rightClips);
+	Serializer::write(stream, readLengths);
+	Serializer::write(stream, readLengthsHPC);
+}
+
+void ReadPathStore::read(std::istream& stream)
+{
+	Serializer::read(stream, readOrdinals);
+	Serializer::read(stream, readPartStarts);
+	Serializer::read(stream, pathOffsets);
+	Serializer::read(stream, nodes);
+	Serializer::read(stream, posOffsets);
+	Serializer::read(stream, posBytes);
+	Serializer::read(stream, posCounts);
+	Serializer::read(stream, expandedStarts);
+	Serializer::read(stream, expandedEnds);
+	Serializer::read(stream, leftClips);
+	Serializer::read(stream, rightClips);
+	Serializer::read(stream, readLengths);
+	Serializer::read(stream, readLengthsHPC);
+}
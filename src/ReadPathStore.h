@@ -0,0 +1,84 @@
+#ifndef ReadPathStore_h
+#define ReadPathStore_h
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include "MBGCommon.h"
+#include "VectorView.h"
+#include "Node.h"
+
+class ReadPath
+{
+public:
+	ReadName readName;
+	std::vector<Node> path;
+	std::vector<uint32_t> readPoses;
+	size_t expandedReadPosStart = 0;
+	size_t expandedReadPosEnd = 0;
+	size_t leftClip = 0;
+	size_t rightClip = 0;
+	size_t readLength = 0;
+	size_t readLengthHPC = 0;
+private:
+};
+
+// read paths stored column-wise instead of one ReadPath object per path
+// nodes and read positions of all paths are in shared arrays indexed by per-path offsets
+// read positions increase along a path and are stored as varint encoded differences to the previous position
+class ReadPathStore
+{
+public:
+	ReadPathStore();
+	// concatenation of parts in order, parts are cleared
+	static ReadPathStore concatenate(std::vector<std::unique_ptr<ReadPathStore>>& parts, const size_t numThreads);
+	size_t size() const;
+	void push_back(const ReadPath& path);
+	// copies path index of other without decoding it
+	void push_back(const ReadPathStore& other, size_t index);
+	ReadPath get(size_t index) const;
+	// copy where result[i] = this[order[i]]
+	ReadPathStore permuted(const std::vector<size_t>& order) const;
+	ReadName readName(size_t index) const;
+	VectorView<Node> path(size_t index) const;
+	std::vector<uint32_t> readPoses(size_t index) const;
+	size_t numReadPoses(size_t index) const;
+	size_t firstReadPos(size_t index) const;
+	size_t expandedReadPosStart(size_t index) const;
+	size_t expandedReadPosEnd(size_t index) const;
+	size_t leftClip(size_t index) const;
+	size_t rightClip(size_t index) const;
+	size_t readLength(size_t index) const;
+	size_t readLengthHPC(size_t index) const;
+	// different indices can be set from different threads at the same time
+	void setExpandedReadPosStart(size_t index, size_t value);
+	void setExpandedReadPosEnd(size_t index, size_t value);
+	// lexicographic comparison of the node paths
+	bool pathLess(size_t left, size_t right) const;
+	bool pathEqual(size_t left, size_t right) const;
+	void write(std::ostream& stream) const;
+	// replaces the contents with paths written by write
+	void read(std::istream& stream);
+private:
+	void appendPart(const ReadPathStore& part, size_t pathStart, size_t nodeStart, size_t posByteStart);
+	std::vector<uint32_t> readOrdinals;
+	std::vector<uint32_t> readPartStarts;
+	std::vector<size_t> pathOffsets;
+	std::vector<Node> nodes;
+	std::vector<size_t> posOffsets;
+	std::vector<uint8_t> posBytes;
+	std::vector<uint32_t> posCounts;
+	std::vector<uint32_t> expandedStarts;
+	std::vector<uint32_t> expandedEnds;
+	std::vector<uint32_t> leftClips;
+	std::vector<uint32_t> rightClips;
+	std::vector<uint32_t> readLengths;
+	std::vector<uint32_t> readLengthsHPC;
+};
+
+// little endian base 128, also used by the read path files
+void pushVarint(std::vector<uint8_t>& bytes, uint64_t value);
+uint64_t readVarint(const std::vector<uint8_t>& bytes, size_t& pos);
+
+#endif
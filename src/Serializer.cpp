@@ -11,6 +11,17 @@ namespace Serializer
 		stream.write((const char*)&value, sizeof(size_t));
 	}
 
+	// same width as size_t so read(uint32_t) can read it back
+	void write(std::ostream& stream, uint32_t value)
+	{
+		write(stream, (size_t)value);
+	}
+
+	void write(std::ostream& stream, double value)
+	{
+		stream.write((const char*)&value, sizeof(double));
+	}
+
 	void writeTwobits(std::ostream& stream, const std::string& value)
 	{
 		write(stream, value.size());
@@ -165,12 +176,38 @@ namespace Serializer
 		stream.read((char*)&value, sizeof(size_t));
 	}
 
+	void read(std::istream& stream, double& value)
+	{
+		stream.read((char*)&value, sizeof(double));
+	}
+
+	// 32-bit values are written with write(size_t)
+	void read(std::istream& stream, uint32_t& value)
+	{
+		size_t tmp = 0;
+		read(stream, tmp);
+		assert(tmp <= (size_t)std::numeric_limits<uint32_t>::max());
+		value = tmp;
+	}
+
 	void read(std::istream& stream, std::string& value)
 	{
-		size_t size;
+		size_t size = 0;
 		read(stream, size);
-		value.resize(size);
-		stream.read((char*)value.data(), value.size());
+		value.clear();
+		if (!stream.good()) return;
+		while (value.size() < size)
+		{
+			size_t start = value.size();
+			size_t count = std::min(ReadChunkBytes, size - start);
+			value.resize(start + count);
+			stream.read((char*)value.data() + start, count);
+			if (!stream.good())
+			{
+				value.clear();
+				return;
+			}
+		}
 	}
 
 	void readTwobits(std::istream& stream, std::string& value)
@@ -1,6 +1,7 @@
 #ifndef Serializer_h
 #define Serializer_h
 
+#include <algorithm>
 #include <fstream>
 #include <vector>
 #include <string>
@@ -12,6 +13,8 @@ namespace Serializer
 {
 
 	void write(std::ostream& stream, size_t value);
+	void write(std::ostream& stream, uint32_t value);
+	void write(std::ostream& stream, double value);
 	void writeMostlyTwobits(std::ostream& stream, const std::vector<uint16_t>& value);
 	void writeMonotoneIncreasing(std::ostream& stream, const std::vector<LengthType>& value);
 	template <typename T>
@@ -23,15 +26,34 @@ namespace Serializer
 	void writeTwobits(std::ostream& stream, const std::string& value);
 	void write(std::ostream& stream, const std::string& value);
 	void read(std::istream& stream, size_t& value);
+	void read(std::istream& stream, double& value);
+	void read(std::istream& stream, uint32_t& value);
 	void readMostlyTwobits(std::istream& stream, std::vector<uint16_t>& value);
 	void readMonotoneIncreasing(std::istream& stream, std::vector<LengthType>& value);
+	// lengths read from truncated or corrupted files can be garbage, so reads with a length grow their result as the data arrives
+	// a length past the end of the stream fails the stream instead of allocating it, and the result is left empty
+	const size_t ReadChunkBytes = 1024 * 1024;
 	template <typename T>
 	void read(std::istream& stream, std::vector<T>& value)
 	{
-		size_t size;
+		size_t size = 0;
 		read(stream, size);
-		value.resize(size);
-		stream.read((char*)value.data(), value.size() * sizeof(T));
+		value.clear();
+		if (!stream.good()) return;
+		const size_t chunkSize = std::max((size_t)1, ReadChunkBytes / sizeof(T));
+		value.reserve(std::min(size, chunkSize));
+		while (value.size() < size)
+		{
+			size_t start = value.size();
+			size_t count = std::min(chunkSize, size - start);
+			value.resize(start + count);
+			stream.read((char*)(value.data() + start), count * sizeof(T));
+			if (!stream.good())
+			{
+				value.clear();
+				return;
+			}
+		}
 	}
 	void readTwobits(std::istream& stream, std::string& value);
 	void read(std::istream& stream, std::string& value);
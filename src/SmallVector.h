@@ -0,0 +1,166 @@
+#ifndef SmallVector_h
+#define SmallVector_h
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+// vector which keeps up to InlineCapacity items inside the object and only allocates when it grows past that
+// items are always contiguous: either all in the inline array or all in the spill vector
+// erase swaps the last item into the erased position, so item order is not preserved over erases
+template <typename T, size_t InlineCapacity>
+class SmallVector
+{
+public:
+	SmallVector() :
+		numItems(0),
+		inlineItems(),
+		spill()
+	{
+	}
+	size_t size() const
+	{
+		return numItems;
+	}
+	T* begin()
+	{
+		return data();
+	}
+	T* end()
+	{
+		return data() + numItems;
+	}
+	const T* begin() const
+	{
+		return data();
+	}
+	const T* end() const
+	{
+		return data() + numItems;
+	}
+	T& operator[](size_t index)
+	{
+		assert(index < numItems);
+		return data()[index];
+	}
+	const T& operator[](size_t index) const
+	{
+		assert(index < numItems);
+		return data()[index];
+	}
+	void push_back(const T& item)
+	{
+		if (numItems < InlineCapacity)
+		{
+			inlineItems[numItems] = item;
+			numItems += 1;
+			return;
+		}
+		if (numItems == InlineCapacity)
+		{
+			spill.reserve(InlineCapacity * 2);
+			spill.insert(spill.end(), inlineItems, inlineItems + InlineCapacity);
+		}
+		spill.push_back(item);
+		numItems += 1;
+		assert(spill.size() == numItems);
+	}
+	void eraseAt(size_t index)
+	{
+		assert(index < numItems);
+		T* items = data();
+		items[index] = items[numItems-1];
+		numItems -= 1;
+		if (numItems < InlineCapacity) return;
+		spill.pop_back();
+		if (numItems == InlineCapacity)
+		{
+			for (size_t i = 0; i < InlineCapacity; i++) inlineItems[i] = spill[i];
+			std::vector<T> tmp;
+			std::swap(tmp, spill);
+		}
+	}
+	void clear()
+	{
+		numItems = 0;
+		std::vector<T> tmp;
+		std::swap(tmp, spill);
+	}
+private:
+	T* data()
+	{
+		if (numItems > InlineCapacity) return spill.data();
+		return inlineItems;
+	}
+	const T* data() const
+	{
+		if (numItems > InlineCapacity) return spill.data();
+		return inlineItems;
+	}
+	size_t numItems;
+	T inlineItems[InlineCapacity];
+	std::vector<T> spill;
+};
+
+// set with the same interface as the hash sets it replaces, for sets which usually have only a few items
+// lookups are linear scans, iteration is over a contiguous array
+template <typename T, size_t InlineCapacity>
+class SmallVectorSet
+{
+public:
+	size_t size() const
+	{
+		return items.size();
+	}
+	const T* begin() const
+	{
+		return items.begin();
+	}
+	const T* end() const
+	{
+		return items.end();
+	}
+	size_t count(const T& item) const
+	{
+		for (const T& other : items)
+		{
+			if (other == item) return 1;
+		}
+		return 0;
+	}
+	template <typename... Args>
+	void emplace(Args... args)
+	{
+		T item { args... };
+		if (count(item) == 1) return;
+		items.push_back(item);
+	}
+	template <typename Iter>
+	void insert(Iter start, Iter end)
+	{
+		for (Iter i = start; i != end; ++i)
+		{
+			emplace(*i);
+		}
+	}
+	size_t erase(const T& item)
+	{
+		for (size_t i = 0; i < items.size(); i++)
+		{
+			if (items[i] == item)
+			{
+				items.eraseAt(i);
+				return 1;
+			}
+		}
+		return 0;
+	}
+	void clear()
+	{
+		items.clear();
+	}
+private:
+	SmallVector<T, InlineCapacity> items;
+};
+
+#endif
@@ -0,0 +1,332 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include "SpilledReadPaths.h"
+#include "Serializer.h"
+
+const size_t ExpandedPosBytes = 2 * sizeof(uint32_t);
+
+void pushFixedUint32(std::vector<uint8_t>& bytes, size_t value)
+{
+	assert(value <= (size_t)std::numeric_limits<uint32_t>::max());
+	for (size_t i = 0; i < sizeof(uint32_t); i++)
+	{
+		bytes.push_back((uint8_t)(value >> (8 * i)));
+	}
+}
+
+uint32_t readFixedUint32(const std::vector<uint8_t>& bytes, size_t pos)
+{
+	assert(pos + sizeof(uint32_t) <= bytes.size());
+	uint32_t result = 0;
+	for (size_t i = 0; i < sizeof(uint32_t); i++)
+	{
+		result |= (uint32_t)bytes[pos + i] << (8 * i);
+	}
+	return result;
+}
+
+SpilledReadPaths::SpilledReadPaths(const std::string& fileName, const size_t numReads) :
+	fileName(fileName),
+	readFileOffset(),
+	numPaths(0),
+	nextRead(0),
+	writer(fileName, std::ios::binary),
+	files()
+{
+	assert(numReads <= (size_t)std::numeric_limits<uint32_t>::max());
+	readFileOffset.resize(numReads+1, 0);
+	if (!writer.good())
+	{
+		std::cerr << "Could not write read path file " << fileName << std::endl;
+		std::abort();
+	}
+}
+
+SpilledReadPaths::SpilledReadPaths(const std::string& fileName, ReadPathStore&& paths, const size_t numReads) :
+	SpilledReadPaths(fileName, numReads)
+{
+	std::vector<size_t> readPathStart;
+	readPathStart.resize(numReads+1, 0);
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		assert(paths.readName(i).first < numReads);
+		readPathStart[paths.readName(i).first+1] += 1;
+	}
+	for (size_t i = 0; i < numReads; i++)
+	{
+		readPathStart[i+1] += readPathStart[i];
+	}
+	std::vector<size_t> order;
+	order.resize(paths.size());
+	{
+		std::vector<size_t> nextPos { readPathStart.begin(), readPathStart.end()-1 };
+		for (size_t i = 0; i < paths.size(); i++)
+		{
+			order[nextPos[paths.readName(i).first]] = i;
+			nextPos[paths.readName(i).first] += 1;
+		}
+	}
+	std::vector<ReadPath> readPaths;
+	for (size_t read = 0; read < numReads; read++)
+	{
+		if (readPathStart[read+1] == readPathStart[read]) continue;
+		readPaths.clear();
+		for (size_t i = readPathStart[read]; i < readPathStart[read+1]; i++)
+		{
+			readPaths.push_back(paths.get(order[i]));
+		}
+		addRead(read, encodeRead(readPaths));
+	}
+	finishAdding();
+	ReadPathStore tmp;
+	std::swap(tmp, paths);
+}
+
+SpilledReadPaths::~SpilledReadPaths()
+{
+	remove(fileName.c_str());
+}
+
+std::vector<uint8_t> SpilledReadPaths::encodeRead(const std::vector<ReadPath>& paths)
+{
+	std::vector<uint8_t> result;
+	pushVarint(result, paths.size());
+	for (const ReadPath& path : paths)
+	{
+		pushFixedUint32(result, path.expandedReadPosStart);
+		pushFixedUint32(result, path.expandedReadPosEnd);
+	}
+	for (const ReadPath& path : paths) pushVarint(result, path.readName.second);
+	for (const ReadPath& path : paths) pushVarint(result, path.leftClip);
+	for (const ReadPath& path : paths) pushVarint(result, path.rightClip);
+	for (const ReadPath& path : paths) pushVarint(result, path.readLength);
+	for (const ReadPath& path : paths) pushVarint(result, path.readLengthHPC);
+	for (const ReadPath& path : paths) pushVarint(result, path.path.size());
+	for (const ReadPath& path : paths) pushVarint(result, path.readPoses.size());
+	for (const ReadPath& path : paths)
+	{
+		assert(path.path.size() > 0);
+		for (const Node node : path.path)
+		{
+			pushVarint(result, node.id() * 2 + (node.forward() ? 1 : 0));
+		}
+	}
+	for (const ReadPath& path : paths)
+	{
+		assert(path.readPoses.size() > 0);
+		uint32_t lastPos = 0;
+		for (uint32_t pos : path.readPoses)
+		{
+			assert(pos >= lastPos);
+			pushVarint(result, pos - lastPos);
+			lastPos = pos;
+		}
+	}
+	return result;
+}
+
+void SpilledReadPaths::addRead(uint32_t readOrdinal, const std::vector<uint8_t>& block)
+{
+	assert(writer.is_open());
+	assert(readOrdinal >= nextRead);
+	assert(readOrdinal < numReads());
+	size_t pos = 0;
+	size_t count = readVarint(block, pos);
+	uint64_t offset = readFileOffset[nextRead];
+	while (nextRead <= readOrdinal)
+	{
+		readFileOffset[nextRead] = offset;
+		nextRead += 1;
+	}
+	readFileOffset[nextRead] = offset + block.size();
+	numPaths += count;
+	writer.write((const char*)block.data(), block.size());
+}
+
+void SpilledReadPaths::finishAdding()
+{
+	assert(writer.is_open());
+	for (size_t i = nextRead+1; i < readFileOffset.size(); i++)
+	{
+		readFileOffset[i] = readFileOffset[nextRead];
+	}
+	nextRead = numReads();
+	writer.close();
+	if (!writer.good())
+	{
+		std::cerr << "Could not write read path file " << fileName << std::endl;
+		std::abort();
+	}
+}
+
+size_t SpilledReadPaths::size() const
+{
+	return numPaths;
+}
+
+size_t SpilledReadPaths::numReads() const
+{
+	return readFileOffset.size()-1;
+}
+
+std::fstream& SpilledReadPaths::localFile() const
+{
+	assert(!writer.is_open());
+	std::fstream& file = files.local();
+	if (!file.is_open()) file.open(fileName, std::ios::in | std::ios::out | std::ios::binary);
+	return file;
+}
+
+std::vector<std::pair<size_t, ReadPath>> SpilledReadPaths::getPaths(const uint32_t readOrdinal) const
+{
+	std::vector<std::pair<size_t, ReadPath>> result;
+	assert(readOrdinal < numReads());
+	const uint64_t blockStart = readFileOffset[readOrdinal];
+	if (readFileOffset[readOrdinal+1] == blockStart) return result;
+	std::vector<uint8_t> block;
+	block.resize(readFileOffset[readOrdinal+1] - blockStart);
+	std::fstream& file = localFile();
+	file.seekg(blockStart);
+	file.read((char*)block.data(), block.size());
+	if (!file.good())
+	{
+		std::cerr << "Read path file " << fileName << " has been corrupted" << std::endl;
+		std::abort();
+	}
+	size_t pos = 0;
+	const size_t count = readVarint(block, pos);
+	result.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		result[i].first = blockStart + pos;
+		result[i].second.readName.first = readOrdinal;
+		result[i].second.expandedReadPosStart = readFixedUint32(block, pos);
+		result[i].second.expandedReadPosEnd = readFixedUint32(block, pos + sizeof(uint32_t));
+		pos += ExpandedPosBytes;
+	}
+	for (auto& path : result) path.second.readName.second = readVarint(block, pos);
+	for (auto& path : result) path.second.leftClip = readVarint(block, pos);
+	for (auto& path : result) path.second.rightClip = readVarint(block, pos);
+	for (auto& path : result) path.second.readLength = readVarint(block, pos);
+	for (auto& path : result) path.second.readLengthHPC = readVarint(block, pos);
+	for (auto& path : result) path.second.path.resize(readVarint(block, pos));
+	for (auto& path : result) path.second.readPoses.resize(readVarint(block, pos));
+	for (auto& path : result)
+	{
+		for (size_t i = 0; i < path.second.path.size(); i++)
+		{
+			uint64_t node = readVarint(block, pos);
+			path.second.path[i] = Node { node / 2, (node & 1) == 1 };
+		}
+	}
+	for (auto& path : result)
+	{
+		uint32_t lastPos = 0;
+		for (size_t i = 0; i < path.second.readPoses.size(); i++)
+		{
+			lastPos += readVarint(block, pos);
+			path.second.readPoses[i] = lastPos;
+		}
+	}
+	if (pos != block.size())
+	{
+		std::cerr << "Read path file " << fileName << " has been corrupted" << std::endl;
+		std::abort();
+	}
+	return result;
+}
+
+std::vector<std::pair<size_t, ReadPath>> SpilledReadPaths::getPaths(const ReadName& readName) const
+{
+	std::vector<std::pair<size_t, ReadPath>> result = getPaths(readName.first);
+	size_t kept = 0;
+	for (size_t i = 0; i < result.size(); i++)
+	{
+		if (result[i].second.readName != readName) continue;
+		if (kept != i) std::swap(result[kept], result[i]);
+		kept += 1;
+	}
+	result.resize(kept);
+	return result;
+}
+
+void SpilledReadPaths::writeExpandedPos(size_t offset, size_t value)
+{
+	assert(offset + sizeof(uint32_t) <= readFileOffset.back());
+	std::vector<uint8_t> bytes;
+	pushFixedUint32(bytes, value);
+	std::fstream& file = localFile();
+	file.seekp(offset);
+	file.write((const char*)bytes.data(), bytes.size());
+	// flushed right away so reads through the other threads' streams see it
+	file.flush();
+	if (!file.good())
+	{
+		std::cerr << "Could not write read path file " << fileName << std::endl;
+		std::abort();
+	}
+}
+
+void SpilledReadPaths::setExpandedReadPosStart(size_t index, size_t value)
+{
+	writeExpandedPos(index, value);
+}
+
+void SpilledReadPaths::setExpandedReadPosEnd(size_t index, size_t value)
+{
+	writeExpandedPos(index + sizeof(uint32_t), value);
+}
+
+void SpilledReadPaths::write(std::ostream& stream) const
+{
+	Serializer::write(stream, readFileOffset);
+	Serializer::write(stream, numPaths);
+	std::fstream& file = localFile();
+	file.seekg(0);
+	std::vector<char> buffer;
+	for (uint64_t pos = 0; pos < readFileOffset.back(); pos += buffer.size())
+	{
+		buffer.resize(std::min((uint64_t)Serializer::ReadChunkBytes, readFileOffset.back() - pos));
+		file.read(buffer.data(), buffer.size());
+		if (!file.good())
+		{
+			std::cerr << "Read path file " << fileName << " has been corrupted" << std::endl;
+			std::abort();
+		}
+		stream.write(buffer.data(), buffer.size());
+	}
+}
+
+bool SpilledReadPaths::read(std::istream& stream)
+{
+	assert(writer.is_open());
+	std::vector<uint64_t> offsets;
+	Serializer::read(stream, offsets);
+	Serializer::read(stream, numPaths);
+	if (!stream.good()) return false;
+	if (offsets.size() != readFileOffset.size() || offsets[0] != 0) return false;
+	for (size_t i = 1; i < offsets.size(); i++)
+	{
+		if (offsets[i] < offsets[i-1]) return false;
+	}
+	std::vector<char> buffer;
+	for (uint64_t pos = 0; pos < offsets.back(); pos += buffer.size())
+	{
+		buffer.resize(std::min((uint64_t)Serializer::ReadChunkBytes, offsets.back() - pos));
+		stream.read(buffer.data(), buffer.size());
+		if (!stream.good()) return false;
+		writer.write(buffer.data(), buffer.size());
+	}
+	readFileOffset = offsets;
+	nextRead = numReads();
+	writer.close();
+	if (!writer.good())
+	{
+		std::cerr << "Could not write read path file " << fileName << std::endl;
+		std::abort();
+	}
+	return true;
+}
@@ -0,0 +1,55 @@
+#ifndef SpilledReadPaths_h
+#define SpilledReadPaths_h
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "MBGCommon.h"
+#include "ReadPathStore.h"
+#include "ParallelHelper.h"
+
+// read paths moved out of memory into a temporary file as one block per read, in increasing read ordinal order
+// only the file offsets of the blocks are kept in memory, block of read i is [readFileOffset[i], readFileOffset[i+1])
+// a block is columnar: path count, fixed width expanded read positions, then varint columns of part starts, clips, lengths, node counts, position counts, nodes and position differences
+// the expanded read positions are fixed width so they can be overwritten in place, path indices are file offsets of them
+class SpilledReadPaths
+{
+public:
+	// counting sort by read ordinal, stable so the paths of a read keep their order from paths
+	SpilledReadPaths(const std::string& fileName, ReadPathStore&& paths, const size_t numReads);
+	// empty file, reads are added with addRead
+	SpilledReadPaths(const std::string& fileName, const size_t numReads);
+	~SpilledReadPaths();
+	SpilledReadPaths(const SpilledReadPaths& other) = delete;
+	SpilledReadPaths& operator=(const SpilledReadPaths& other) = delete;
+	// block of non-empty paths of one read for addRead, can be called from multiple threads
+	static std::vector<uint8_t> encodeRead(const std::vector<ReadPath>& paths);
+	// reads must be added in increasing ordinal order, and finishAdding called before reading any
+	void addRead(uint32_t readOrdinal, const std::vector<uint8_t>& block);
+	void finishAdding();
+	size_t size() const;
+	size_t numReads() const;
+	// (index, path) of all paths of the read part, can be called from multiple threads
+	std::vector<std::pair<size_t, ReadPath>> getPaths(const ReadName& readName) const;
+	// all parts of the read, in block order
+	std::vector<std::pair<size_t, ReadPath>> getPaths(const uint32_t readOrdinal) const;
+	// different indices can be set from different threads at the same time
+	void setExpandedReadPosStart(size_t index, size_t value);
+	void setExpandedReadPosEnd(size_t index, size_t value);
+	void write(std::ostream& stream) const;
+	// replaces the contents with paths written by write, false if the stream is inconsistent
+	bool read(std::istream& stream);
+private:
+	void writeExpandedPos(size_t offset, size_t value);
+	std::fstream& localFile() const;
+	std::string fileName;
+	std::vector<uint64_t> readFileOffset;
+	size_t numPaths;
+	uint32_t nextRead;
+	std::ofstream writer;
+	mutable PerThreadBuffers<std::fstream> files;
+};
+
+#endif
@@ -1,28 +1,32 @@
 #include "StringIndex.h"
 #include "ErrorMaskHelper.h"
+#include "ParallelHelper.h"
 
 void StringIndex::init(size_t maxCode)
 {
 	index.resize(maxCode);
 }
 
-void StringIndex::buildReverseIndex()
+void StringIndex::buildReverseIndex(const size_t numThreads)
 {
 	reverseIndex.resize(index.size());
-	for (size_t i = 0; i < index.size(); i++)
+	iterateChunksMultithreaded(index.size(), numThreads, 1, [this](size_t start, size_t end)
 	{
-		reverseIndex[i].resize(index[i].size(), "");
-		for (auto pair : index[i])
+		for (size_t i = start; i < end; i++)
 		{
-			assert(reverseIndex[i][pair.second] == "");
-			assert(pair.second < reverseIndex[i].size());
-			reverseIndex[i][pair.second] = pair.first;
+			reverseIndex[i].resize(index[i].size(), "");
+			for (auto pair : index[i])
+			{
+				assert(reverseIndex[i][pair.second] == "");
+				assert(pair.second < reverseIndex[i].size());
+				reverseIndex[i][pair.second] = pair.first;
+			}
+			for (size_t j = 0; j < reverseIndex[i].size(); j++)
+			{
+				assert(reverseIndex[i][j] != "");
+			}
 		}
-		for (size_t j = 0; j < reverseIndex[i].size(); j++)
-		{
-			assert(reverseIndex[i][j] != "");
-		}
-	}
+	});
 }
 
 std::string StringIndex::getString(uint16_t compressed, uint32_t index) const
@@ -65,30 +69,48 @@ uint32_t StringIndex::getReverseIndex(uint16_t compressed, uint32_t index) const
 	return (index / 2) * 2 + (1 - (index % 2));
 }
 
-uint32_t StringIndex::getIndex(uint16_t compressed, std::variant<size_t, std::string> expanded)
+void assignExpanded(std::string& result, const std::string& raw, size_t start, size_t length, bool fw)
+{
+	assert(start + length <= raw.size());
+	if (fw)
+	{
+		result.assign(raw, start, length);
+		return;
+	}
+	result.resize(length);
+	for (size_t i = 0; i < length; i++)
+	{
+		result[i] = complementRaw(raw[start + length - 1 - i]);
+	}
+}
+
+uint32_t StringIndex::getIndex(uint16_t compressed, const std::string& raw, size_t start, size_t length, bool fw)
 {
 	if (compressed <= 3)
 	{
-		return std::get<size_t>(expanded);
+		return length;
 	}
 	if (complement(compressed) < compressed)
 	{
 		compressed = complement(compressed);
-		expanded = revCompRaw(std::get<std::string>(expanded));
+		fw = !fw;
 	}
+	// keep the same key to reduce mallocs which destroy multithreading performance
+	thread_local std::string expanded;
+	assignExpanded(expanded, raw, start, length, fw);
 	uint32_t maybeResult = index[compressed].size();
-	auto found = index[compressed].find(std::get<std::string>(expanded));
+	auto found = index[compressed].find(expanded);
 	if (found != index[compressed].end())
 	{
 		return found->second;
 	}
-	index[compressed][std::get<std::string>(expanded)] = maybeResult;
+	index[compressed][expanded] = maybeResult;
 	// need to handle compressed sequences which are their own reverse complement
 	if (complement(compressed) == compressed)
 	{
-		std::string revExpanded = revCompRaw(std::get<std::string>(expanded));
+		std::string revExpanded = revCompRaw(expanded);
 		// ...and need to make sure that if the expanded sequence is its own reverse complement it doesn't break anything
-		if (revExpanded == std::get<std::string>(expanded)) revExpanded = revExpanded + "_";
+		if (revExpanded == expanded) revExpanded = revExpanded + "_";
 		assert(index[compressed].count(revExpanded) == 0);
 		index[compressed][revExpanded] = maybeResult+1;
 	}
@@ -1,7 +1,6 @@
 #ifndef StringIndex_h
 #define StringIndex_h
 
-#include <variant>
 #include <vector>
 #include <string>
 #include <phmap.h>
@@ -10,9 +9,13 @@ class StringIndex
 {
 public:
 	void init(size_t maxCode);
-	uint32_t getIndex(uint16_t compressed, std::variant<size_t, std::string> expanded);
+	// expanded sequence is raw[start, start+length), reverse complemented if !fw
+	// homopolymer codes are indexed by length, other codes are looked up without allocating unless the string is new
+	// not thread safe for codes above 3, callers lock per code pair (min(compressed, complement(compressed)))
+	uint32_t getIndex(uint16_t compressed, const std::string& raw, size_t start, size_t length, bool fw);
 	std::string getString(uint16_t compressed, uint32_t index) const;
-	void buildReverseIndex();
+	// codes are built in parallel, each code only touches its own maps
+	void buildReverseIndex(const size_t numThreads);
 	uint32_t getReverseIndex(uint16_t compressed, uint32_t index) const;
 private:
 	std::vector<phmap::flat_hash_map<std::string, uint32_t>> index;
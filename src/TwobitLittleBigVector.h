@@ -32,8 +32,7 @@ public:
 	}
 	BigType get(size_t i) const
 	{
-		auto got = bigs.get(i);
-		if (got != 65535) return got;
+		if (bigs.has(i)) return bigs.get(i);
 		size_t index = i / 4;
 		size_t offset = (i % 4) * 2;
 		return (littles[index] >> offset) & 3;
@@ -42,8 +41,7 @@ public:
 	{
 		if (v >= 0 && v <= 3)
 		{
-			auto got = bigs.get(i);
-			if (got != 65535) bigs.erase(i);
+			if (bigs.has(i)) bigs.erase(i);
 			size_t index = i / 4;
 			size_t offset = (i % 4) * 2;
 			uint8_t removeMask = ~(3 << offset);
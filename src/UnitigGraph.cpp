@@ -3,6 +3,7 @@
 #include <phmap.h>
 #include "MBGCommon.h"
 #include "UnitigGraph.h"
+#include "ParallelHelper.h"
 
 size_t UnitigGraph::edgeCoverage(size_t from, bool fromFw, size_t to, bool toFw) const
 {
@@ -275,16 +276,22 @@ UnitigGraph UnitigGraph::filterUnitigsByCoverage(const double filter, const bool
 	UnitigGraph filtered = filterNodes(kept);
 	return filtered;
 }
-void UnitigGraph::sort(const std::vector<size_t>& kmerMapping)
+void UnitigGraph::sort(const std::vector<size_t>& kmerMapping, const size_t numThreads)
 {
+	iterateRangesMultithreaded(unitigs.size(), numThreads, [this, &kmerMapping](size_t range, size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			for (size_t j = 0; j < unitigs[i].size(); j++)
+			{
+				unitigs[i][j].first = kmerMapping[unitigs[i][j].first];
+			}
+		}
+	});
 	std::vector<bool> swapOrientation;
 	swapOrientation.resize(unitigs.size(), false);
 	for (size_t i = 0; i < unitigs.size(); i++)
 	{
-		for (size_t j = 0; j < unitigs[i].size(); j++)
-		{
-			unitigs[i][j].first = kmerMapping[unitigs[i][j].first];
-		}
 		if (unitigs[i].size() == 1)
 		{
 			swapOrientation[i] = !unitigs[i][0].second;
@@ -315,60 +322,49 @@ void UnitigGraph::sort(const std::vector<size_t>& kmerMapping)
 	}
 	{
 		decltype(unitigs) newUnitigs;
+		decltype(leftClip) newLeftClip;
+		decltype(rightClip) newRightClip;
+		decltype(unitigCoverage) newUnitigCoverage;
 		newUnitigs.resize(unitigs.size());
-		for (size_t i = 0; i < unitigs.size(); i++)
+		newLeftClip.resize(leftClip.size());
+		newRightClip.resize(rightClip.size());
+		newUnitigCoverage.resize(unitigCoverage.size());
+		assert(leftClip.size() == unitigs.size());
+		assert(rightClip.size() == unitigs.size());
+		assert(unitigCoverage.size() == unitigs.size());
+		// each unitig moves to a distinct new index so ranges can be permuted independently
+		iterateRangesMultithreaded(unitigs.size(), numThreads, [this, &newUnitigs, &newLeftClip, &newRightClip, &newUnitigCoverage, &swapOrientation, &unitigMapping](size_t range, size_t start, size_t end)
 		{
-			if (swapOrientation[i])
+			for (size_t i = start; i < end; i++)
 			{
-				std::reverse(unitigs[i].begin(), unitigs[i].end());
-				for (size_t j = 0; j < unitigs[i].size(); j++)
+				if (swapOrientation[i])
 				{
-					unitigs[i][j].second = !unitigs[i][j].second;
+					std::reverse(unitigs[i].begin(), unitigs[i].end());
+					for (size_t j = 0; j < unitigs[i].size(); j++)
+					{
+						unitigs[i][j].second = !unitigs[i][j].second;
+					}
+					std::swap(leftClip[i], rightClip[i]);
+					std::reverse(unitigCoverage[i].begin(), unitigCoverage[i].end());
 				}
+				assert(unitigs[i][0].first < unitigs[i].back().first || unitigs[i].size() == 1);
+				std::swap(unitigs[i], newUnitigs[unitigMapping[i]]);
+				newLeftClip[unitigMapping[i]] = leftClip[i];
+				newRightClip[unitigMapping[i]] = rightClip[i];
+				std::swap(newUnitigCoverage[unitigMapping[i]], unitigCoverage[i]);
 			}
-			assert(unitigs[i][0].first < unitigs[i].back().first || unitigs[i].size() == 1);
-			std::swap(unitigs[i], newUnitigs[unitigMapping[i]]);
-		}
+		});
 		std::swap(unitigs, newUnitigs);
-	}
-	for (size_t i = 0; i < unitigs.size(); i++)
-	{
-		if (swapOrientation[i])
-		{
-			std::swap(leftClip[i], rightClip[i]);
-		}
-	}
-	{
-		decltype(leftClip) newLeftClip;
-		newLeftClip.resize(leftClip.size());
-		for (size_t i = 0; i < leftClip.size(); i++)
-		{
-			newLeftClip[unitigMapping[i]] = leftClip[i];
-		}
 		std::swap(leftClip, newLeftClip);
-	}
-	{
-		decltype(rightClip) newRightClip;
-		newRightClip.resize(rightClip.size());
-		for (size_t i = 0; i < rightClip.size(); i++)
-		{
-			newRightClip[unitigMapping[i]] = rightClip[i];
-		}
 		std::swap(rightClip, newRightClip);
-	}
-	{
-		decltype(unitigCoverage) newUnitigCoverage;
-		newUnitigCoverage.resize(unitigCoverage.size());
-		for (size_t i = 0; i < unitigCoverage.size(); i++)
-		{
-			if (swapOrientation[i])
-			{
-				std::reverse(unitigCoverage[i].begin(), unitigCoverage[i].end());
-			}
-			std::swap(newUnitigCoverage[unitigMapping[i]], unitigCoverage[i]);
-		}
 		std::swap(unitigCoverage, newUnitigCoverage);
 	}
+	auto remapKey = [&unitigMapping, &swapOrientation](std::pair<size_t, bool> from, std::pair<size_t, bool> to)
+	{
+		return canon(std::make_pair(unitigMapping[from.first], from.second ^ swapOrientation[from.first]), std::make_pair(unitigMapping[to.first], to.second ^ swapOrientation[to.first]));
+	};
+	// edges are not split by node so the edge list is rebuilt in its own thread while the coverages and overlaps are renumbered
+	std::thread edgeThread { [this, &unitigMapping, &swapOrientation]()
 	{
 		decltype(edges) newEdges;
 		newEdges.resize(edges.size());
@@ -384,51 +380,10 @@ void UnitigGraph::sort(const std::vector<size_t>& kmerMapping)
 			}
 		}
 		std::swap(newEdges, edges);
-	}
-	{
-		decltype(edgeCov) newEdgeCov;
-		newEdgeCov.resize(edgeCov.size());
-		for (size_t i = 0; i < newEdgeCov.size(); i++)
-		{
-			std::pair<size_t, bool> from { unitigMapping[i], true ^ swapOrientation[i] };
-			for (auto pair : edgeCov.getValues(std::make_pair(i, true)))
-			{
-				std::pair<size_t, bool> to { std::make_pair(unitigMapping[pair.first.first], pair.first.second ^ swapOrientation[pair.first.first]) };
-				auto key = canon(from, to);
-				newEdgeCov.set(key.first, key.second, pair.second);
-			}
-			from.second = !from.second;
-			for (auto pair : edgeCov.getValues(std::make_pair(i, false)))
-			{
-				std::pair<size_t, bool> to { std::make_pair(unitigMapping[pair.first.first], pair.first.second ^ swapOrientation[pair.first.first]) };
-				auto key = canon(from, to);
-				newEdgeCov.set(key.first, key.second, pair.second);
-			}
-		}
-		std::swap(newEdgeCov, edgeCov);
-	}
-	{
-		decltype(edgeOvlp) newEdgeOvlp;
-		newEdgeOvlp.resize(edgeOvlp.size());
-		for (size_t i = 0; i < newEdgeOvlp.size(); i++)
-		{
-			std::pair<size_t, bool> from { unitigMapping[i], true ^ swapOrientation[i] };
-			for (auto pair : edgeOvlp.getValues(std::make_pair(i, true)))
-			{
-				std::pair<size_t, bool> to { std::make_pair(unitigMapping[pair.first.first], pair.first.second ^ swapOrientation[pair.first.first]) };
-				auto key = canon(from, to);
-				newEdgeOvlp.set(key.first, key.second, pair.second);
-			}
-			from.second = !from.second;
-			for (auto pair : edgeOvlp.getValues(std::make_pair(i, false)))
-			{
-				std::pair<size_t, bool> to { std::make_pair(unitigMapping[pair.first.first], pair.first.second ^ swapOrientation[pair.first.first]) };
-				auto key = canon(from, to);
-				newEdgeOvlp.set(key.first, key.second, pair.second);
-			}
-		}
-		std::swap(newEdgeOvlp, edgeOvlp);
-	}
+	}};
+	edgeCov = edgeCov.renumbered(remapKey, numThreads);
+	edgeOvlp = edgeOvlp.renumbered(remapKey, numThreads);
+	edgeThread.join();
 	for (size_t i = 0; i < unitigs.size(); i++)
 	{
 		assert(unitigs[i].size() >= 1);
@@ -33,7 +33,7 @@ public:
 	size_t numNodes() const;
 	size_t numEdges() const;
 	UnitigGraph filterUnitigsByCoverage(const double filter, const bool keepGaps);
-	void sort(const std::vector<size_t>& kmerMapping);
+	void sort(const std::vector<size_t>& kmerMapping, const size_t numThreads);
 private:
 	bool isTipGap(const RankBitvector& kept, const std::pair<size_t, bool> start) const;
 	void keepReachableNewTips(const RankBitvector& kept, const VectorWithDirection<bool>& newlyTip, const std::pair<size_t, bool> start, const std::unordered_set<std::pair<size_t, bool>>& reachableTips, std::unordered_set<size_t>& newlyKept) const;
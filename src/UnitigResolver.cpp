@@ -1,5 +1,8 @@
 #include <iostream>
-#include <queue>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <unordered_set>
 #include <unordered_map>
 #include <phmap.h>
@@ -8,19 +11,15 @@
 #include "RankBitvector.h"
 #include "ReadHelper.h"
 #include "BigVectorSet.h"
+#include "ParallelHelper.h"
 #include "Node.h"
+#include "Serializer.h"
+#include "SmallVector.h"
+#include "ConcurrentUnionFind.h"
+#include "SpilledReadPaths.h"
 
 #define assertPrintReads(expression, graph, paths, node) {if (!(expression)) {printReads(graph, paths, node);} assert(expression);}
 
-struct ReadPathInfo
-{
-	std::vector<uint32_t> readPoses;
-	size_t expandedReadPosStart;
-	size_t expandedReadPosEnd;
-	size_t readLength;
-	size_t readLengthHPC;
-};
-
 struct ResolveTriplet
 {
 	ResolveTriplet() = default;
@@ -35,28 +34,72 @@ struct ResolveTriplet
 	size_t coverage;
 };
 
+// node and direction packed into 32 bits since path groups hold one of these per node of every distinct read path
+class PathNode
+{
+public:
+	PathNode() = default;
+	PathNode(size_t id, bool forward) :
+		first(id),
+		second(forward)
+	{
+		assert(id < (size_t)1 << 31);
+	}
+	PathNode(std::pair<size_t, bool> node) :
+		PathNode(node.first, node.second)
+	{
+	}
+	PathNode(Node node) :
+		PathNode(node.id(), node.forward())
+	{
+	}
+	operator std::pair<size_t, bool>() const
+	{
+		return std::make_pair((size_t)first, (bool)second);
+	}
+	bool operator==(const PathNode& other) const
+	{
+		return first == other.first && second == other.second;
+	}
+	bool operator!=(const PathNode& other) const
+	{
+		return !(*this == other);
+	}
+	bool operator<(const PathNode& other) const
+	{
+		if (first < other.first) return true;
+		if (first > other.first) return false;
+		return second < other.second;
+	}
+	uint32_t first : 31;
+	uint32_t second : 1;
+};
+
 class PathGroup
 {
 public:
+	// 32-bit fields since there are as many of these as raw read paths, all values come from the uint32_t fields of ReadPathStore or are bounded by them
 	class Read
 	{
 	public:
-		size_t readNameIndex;
-		size_t readInfoIndex;
-		size_t readPosZeroOffset;
-		size_t readPosStartIndex;
-		size_t readPosEndIndex;
-		size_t leftClip;
-		size_t rightClip;
+		uint32_t readNameIndex;
+		uint32_t readInfoIndex;
+		uint32_t readPosZeroOffset;
+		uint32_t readPosStartIndex;
+		uint32_t readPosEndIndex;
+		uint32_t leftClip;
+		uint32_t rightClip;
 	};
-	std::vector<std::pair<size_t, bool>> path;
+	std::vector<PathNode> path;
 	std::vector<Read> reads;
 };
 
+// iterates the crossing reads of a node from the back, skipping entries of erased paths
+// the entries are removed in bulk by ResolvableUnitigGraph::collectCrossingGarbage, so iterating never modifies the graph
 class ReadCrosserIterator
 {
 public:
-	ReadCrosserIterator(size_t index, std::vector<std::pair<uint32_t, uint32_t>>& vec, const std::vector<PathGroup>& paths) :
+	ReadCrosserIterator(size_t index, const std::vector<std::pair<uint32_t, uint32_t>>& vec, const std::vector<PathGroup>& paths) :
 		index(index),
 		vec(vec),
 		paths(paths)
@@ -84,50 +127,36 @@ public:
 				break;
 			}
 			index -= 1;
-			if (paths[vec[index].first].path.size() == 0 || paths[vec[index].first].reads.size() == 0)
-			{
-				std::swap(vec[index], vec.back());
-				vec.pop_back();
-				continue;
-			}
-			else
-			{
-				break;
-			}
+			if (!pathErased(vec[index].first)) break;
 		}
 		return *this;
 	}
 	void skipRemovedPaths()
 	{
-		while (index > 0 && (paths[vec[index].first].path.size() == 0 || paths[vec[index].first].reads.size() == 0))
-		{
-			std::swap(vec[index], vec.back());
-			vec.pop_back();
-			index--;
-		}
-		if (index == 0 && (paths[vec[index].first].path.size() == 0 || paths[vec[index].first].reads.size() == 0))
-		{
-			std::swap(vec[index], vec.back());
-			vec.pop_back();
-			index = std::numeric_limits<size_t>::max();
-		}
+		if (index == std::numeric_limits<size_t>::max()) return;
+		if (pathErased(vec[index].first)) ++(*this);
 	}
 private:
+	bool pathErased(size_t path) const
+	{
+		return paths[path].path.size() == 0 || paths[path].reads.size() == 0;
+	}
 	size_t index;
-	std::vector<std::pair<uint32_t, uint32_t>>& vec;
+	const std::vector<std::pair<uint32_t, uint32_t>>& vec;
 	const std::vector<PathGroup>& paths;
 };
 
 class ReadCrosserIteratorHelper
 {
 public:
-	ReadCrosserIteratorHelper(std::vector<std::pair<uint32_t, uint32_t>>& vec, const std::vector<PathGroup>& paths) :
+	ReadCrosserIteratorHelper(const std::vector<std::pair<uint32_t, uint32_t>>& vec, const std::vector<PathGroup>& paths) :
 		vec(vec),
 		paths(paths)
 	{
 	}
 	ReadCrosserIterator begin()
 	{
+		if (vec.size() == 0) return end();
 		auto result = ReadCrosserIterator { vec.size()-1, vec, paths };
 		result.skipRemovedPaths();
 		return result;
@@ -137,10 +166,96 @@ public:
 		return ReadCrosserIterator { std::numeric_limits<size_t>::max(), vec, paths };
 	}
 private:
-	std::vector<std::pair<uint32_t, uint32_t>>& vec;
+	const std::vector<std::pair<uint32_t, uint32_t>>& vec;
 	const std::vector<PathGroup>& paths;
 };
 
+const size_t CoveredKmersNotCounted = std::numeric_limits<size_t>::max();
+
+// read coverage of the (left, right) triplets through a node as counted by getRawTriplets, in the iteration order of the hash maps they were counted in
+// partCoverage also has the triplets of reads split at the node, only counted if partCounted
+struct RawTripletCoverage
+{
+	RawTripletCoverage() :
+		counted(false),
+		partCounted(false),
+		fwEdgeCount(0),
+		bwEdgeCount(0),
+		coverage(),
+		partCoverage()
+	{}
+	bool counted;
+	bool partCounted;
+	size_t fwEdgeCount;
+	size_t bwEdgeCount;
+	std::vector<std::pair<std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>>, size_t>> coverage;
+	std::vector<std::pair<std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>>, size_t>> partCoverage;
+};
+
+// values of the edges of ResolvableUnitigGraph keyed by canon(from, to)
+// stored per the first node of the canonical pair, so a lookup scans the few edges of one node end instead of hashing
+// entries are only removed by clear, like the map this replaces
+class EdgeValueIndex
+{
+public:
+	EdgeValueIndex() :
+		numValues(0)
+	{
+	}
+	size_t& operator[](const std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>> key)
+	{
+		if (key.first.first >= values.size()) values.resize(key.first.first+1);
+		auto& nodeValues = values[key.first];
+		for (auto& pair : nodeValues)
+		{
+			if (pair.first == key.second) return pair.second;
+		}
+		nodeValues.push_back(std::make_pair(key.second, (size_t)0));
+		numValues += 1;
+		return nodeValues[nodeValues.size()-1].second;
+	}
+	size_t at(const std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>> key) const
+	{
+		assert(key.first.first < values.size());
+		for (const auto& pair : values[key.first])
+		{
+			if (pair.first == key.second) return pair.second;
+		}
+		assert(false);
+		return 0;
+	}
+	// zero for edges which have no value
+	size_t get(const std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>> key) const
+	{
+		if (key.first.first >= values.size()) return 0;
+		for (const auto& pair : values[key.first])
+		{
+			if (pair.first == key.second) return pair.second;
+		}
+		return 0;
+	}
+	size_t size() const
+	{
+		return numValues;
+	}
+	size_t numNodes() const
+	{
+		return values.size();
+	}
+	const SmallVector<std::pair<std::pair<size_t, bool>, size_t>, 2>& getValuesFrom(const std::pair<size_t, bool> from) const
+	{
+		return values[from];
+	}
+	void clear()
+	{
+		values.clear();
+		numValues = 0;
+	}
+private:
+	VectorWithDirection<SmallVector<std::pair<std::pair<size_t, bool>, size_t>, 2>> values;
+	size_t numValues;
+};
+
 class ResolvableUnitigGraph
 {
 public:
@@ -153,14 +268,28 @@ public:
 	std::vector<std::vector<std::pair<size_t, bool>>> unitigs;
 	std::vector<size_t> unitigLeftClipBp;
 	std::vector<size_t> unitigRightClipBp;
-	VectorWithDirection<phmap::flat_hash_set<std::pair<size_t, bool>>> edges;
-	phmap::flat_hash_map<std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>>, size_t> overlaps;
+	VectorWithDirection<SmallVectorSet<std::pair<size_t, bool>, 2>> edges;
+	EdgeValueIndex overlaps;
+	// reads whose paths contain the edge, kept up to date by addPathCounts and erasePathCounts
+	EdgeValueIndex edgeReadCounts;
 	std::vector<bool> unitigRemoved;
-	mutable std::vector<std::vector<std::pair<uint32_t, uint32_t>>> readsCrossingNode;
+	// (path, index in path) of each path crossing the node, including erased paths until collectCrossingGarbage
+	std::vector<std::vector<std::pair<uint32_t, uint32_t>>> readsCrossingNode;
+	std::vector<size_t> liveCrossingCount;
+	std::vector<size_t> deadCrossingCount;
+	std::vector<size_t> nodesWithDeadCrossings;
 	std::vector<size_t> everTippable;
 	size_t lastTippableChecked;
 	mutable std::vector<size_t> precalcedUnitigLengths;
-	mutable std::vector<double> precalcedUnitigCoverages;
+	// kmers of the node covered by reads, summed over reads, kept up to date by addPathCounts and erasePathCounts
+	// CoveredKmersNotCounted if the node or its reads were changed in place and it must be recounted
+	mutable std::vector<size_t> coveredKmers;
+	// nodes whose crossing reads or edges were changed by path edits or removeEdgesAndNodes since clearChangedNodes
+	std::vector<bool> nodeChanged;
+	std::vector<size_t> changedNodes;
+	// triplet coverages kept over resolution rounds, cleared when the crossing reads of the node change or the node or its neighbors are changed in place
+	// a changed edge count of the node also makes the entry stale, checked in rawTripletsCached
+	mutable std::vector<RawTripletCoverage> rawTripletCache;
 	size_t getBpOverlap(const std::pair<size_t, bool> from, const std::pair<size_t, bool> to) const
 	{
 		size_t kmerOverlap = overlaps.at(canon(from, to));
@@ -219,66 +348,190 @@ public:
 	}
 	double getCoverage(const std::vector<PathGroup>& readPaths, size_t unitig) const
 	{
-		if (unitig >= precalcedUnitigCoverages.size())
-		{
-			assert(precalcedUnitigCoverages.size() < unitigs.size());
-			precalcedUnitigCoverages.resize(unitigs.size(), 0);
-		}
-		assert(unitig < precalcedUnitigCoverages.size());
-		if (precalcedUnitigCoverages[unitig] == 0)
+		assert(unitig < coveredKmers.size());
+		if (coveredKmers[unitig] == CoveredKmersNotCounted)
 		{
-			precalcedUnitigCoverages[unitig] = calculateCoverage(readPaths, unitig);
+			coveredKmers[unitig] = countCoveredKmers(readPaths, unitig);
 		}
-		assert(precalcedUnitigCoverages[unitig] != 0);
-		return precalcedUnitigCoverages[unitig];
+		return (double)coveredKmers[unitig] / (double)unitigs[unitig].size();
+	}
+	void invalidateCoverage(size_t unitig)
+	{
+		assert(unitig < coveredKmers.size());
+		coveredKmers[unitig] = CoveredKmersNotCounted;
+		// read clips, overlaps and unitig clips changed in place are also seen by the triplets of the neighbors
+		invalidateRawTriplets(unitig);
+		for (auto edge : edges[std::make_pair(unitig, true)]) invalidateRawTriplets(edge.first);
+		for (auto edge : edges[std::make_pair(unitig, false)]) invalidateRawTriplets(edge.first);
+	}
+	void invalidateRawTriplets(size_t node)
+	{
+		assert(node < rawTripletCache.size());
+		if (!rawTripletCache[node].counted) return;
+		RawTripletCoverage tmp;
+		std::swap(tmp, rawTripletCache[node]);
+	}
+	bool rawTripletsCached(size_t node, bool partTriplets) const
+	{
+		const RawTripletCoverage& cached = rawTripletCache[node];
+		if (!cached.counted) return false;
+		if (partTriplets && !cached.partCounted) return false;
+		if (cached.fwEdgeCount != edges[std::make_pair(node, true)].size()) return false;
+		if (cached.bwEdgeCount != edges[std::make_pair(node, false)].size()) return false;
+		return true;
 	}
 	const HashList& hashlist;
 	std::vector<ReadName> readNames;
 	double averageCoverage;
-	double calculateCoverage(const std::vector<PathGroup>& readPaths, size_t unitig) const
+	// kmers of path.path[j] covered by the reads of path
+	size_t pathCoveredKmers(const PathGroup& path, size_t j) const
+	{
+		const size_t unitigSize = unitigs[path.path[j].first].size();
+		size_t result = 0;
+		if (path.path.size() == 1)
+		{
+			for (const auto& read : path.reads)
+			{
+				assert(read.leftClip + read.rightClip < unitigSize);
+				result += unitigSize - read.leftClip - read.rightClip;
+			}
+			return result;
+		}
+		if (j > 0 && j < path.path.size()-1) return path.reads.size() * unitigSize;
+		for (const auto& read : path.reads)
+		{
+			const size_t clip = (j == 0) ? read.leftClip : read.rightClip;
+			assert(clip < unitigSize);
+			result += unitigSize - clip;
+		}
+		return result;
+	}
+	size_t countCoveredKmers(const std::vector<PathGroup>& readPaths, size_t unitig) const
 	{
-		double result = 0;
+		size_t result = 0;
 		for (const std::pair<uint32_t, uint32_t> pospair : iterateCrossingReads(unitig, readPaths))
 		{
-			const size_t i = pospair.first;
-			const size_t j = pospair.second;
-			assert(readPaths[i].path.size() > 0);
-			assert(readPaths[i].reads.size() > 0);
-			if (readPaths[i].path.size() == 1)
+			assert(readPaths[pospair.first].path[pospair.second].first == unitig);
+			result += pathCoveredKmers(readPaths[pospair.first], pospair.second);
+		}
+		return result;
+	}
+	void addPathCounts(const std::vector<PathGroup>& readPaths, size_t i)
+	{
+		for (size_t j = 0; j < readPaths[i].path.size(); j++)
+		{
+			const size_t node = readPaths[i].path[j].first;
+			readsCrossingNode[node].emplace_back(i, j);
+			liveCrossingCount[node] += 1;
+			markChanged(node);
+			if (coveredKmers[node] != CoveredKmersNotCounted) coveredKmers[node] += pathCoveredKmers(readPaths[i], j);
+		}
+		for (size_t j = 1; j < readPaths[i].path.size(); j++)
+		{
+			edgeReadCounts[canon(readPaths[i].path[j-1], readPaths[i].path[j])] += pathEdgeReadCount(readPaths[i], j);
+		}
+	}
+	// path i must not be modified between this and clearing it
+	void erasePathCounts(const std::vector<PathGroup>& readPaths, size_t i)
+	{
+		for (size_t j = 0; j < readPaths[i].path.size(); j++)
+		{
+			const size_t node = readPaths[i].path[j].first;
+			assert(liveCrossingCount[node] > 0);
+			liveCrossingCount[node] -= 1;
+			markChanged(node);
+			if (deadCrossingCount[node] == 0) nodesWithDeadCrossings.push_back(node);
+			deadCrossingCount[node] += 1;
+			if (coveredKmers[node] != CoveredKmersNotCounted)
 			{
-				assert(readPaths[i].path[0].first == unitig);
-				for (const auto& read : readPaths[i].reads)
-				{
-					assert(read.leftClip + read.rightClip < unitigs[readPaths[i].path[0].first].size());
-					result += (double)(unitigs[unitig].size() - read.leftClip - read.rightClip) / (double)(unitigs[unitig].size());
-				}
+				const size_t pathKmers = pathCoveredKmers(readPaths[i], j);
+				assert(coveredKmers[node] >= pathKmers);
+				coveredKmers[node] -= pathKmers;
 			}
-			else
+		}
+		for (size_t j = 1; j < readPaths[i].path.size(); j++)
+		{
+			const size_t pathReads = pathEdgeReadCount(readPaths[i], j);
+			size_t& edgeReads = edgeReadCounts[canon(readPaths[i].path[j-1], readPaths[i].path[j])];
+			assert(edgeReads >= pathReads);
+			edgeReads -= pathReads;
+		}
+	}
+	// reads of path supporting the edge from path.path[j-1] to path.path[j]
+	// an edge from a node end to its own reverse is seen from both of its ends, so it counts twice
+	size_t pathEdgeReadCount(const PathGroup& path, size_t j) const
+	{
+		if (path.path[j] == reverse(path.path[j-1])) return path.reads.size() * 2;
+		return path.reads.size();
+	}
+	void recountEdgeReads(const std::vector<PathGroup>& paths)
+	{
+		edgeReadCounts.clear();
+		for (size_t i = 0; i < paths.size(); i++)
+		{
+			if (paths[i].path.size() == 0 || paths[i].reads.size() == 0) continue;
+			for (size_t j = 1; j < paths[i].path.size(); j++)
 			{
-				if (j == 0)
-				{
-					for (const auto& read : readPaths[i].reads)
-					{
-						assert(read.leftClip < unitigs[unitig].size());
-						result += (double)(unitigs[unitig].size() - read.leftClip) / (double)(unitigs[unitig].size());
-					}
-				}
-				if (j > 0 && j < readPaths[i].path.size()-1) result += readPaths[i].reads.size();
-				if (j == readPaths[i].path.size()-1)
-				{
-					for (const auto& read : readPaths[i].reads)
-					{
-						assert(read.rightClip < unitigs[unitig].size());
-						result += (double)(unitigs[unitig].size() - read.rightClip) / (double)(unitigs[unitig].size());
-					}
-				}
+				edgeReadCounts[canon(paths[i].path[j-1], paths[i].path[j])] += pathEdgeReadCount(paths[i], j);
 			}
 		}
-		return result;
+	}
+	// drops the entries of erased paths from the crossing lists of all nodes which have them
+	void collectCrossingGarbage(const std::vector<PathGroup>& paths, const size_t numThreads)
+	{
+		iterateChunksMultithreaded(nodesWithDeadCrossings.size(), numThreads, 256, [this, &paths](size_t start, size_t end)
+		{
+			for (size_t i = start; i < end; i++)
+			{
+				const size_t node = nodesWithDeadCrossings[i];
+				auto& crossers = readsCrossingNode[node];
+				crossers.erase(std::remove_if(crossers.begin(), crossers.end(), [&paths](std::pair<uint32_t, uint32_t> pospair) { return paths[pospair.first].path.size() == 0 || paths[pospair.first].reads.size() == 0; }), crossers.end());
+				assert(crossers.size() == liveCrossingCount[node]);
+				deadCrossingCount[node] = 0;
+			}
+		});
+		nodesWithDeadCrossings.clear();
+	}
+	// sets the live and dead counts from crossing lists which were filled without addPathCounts
+	void recountCrossingReads(const std::vector<PathGroup>& paths)
+	{
+		nodesWithDeadCrossings.clear();
+		for (size_t node = 0; node < readsCrossingNode.size(); node++)
+		{
+			liveCrossingCount[node] = 0;
+			for (const auto& pospair : readsCrossingNode[node])
+			{
+				if (paths[pospair.first].path.size() > 0 && paths[pospair.first].reads.size() > 0) liveCrossingCount[node] += 1;
+			}
+			deadCrossingCount[node] = readsCrossingNode[node].size() - liveCrossingCount[node];
+			if (deadCrossingCount[node] > 0) nodesWithDeadCrossings.push_back(node);
+		}
+	}
+	void markChanged(size_t node)
+	{
+		invalidateRawTriplets(node);
+		if (nodeChanged[node]) return;
+		nodeChanged[node] = true;
+		changedNodes.push_back(node);
+	}
+	void clearChangedNodes()
+	{
+		for (const size_t node : changedNodes) nodeChanged[node] = false;
+		changedNodes.clear();
+	}
+	// new nodes have no crossing reads and zero coverage
+	void resizeCrossingReads(size_t newSize)
+	{
+		nodeChanged.resize(newSize, false);
+		readsCrossingNode.resize(newSize);
+		liveCrossingCount.resize(newSize, 0);
+		deadCrossingCount.resize(newSize, 0);
+		coveredKmers.resize(newSize, 0);
+		rawTripletCache.resize(newSize);
 	}
 	size_t getCrossingCount(size_t node) const
 	{
-		return readsCrossingNode[node].size();
+		return liveCrossingCount[node];
 	}
 	ReadCrosserIteratorHelper iterateCrossingReads(size_t node, const std::vector<PathGroup>& paths) const
 	{
@@ -330,11 +583,27 @@ void printReads(const ResolvableUnitigGraph& graph, const std::vector<PathGroup>
 	}
 }
 
+// false if a triplet goes through a removed node
+bool renameRawTriplets(std::vector<std::pair<std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>>, size_t>>& coverage, const RankBitvector& kept)
+{
+	for (auto& pair : coverage)
+	{
+		for (std::pair<size_t, bool>* neighbor : { &pair.first.first, &pair.first.second })
+		{
+			if (neighbor->first == std::numeric_limits<size_t>::max()) continue;
+			if (!kept.get(neighbor->first)) return false;
+			neighbor->first = kept.getRank(neighbor->first);
+		}
+	}
+	return true;
+}
+
 void compact(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& paths, std::vector<size_t>& queueNodes)
 {
 	{
 		decltype(resolvableGraph.readsCrossingNode) tmp;
 		std::swap(resolvableGraph.readsCrossingNode, tmp);
+		resolvableGraph.nodesWithDeadCrossings.clear();
 	}
 	RankBitvector kept { resolvableGraph.unitigs.size() };
 	for (size_t i = 0; i < resolvableGraph.unitigs.size(); i++)
@@ -373,15 +642,29 @@ void compact(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& pat
 		std::swap(newPrecalcedUnitigLengths, resolvableGraph.precalcedUnitigLengths);
 	}
 	{
-		std::vector<double> newPrecalcedUnitigCoverages;
-		newPrecalcedUnitigCoverages.resize(newSize, 0);
-		for (size_t i = 0; i < resolvableGraph.precalcedUnitigCoverages.size(); i++)
+		std::vector<size_t> newCoveredKmers;
+		newCoveredKmers.resize(newSize, 0);
+		for (size_t i = 0; i < resolvableGraph.coveredKmers.size(); i++)
 		{
 			if (!kept.get(i)) continue;
 			size_t newIndex = kept.getRank(i);
-			newPrecalcedUnitigCoverages[newIndex] = resolvableGraph.precalcedUnitigCoverages[i];
+			newCoveredKmers[newIndex] = resolvableGraph.coveredKmers[i];
+		}
+		std::swap(newCoveredKmers, resolvableGraph.coveredKmers);
+	}
+	{
+		std::vector<RawTripletCoverage> newRawTripletCache;
+		newRawTripletCache.resize(newSize);
+		for (size_t i = 0; i < resolvableGraph.rawTripletCache.size(); i++)
+		{
+			if (!kept.get(i)) continue;
+			RawTripletCoverage& cached = resolvableGraph.rawTripletCache[i];
+			if (!cached.counted) continue;
+			if (!renameRawTriplets(cached.coverage, kept)) continue;
+			if (!renameRawTriplets(cached.partCoverage, kept)) continue;
+			std::swap(newRawTripletCache[kept.getRank(i)], cached);
 		}
-		std::swap(newPrecalcedUnitigCoverages, resolvableGraph.precalcedUnitigCoverages);
+		std::swap(newRawTripletCache, resolvableGraph.rawTripletCache);
 	}
 	resolvableGraph.unitigRemoved.resize(newSize);
 	for (size_t i = 0; i < resolvableGraph.unitigRemoved.size(); i++)
@@ -411,7 +694,7 @@ void compact(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& pat
 		std::swap(resolvableGraph.unitigLeftClipBp, newUnitigLeftClipBp);
 	}
 	{
-		VectorWithDirection<phmap::flat_hash_set<std::pair<size_t, bool>>> newEdges;
+		VectorWithDirection<SmallVectorSet<std::pair<size_t, bool>, 2>> newEdges;
 		newEdges.resize(newSize);
 		for (size_t i = 0; i < resolvableGraph.edges.size(); i++)
 		{
@@ -434,18 +717,25 @@ void compact(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& pat
 		std::swap(resolvableGraph.edges, newEdges);
 	}
 	{
-		phmap::flat_hash_map<std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>>, size_t> newOverlaps;
-		for (auto pair : resolvableGraph.overlaps)
+		EdgeValueIndex newOverlaps;
+		for (size_t i = 0; i < resolvableGraph.overlaps.numNodes(); i++)
 		{
-			auto from = pair.first.first;
-			auto to = pair.first.second;
-			if (!kept.get(from.first) || !kept.get(to.first)) continue;
-			auto overlap = pair.second;
-			from.first = kept.getRank(from.first);
-			to.first = kept.getRank(to.first);
-			assert(from.first < resolvableGraph.unitigs.size());
-			assert(to.first < resolvableGraph.unitigs.size());
-			newOverlaps[canon(from, to)] = overlap;
+			if (!kept.get(i)) continue;
+			for (bool fw : { true, false })
+			{
+				for (auto pair : resolvableGraph.overlaps.getValuesFrom(std::make_pair(i, fw)))
+				{
+					auto from = std::make_pair(i, fw);
+					auto to = pair.first;
+					if (!kept.get(to.first)) continue;
+					auto overlap = pair.second;
+					from.first = kept.getRank(from.first);
+					to.first = kept.getRank(to.first);
+					assert(from.first < resolvableGraph.unitigs.size());
+					assert(to.first < resolvableGraph.unitigs.size());
+					newOverlaps[canon(from, to)] = overlap;
+				}
+			}
 		}
 		std::swap(resolvableGraph.overlaps, newOverlaps);
 	}
@@ -462,6 +752,12 @@ void compact(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& pat
 	for (size_t i = paths.size()-1; i > 0; i--)
 	{
 		if (paths[i].path != paths[i-1].path) continue;
+		// merged groups have different clips and coverage than either group alone, so triplets counted from them are stale
+		for (size_t j = 0; j < paths[i].path.size(); j++)
+		{
+			assert(kept.get(paths[i].path[j].first));
+			resolvableGraph.invalidateRawTriplets(kept.getRank(paths[i].path[j].first));
+		}
 		paths[i-1].reads.insert(paths[i-1].reads.end(), paths[i].reads.begin(), paths[i].reads.end());
 		std::swap(paths[i], paths.back());
 		paths.pop_back();
@@ -486,35 +782,136 @@ void compact(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& pat
 		queueNodes[i] = kept.getRank(queueNodes[i]);
 	}
 	resolvableGraph.readsCrossingNode.resize(newSize);
+	resolvableGraph.liveCrossingCount.assign(newSize, 0);
+	resolvableGraph.deadCrossingCount.assign(newSize, 0);
+	resolvableGraph.nodeChanged.assign(newSize, false);
+	resolvableGraph.changedNodes.clear();
 	for (size_t i = 0; i < paths.size(); i++)
 	{
 		for (size_t j = 0; j < paths[i].path.size(); j++)
 		{
 			resolvableGraph.readsCrossingNode[paths[i].path[j].first].emplace_back(i, j);
+			resolvableGraph.liveCrossingCount[paths[i].path[j].first] += 1;
 		}
 	}
+	resolvableGraph.recountEdgeReads(paths);
 	for (size_t i = 0; i < resolvableGraph.unitigRemoved.size(); i++)
 	{
 		assert(!resolvableGraph.unitigRemoved[i]);
 	}
 }
 
-class UnitigLengthComparer
+// unitigs bucketed by length for resolving them in order of length, shortest first
+// lengths at or above maxLength share the last bucket since they are not resolved
+// trimming shortens unitigs which are already queued, so entries are moved to their current length's bucket when their bucket comes up
+class UnitigLengthQueue
 {
 public:
-	UnitigLengthComparer(const ResolvableUnitigGraph& resolvableGraph) :
-	resolvableGraph(resolvableGraph)
+	UnitigLengthQueue(const ResolvableUnitigGraph& resolvableGraph, const size_t maxLength) :
+	resolvableGraph(resolvableGraph),
+	maxLength(maxLength),
+	buckets(),
+	minBucket(0),
+	numItems(0)
+	{
+	}
+	void push(const size_t unitig)
+	{
+		size_t bucket = getBucket(unitig);
+		if (bucket >= buckets.size()) buckets.resize(bucket+1);
+		buckets[bucket].push_back(unitig);
+		if (numItems == 0 || bucket < minBucket) minBucket = bucket;
+		numItems += 1;
+	}
+	size_t size() const
+	{
+		return numItems;
+	}
+	// length of the shortest queued unitigs, capped at maxLength
+	size_t topLength()
+	{
+		assert(numItems > 0);
+		settle();
+		return minBucket;
+	}
+	// removes and returns all unitigs of the shortest length
+	std::vector<size_t> popShortest()
+	{
+		assert(numItems > 0);
+		settle();
+		std::vector<size_t> result;
+		std::swap(result, buckets[minBucket]);
+		assert(numItems >= result.size());
+		numItems -= result.size();
+		return result;
+	}
+	// all queued unitigs without removing them
+	std::vector<size_t> getAll() const
 	{
+		std::vector<size_t> result;
+		result.reserve(numItems);
+		for (size_t i = minBucket; i < buckets.size(); i++)
+		{
+			result.insert(result.end(), buckets[i].begin(), buckets[i].end());
+		}
+		assert(result.size() == numItems);
+		return result;
 	}
-	bool operator()(const size_t left, const size_t right) const
+	// removes and returns all unitigs
+	std::vector<size_t> popAll()
 	{
-		return resolvableGraph.unitigLength(left) > resolvableGraph.unitigLength(right);
+		std::vector<size_t> result;
+		result.reserve(numItems);
+		for (size_t i = minBucket; i < buckets.size(); i++)
+		{
+			result.insert(result.end(), buckets[i].begin(), buckets[i].end());
+			std::vector<size_t> tmp;
+			std::swap(tmp, buckets[i]);
+		}
+		assert(result.size() == numItems);
+		numItems = 0;
+		minBucket = 0;
+		return result;
 	}
 private:
+	size_t getBucket(const size_t unitig) const
+	{
+		return std::min(resolvableGraph.unitigLength(unitig), maxLength);
+	}
+	// moves minBucket to the first bucket which is nonempty after moving changed entries
+	void settle()
+	{
+		while (true)
+		{
+			assert(minBucket < buckets.size());
+			if (buckets[minBucket].size() == 0)
+			{
+				minBucket += 1;
+				continue;
+			}
+			size_t bucket = minBucket;
+			std::vector<size_t> items;
+			std::swap(items, buckets[bucket]);
+			for (const size_t unitig : items)
+			{
+				size_t realBucket = getBucket(unitig);
+				if (realBucket >= buckets.size()) buckets.resize(realBucket+1);
+				buckets[realBucket].push_back(unitig);
+				if (realBucket < minBucket) minBucket = realBucket;
+			}
+			if (minBucket == bucket && buckets[bucket].size() > 0) break;
+		}
+	}
 	const ResolvableUnitigGraph& resolvableGraph;
+	const size_t maxLength;
+	std::vector<std::vector<size_t>> buckets;
+	size_t minBucket;
+	size_t numItems;
 };
 
-ResolvableUnitigGraph getUnitigs(const UnitigGraph& initial, size_t minCoverage, const HashList& hashlist, const size_t kmerSize, const bool keepGaps, std::ostream& log)
+// nodes are copied and their edges collected in parallel per node range
+// the edges are then added in the same order as a single loop over the nodes would add them, so the edge sets iterate in the same order
+ResolvableUnitigGraph getUnitigs(const UnitigGraph& initial, size_t minCoverage, const HashList& hashlist, const size_t kmerSize, const bool keepGaps, const size_t numThreads, std::ostream& log)
 {
 	ResolvableUnitigGraph result { hashlist, kmerSize };
 	result.unitigs.resize(initial.unitigs.size());
@@ -522,41 +919,45 @@ ResolvableUnitigGraph getUnitigs(const UnitigGraph& initial, size_t minCoverage,
 	result.unitigRightClipBp.resize(initial.unitigs.size(), 0);
 	result.unitigRemoved.resize(initial.unitigs.size(), false);
 	result.edges.resize(initial.unitigs.size());
-	result.readsCrossingNode.resize(initial.unitigs.size());
-	std::vector<std::pair<size_t, bool>> checkKeepTips;
-	for (size_t i = 0; i < initial.unitigs.size(); i++)
-	{
-		result.unitigs[i].insert(result.unitigs[i].end(), initial.unitigs[i].begin(), initial.unitigs[i].end());
-		std::pair<size_t, bool> fw { i, true };
-		bool keepCheck = false;
-		for (auto pair : initial.edgeCov.getValues(fw))
-		{
-			if (pair.second < minCoverage)
-			{
-				keepCheck = true;
-				continue;
+	result.resizeCrossingReads(initial.unitigs.size());
+	result.precalcedUnitigLengths.resize(initial.unitigs.size(), 0);
+	const size_t numRanges = getNumRanges(initial.unitigs.size(), numThreads);
+	std::vector<std::vector<std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>>>> rangeEdges;
+	std::vector<std::vector<std::pair<size_t, bool>>> rangeKeepTips;
+	rangeEdges.resize(numRanges);
+	rangeKeepTips.resize(numRanges);
+	iterateRangesMultithreaded(initial.unitigs.size(), numThreads, [&initial, &result, &rangeEdges, &rangeKeepTips, minCoverage](size_t range, size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			result.unitigs[i].insert(result.unitigs[i].end(), initial.unitigs[i].begin(), initial.unitigs[i].end());
+			for (bool fw : { true, false })
+			{
+				std::pair<size_t, bool> from { i, fw };
+				bool keepCheck = false;
+				for (auto pair : initial.edgeCov.getValues(from))
+				{
+					if (pair.second < minCoverage)
+					{
+						keepCheck = true;
+						continue;
+					}
+					rangeEdges[range].emplace_back(from, pair.first);
+				}
+				if (keepCheck) rangeKeepTips[range].push_back(from);
 			}
-			auto canonpair = canon(fw, pair.first);
-			result.overlaps[canonpair] = 0;
-			result.edges[fw].emplace(pair.first);
-			result.edges[reverse(pair.first)].emplace(reverse(fw));
 		}
-		if (keepCheck) checkKeepTips.push_back(fw);
-		std::pair<size_t, bool> bw { i, false };
-		keepCheck = false;
-		for (auto pair : initial.edgeCov.getValues(bw))
+	});
+	std::vector<std::pair<size_t, bool>> checkKeepTips;
+	for (size_t range = 0; range < numRanges; range++)
+	{
+		for (auto edge : rangeEdges[range])
 		{
-			if (pair.second < minCoverage)
-			{
-				keepCheck = true;
-				continue;
-			}
-			auto canonpair = canon(bw, pair.first);
-			result.overlaps[canonpair] = 0;
-			result.edges[bw].emplace(pair.first);
-			result.edges[reverse(pair.first)].emplace(reverse(bw));
+			result.overlaps[canon(edge.first, edge.second)] = 0;
+			result.edges[edge.first].emplace(edge.second);
+			result.edges[reverse(edge.second)].emplace(reverse(edge.first));
 		}
-		if (keepCheck) checkKeepTips.push_back(bw);
+		checkKeepTips.insert(checkKeepTips.end(), rangeKeepTips[range].begin(), rangeKeepTips[range].end());
 	}
 	if (keepGaps)
 	{
@@ -578,24 +979,37 @@ ResolvableUnitigGraph getUnitigs(const UnitigGraph& initial, size_t minCoverage,
 			result.edges[reverse(pair.second)].emplace(reverse(pair.first));
 		}
 	}
+	// the sums are integers so summing per range does not change them
+	std::vector<std::tuple<size_t, size_t, size_t, size_t>> rangeSums;
+	rangeSums.resize(getNumRanges(result.unitigs.size(), numThreads), std::make_tuple(0, 0, 0, 0));
+	iterateRangesMultithreaded(result.unitigs.size(), numThreads, [&result, &hashlist, &rangeSums](size_t range, size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			size_t sumHere = 0;
+			for (size_t j = 0; j < result.unitigs[i].size(); j++)
+			{
+				sumHere += hashlist.coverage.get(result.unitigs[i][j].first);
+			}
+			std::get<0>(rangeSums[range]) += sumHere;
+			std::get<1>(rangeSums[range]) += result.unitigs[i].size();
+			if (result.unitigLength(i) > 100000)
+			{
+				std::get<2>(rangeSums[range]) += sumHere;
+				std::get<3>(rangeSums[range]) += result.unitigs[i].size();
+			}
+		}
+	});
 	double allkmerSum = 0;
 	double allkmerDivisor = 0;
 	double longkmerSum = 0;
 	double longkmerDivisor = 0;
-	for (size_t i = 0; i < result.unitigs.size(); i++)
+	for (auto sums : rangeSums)
 	{
-		double sumHere = 0;
-		for (size_t j = 0; j < result.unitigs[i].size(); j++)
-		{
-			sumHere += hashlist.coverage.get(result.unitigs[i][j].first);
-		}
-		allkmerSum += sumHere;
-		allkmerDivisor += result.unitigs[i].size();
-		if (result.unitigLength(i) > 100000)
-		{
-			longkmerSum += sumHere;
-			longkmerDivisor += result.unitigs[i].size();
-		}
+		allkmerSum += std::get<0>(sums);
+		allkmerDivisor += std::get<1>(sums);
+		longkmerSum += std::get<2>(sums);
+		longkmerDivisor += std::get<3>(sums);
 	}
 	assert(longkmerDivisor > 0 || longkmerSum == 0);
 	if (longkmerDivisor > 0)
@@ -615,7 +1029,7 @@ ResolvableUnitigGraph getUnitigs(const UnitigGraph& initial, size_t minCoverage,
 	return result;
 }
 
-size_t getNumberOfHashes(const ResolvableUnitigGraph& resolvableGraph, size_t leftClip, size_t rightClip, const std::vector<std::pair<size_t, bool>>& path)
+size_t getNumberOfHashes(const ResolvableUnitigGraph& resolvableGraph, size_t leftClip, size_t rightClip, const std::vector<PathNode>& path)
 {
 	if (path.size() == 0) return 0;
 	size_t result = 0;
@@ -638,18 +1052,117 @@ size_t getNumberOfHashes(const ResolvableUnitigGraph& resolvableGraph, size_t le
 	return result;
 }
 
-std::pair<UnitigGraph, std::vector<ReadPath>> resolvableToUnitigs(const ResolvableUnitigGraph& resolvableGraph, const std::vector<PathGroup>& readPaths, const std::vector<ReadPathInfo>& readInfos)
+// coverage added to the kmers [start, end) of a node of the resolved graph, positions in the forward orientation of the node
+struct CoverageSpan
+{
+	size_t node;
+	size_t start;
+	size_t end;
+	size_t count;
+};
+
+// kmers [start, end) of the node in the orientation of node.second, buckets[i] has the spans of the nodes of range i
+void addCoverageSpan(std::vector<std::vector<CoverageSpan>>& buckets, const size_t nodeRangeSize, const size_t nodeSize, const std::pair<size_t, bool> node, const size_t start, const size_t end, const size_t count)
+{
+	assert(start <= end);
+	assert(end <= nodeSize);
+	CoverageSpan span;
+	span.node = node.first;
+	span.start = node.second ? start : nodeSize - end;
+	span.end = node.second ? end : nodeSize - start;
+	span.count = count;
+	buckets[node.first / nodeRangeSize].push_back(span);
+}
+
+// rank of a kept unitig is its index in the final graph
+RankBitvector getNewUnitigIndex(const ResolvableUnitigGraph& resolvableGraph)
 {
+	RankBitvector newIndex { resolvableGraph.unitigs.size() };
+	assert(resolvableGraph.unitigs.size() == resolvableGraph.unitigRemoved.size());
+	assert(resolvableGraph.unitigs.size() == resolvableGraph.edges.size());
+	for (size_t i = 0; i < resolvableGraph.unitigs.size(); i++)
 	{
-		std::vector<std::vector<size_t>> coverages;
-		coverages.resize(resolvableGraph.unitigs.size());
-		for (size_t i = 0; i < resolvableGraph.unitigs.size(); i++)
+		newIndex.set(i, !resolvableGraph.unitigRemoved[i]);
+	}
+	newIndex.buildRanks();
+	return newIndex;
+}
+
+// nodes and ranges of paths are converted in parallel
+// kmer coverages go through spans bucketed by node range so each node range is summed by one thread
+// edges and edge coverages go into the shared hash maps afterwards, edges in the same order as a single loop over the nodes would add them
+UnitigGraph resolvableToUnitigs(const ResolvableUnitigGraph& resolvableGraph, const std::vector<PathGroup>& readPaths, const size_t numThreads)
+{
+	UnitigGraph result;
+	RankBitvector newIndex = getNewUnitigIndex(resolvableGraph);
+	const size_t newSize = newIndex.getRank(newIndex.size()-1) + (newIndex.get(newIndex.size()-1) ? 1 : 0);
+	result.unitigs.resize(newSize);
+	result.leftClip.resize(newSize);
+	result.rightClip.resize(newSize);
+	result.unitigCoverage.resize(newSize);
+	result.edges.resize(newSize);
+	result.edgeCov.resize(newSize);
+	result.edgeOvlp.resize(newSize);
+	std::vector<std::vector<std::tuple<std::pair<size_t, bool>, std::pair<size_t, bool>, size_t>>> rangeEdges;
+	rangeEdges.resize(getNumRanges(resolvableGraph.unitigs.size(), numThreads));
+	iterateRangesMultithreaded(resolvableGraph.unitigs.size(), numThreads, [&resolvableGraph, &newIndex, &result, &rangeEdges, newSize](size_t range, size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			if (!newIndex.get(i)) continue;
+			const size_t unitig = newIndex.getRank(i);
+			assert(unitig < newSize);
+			result.unitigs[unitig].insert(result.unitigs[unitig].end(), resolvableGraph.unitigs[i].begin(), resolvableGraph.unitigs[i].end());
+			result.unitigCoverage[unitig].resize(resolvableGraph.unitigs[i].size(), 0);
+			result.leftClip[unitig] = resolvableGraph.unitigLeftClipBp[i];
+			result.rightClip[unitig] = resolvableGraph.unitigRightClipBp[i];
+			for (bool fw : { true, false })
+			{
+				std::pair<size_t, bool> from { i, fw };
+				std::pair<size_t, bool> newFrom { unitig, fw };
+				for (auto edge : resolvableGraph.edges[from])
+				{
+					assert(newIndex.get(edge.first));
+					std::pair<size_t, bool> newEdge { newIndex.getRank(edge.first), edge.second };
+					assert(newEdge.first < newSize);
+					rangeEdges[range].emplace_back(newFrom, newEdge, resolvableGraph.overlaps.at(canon(from, edge)));
+				}
+			}
+		}
+	});
+	for (size_t range = 0; range < rangeEdges.size(); range++)
+	{
+		for (auto edge : rangeEdges[range])
 		{
-			coverages[i].resize(resolvableGraph.unitigs[i].size(), 0);
+			std::pair<size_t, bool> from = std::get<0>(edge);
+			std::pair<size_t, bool> to = std::get<1>(edge);
+			result.edges.addEdge(from, to);
+			result.edges.addEdge(reverse(to), reverse(from));
+			result.setEdgeCoverage(from, to, 0);
+			result.setEdgeOverlap(from, to, std::get<2>(edge));
 		}
-		for (const auto& path : readPaths)
+		std::vector<std::tuple<std::pair<size_t, bool>, std::pair<size_t, bool>, size_t>> tmp;
+		std::swap(tmp, rangeEdges[range]);
+	}
+	const size_t nodeRangeSize = getRangeSize(newSize, numThreads);
+	const size_t numNodeRanges = getNumRanges(newSize, numThreads);
+	const size_t numPathRanges = getNumRanges(readPaths.size(), numThreads);
+	// spans[pathRange][nodeRange]
+	std::vector<std::vector<std::vector<CoverageSpan>>> spans;
+	std::vector<std::vector<std::pair<std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>>, size_t>>> edgeCoverages;
+	spans.resize(numPathRanges);
+	edgeCoverages.resize(numPathRanges);
+	for (size_t i = 0; i < numPathRanges; i++)
+	{
+		spans[i].resize(numNodeRanges);
+	}
+	iterateRangesMultithreaded(readPaths.size(), numThreads, [&resolvableGraph, &readPaths, &newIndex, &result, &spans, &edgeCoverages, newSize, nodeRangeSize](size_t range, size_t start, size_t end)
+	{
+		for (size_t pathIndex = start; pathIndex < end; pathIndex++)
 		{
+			const PathGroup& path = readPaths[pathIndex];
 			if (path.path.size() == 0) continue;
+			assert(path.reads.size() > 0);
 			for (size_t i = 0; i < path.path.size(); i++)
 			{
 				assert(path.path[i].first < resolvableGraph.unitigs.size());
@@ -661,203 +1174,231 @@ std::pair<UnitigGraph, std::vector<ReadPath>> resolvableToUnitigs(const Resolvab
 				assert(resolvableGraph.edges[reverse(path.path[i])].count(reverse(path.path[i-1])) == 1);
 			}
 			size_t pathHashCount = getNumberOfHashes(resolvableGraph, 0, 0, path.path);
-			if (path.path.size() == 1)
+			for (const auto& read : path.reads)
+			{
+				assert(read.leftClip + read.rightClip + (read.readPosEndIndex - read.readPosStartIndex) == pathHashCount);
+			}
+			std::vector<PathNode> fixPath = path.path;
+			for (size_t i = 0; i < fixPath.size(); i++)
+			{
+				assert(newIndex.get(fixPath[i].first));
+				fixPath[i].first = newIndex.getRank(fixPath[i].first);
+				assert(fixPath[i].first < newSize);
+			}
+			assert(fixPath.size() > 0);
+			if (fixPath.size() == 1)
 			{
+				const size_t nodeSize = result.unitigCoverage[fixPath[0].first].size();
 				for (const auto& read : path.reads)
 				{
-					assert(read.leftClip + read.rightClip + (read.readPosEndIndex - read.readPosStartIndex) == pathHashCount);
-					assert(read.leftClip + read.rightClip < resolvableGraph.unitigs[path.path[0].first].size());
-					for (size_t i = read.leftClip; i < resolvableGraph.unitigs[path.path[0].first].size() - read.rightClip; i++)
-					{
-						size_t index = i;
-						if (!path.path[0].second) index = resolvableGraph.unitigs[path.path[0].first].size() - i - 1;
-						coverages[path.path[0].first][index] += 1;
-					}
+					assert(read.leftClip + read.rightClip < nodeSize);
+					addCoverageSpan(spans[range], nodeRangeSize, nodeSize, fixPath[0], read.leftClip, nodeSize - read.rightClip, 1);
 				}
-				continue;
 			}
-			assert(path.path.size() >= 2);
-			for (size_t i = 1; i < path.path.size()-1; i++)
+			else
 			{
-				for (size_t j = 0; j < resolvableGraph.unitigs[path.path[i].first].size(); j++)
+				assert(fixPath.size() >= 2);
+				for (size_t i = 1; i < fixPath.size()-1; i++)
 				{
-					coverages[path.path[i].first][j] += path.reads.size();
+					const size_t nodeSize = result.unitigCoverage[fixPath[i].first].size();
+					addCoverageSpan(spans[range], nodeRangeSize, nodeSize, fixPath[i], 0, nodeSize, path.reads.size());
 				}
-			}
-			for (const auto& read : path.reads)
-			{
-				assert(read.leftClip + read.rightClip + (read.readPosEndIndex - read.readPosStartIndex) == pathHashCount);
-				assert(read.leftClip < resolvableGraph.unitigs[path.path[0].first].size());
-				for (size_t i = read.leftClip; i < resolvableGraph.unitigs[path.path[0].first].size(); i++)
+				const size_t firstSize = result.unitigCoverage[fixPath[0].first].size();
+				const size_t lastSize = result.unitigCoverage[fixPath.back().first].size();
+				for (const auto& read : path.reads)
 				{
-					size_t index = i;
-					if (!path.path[0].second) index = resolvableGraph.unitigs[path.path[0].first].size() - i - 1;
-					coverages[path.path[0].first][index] += 1;
+					assert(read.leftClip < firstSize);
+					addCoverageSpan(spans[range], nodeRangeSize, firstSize, fixPath[0], read.leftClip, firstSize, 1);
 				}
-				assert(read.rightClip < resolvableGraph.unitigs[path.path.back().first].size());
-				for (size_t i = 0; i < resolvableGraph.unitigs[path.path.back().first].size() - read.rightClip; i++)
+				for (const auto& read : path.reads)
 				{
-					size_t index = i;
-					if (!path.path.back().second) index = resolvableGraph.unitigs[path.path.back().first].size() - i - 1;
-					coverages[path.path.back().first][index] += 1;
+					assert(read.rightClip < lastSize);
+					addCoverageSpan(spans[range], nodeRangeSize, lastSize, fixPath.back(), 0, lastSize - read.rightClip, 1);
 				}
 			}
+			for (size_t j = 1; j < fixPath.size(); j++)
+			{
+				edgeCoverages[range].emplace_back(canon(fixPath[j-1], fixPath[j]), path.reads.size());
+			}
 		}
+		// summed per edge so the shared map is updated once per edge and range
+		auto& coverages = edgeCoverages[range];
+		std::sort(coverages.begin(), coverages.end());
+		size_t summed = 0;
 		for (size_t i = 0; i < coverages.size(); i++)
 		{
-			if (resolvableGraph.unitigRemoved[i]) continue;
-			for (size_t j = 0; j < coverages[i].size(); j++)
+			if (summed > 0 && coverages[summed-1].first == coverages[i].first)
 			{
-				assertPrintReads(coverages[i][j] > 0, resolvableGraph, readPaths, i);
+				coverages[summed-1].second += coverages[i].second;
+				continue;
 			}
+			coverages[summed] = coverages[i];
+			summed += 1;
 		}
-	}
-	for (const auto& path : readPaths)
+		coverages.resize(summed);
+	});
+	iterateRangesMultithreaded(newSize, numThreads, [&result, &spans](size_t nodeRange, size_t start, size_t end)
 	{
-		if (path.path.size() == 0) continue;
-		assert(path.reads.size() > 0);
-		size_t pathHashCount = getNumberOfHashes(resolvableGraph, 0, 0, path.path);
-		for (const auto& read : path.reads)
+		for (size_t pathRange = 0; pathRange < spans.size(); pathRange++)
 		{
-			assert(read.leftClip + read.rightClip + (read.readPosEndIndex - read.readPosStartIndex) == pathHashCount);
+			for (const CoverageSpan& span : spans[pathRange][nodeRange])
+			{
+				assert(span.node >= start && span.node < end);
+				for (size_t i = span.start; i < span.end; i++)
+				{
+					result.unitigCoverage[span.node][i] += span.count;
+				}
+			}
+			std::vector<CoverageSpan> tmp;
+			std::swap(tmp, spans[pathRange][nodeRange]);
 		}
-	}
-	UnitigGraph result;
-	RankBitvector newIndex { resolvableGraph.unitigs.size() };
-	assert(resolvableGraph.unitigs.size() == resolvableGraph.unitigRemoved.size());
-	assert(resolvableGraph.unitigs.size() == resolvableGraph.edges.size());
-	for (size_t i = 0; i < resolvableGraph.unitigs.size(); i++)
-	{
-		newIndex.set(i, !resolvableGraph.unitigRemoved[i]);
-	}
-	newIndex.buildRanks();
-	const size_t newSize = newIndex.getRank(newIndex.size()-1) + (newIndex.get(newIndex.size()-1) ? 1 : 0);
-	result.unitigs.resize(newSize);
-	result.leftClip.resize(newSize);
-	result.rightClip.resize(newSize);
-	result.unitigCoverage.resize(newSize);
-	result.edges.resize(newSize);
-	result.edgeCov.resize(newSize);
-	result.edgeOvlp.resize(newSize);
-	for (size_t i = 0; i < resolvableGraph.unitigs.size(); i++)
-	{
-		if (!newIndex.get(i)) continue;
-		const size_t unitig = newIndex.getRank(i);
-		assert(unitig < newSize);
-		result.unitigs[unitig].insert(result.unitigs[unitig].end(), resolvableGraph.unitigs[i].begin(), resolvableGraph.unitigs[i].end());
-		for (size_t j = 0; j < resolvableGraph.unitigs[i].size(); j++)
+		for (size_t i = start; i < end; i++)
 		{
-			result.unitigCoverage[unitig].push_back(0);
-		}
-		result.leftClip[unitig] = resolvableGraph.unitigLeftClipBp[i];
-		result.rightClip[unitig] = resolvableGraph.unitigRightClipBp[i];
-		std::pair<size_t, bool> fw { i, true };
-		std::pair<size_t, bool> newfw { newIndex.getRank(i), true };
-		assert(newfw.first < newSize);
-		for (auto edge : resolvableGraph.edges[fw])
-		{
-			assert(newIndex.get(edge.first));
-			std::pair<size_t, bool> newEdge { newIndex.getRank(edge.first), edge.second };
-			assert(newEdge.first < newSize);
-			result.edges.addEdge(newfw, newEdge);
-			result.edges.addEdge(reverse(newEdge), reverse(newfw));
-			result.setEdgeCoverage(newfw, newEdge, 0);
-			result.setEdgeOverlap(newfw, newEdge, resolvableGraph.overlaps.at(canon(fw, edge)));
+			for (size_t j = 0; j < result.unitigCoverage[i].size(); j++)
+			{
+				assert(result.unitigCoverage[i][j] > 0);
+			}
 		}
-		std::pair<size_t, bool> bw { i, false };
-		std::pair<size_t, bool> newbw { newIndex.getRank(i), false };
-		assert(newbw.first < newSize);
-		for (auto edge : resolvableGraph.edges[bw])
+	});
+	for (size_t range = 0; range < edgeCoverages.size(); range++)
+	{
+		for (auto pair : edgeCoverages[range])
 		{
-			assert(newIndex.get(edge.first));
-			std::pair<size_t, bool> newEdge { newIndex.getRank(edge.first), edge.second };
-			assert(newEdge.first < newSize);
-			result.edges.addEdge(newbw, newEdge);
-			result.edges.addEdge(reverse(newEdge), reverse(newbw));
-			result.setEdgeCoverage(newbw, newEdge, 0);
-			result.setEdgeOverlap(newbw, newEdge, resolvableGraph.overlaps.at(canon(bw, edge)));
+			result.setEdgeCoverage(pair.first.first, pair.first.second, result.edgeCoverage(pair.first.first, pair.first.second) + pair.second);
 		}
 	}
-	std::vector<ReadPath> resultReads;
-	for (const auto& path : readPaths)
+	return result;
+}
+
+ReadPath getResolvedReadPath(const std::vector<Node>& newPath, const PathGroup::Read& read, const ReadName& readName, const std::vector<uint32_t>& rawReadPoses)
+{
+	ReadPath result;
+	result.path = newPath;
+	result.readName = readName;
+	result.readPoses.assign(rawReadPoses.begin() + read.readPosStartIndex, rawReadPoses.begin() + read.readPosEndIndex);
+	result.leftClip = read.leftClip;
+	result.rightClip = read.rightClip;
+	return result;
+}
+
+std::vector<Node> getNewPath(const PathGroup& path, const RankBitvector& newIndex)
+{
+	std::vector<Node> result;
+	result.reserve(path.path.size());
+	for (const PathNode node : path.path)
 	{
-		if (path.path.size() == 0) continue;
-		assert(path.reads.size() > 0);
-		std::vector<std::pair<size_t, bool>> fixPath = path.path;
-		for (size_t i = 0; i < fixPath.size(); i++)
-		{
-			assert(newIndex.get(fixPath[i].first));
-			fixPath[i].first = newIndex.getRank(fixPath[i].first);
-			assert(fixPath[i].first < newSize);
-		}
-		assert(fixPath.size() > 0);
-		if (fixPath.size() == 1)
+		assert(newIndex.get(node.first));
+		result.emplace_back(newIndex.getRank(node.first), node.second);
+	}
+	return result;
+}
+
+// paths of the path group reads in the graph built by resolvableToUnitigs, in path group order
+// readInfoIndex of the path group reads is the index of the read in readInfos
+ReadPathStore getResolvedReadPaths(const ResolvableUnitigGraph& resolvableGraph, const std::vector<PathGroup>& readPaths, const ReadPathStore& readInfos, const size_t numThreads)
+{
+	RankBitvector newIndex = getNewUnitigIndex(resolvableGraph);
+	std::vector<std::unique_ptr<ReadPathStore>> readParts;
+	for (size_t i = 0; i < getNumRanges(readPaths.size(), numThreads); i++)
+	{
+		readParts.emplace_back(new ReadPathStore);
+	}
+	iterateRangesMultithreaded(readPaths.size(), numThreads, [&resolvableGraph, &readPaths, &readInfos, &newIndex, &readParts](size_t range, size_t start, size_t end)
+	{
+		ReadPathStore& resultReads = *readParts[range];
+		for (size_t pathIndex = start; pathIndex < end; pathIndex++)
 		{
+			const PathGroup& path = readPaths[pathIndex];
+			if (path.path.size() == 0) continue;
+			std::vector<Node> newPath = getNewPath(path, newIndex);
 			for (const auto& read : path.reads)
 			{
-				for (size_t i = read.leftClip; i < result.unitigCoverage[fixPath[0].first].size() - read.rightClip; i++)
-				{
-					size_t index = i;
-					if (!fixPath[0].second) index = result.unitigCoverage[fixPath[0].first].size() - 1 - i;
-					result.unitigCoverage[fixPath[0].first][index] += 1;
-				}
+				ReadPath resultRead = getResolvedReadPath(newPath, read, resolvableGraph.readNames[read.readNameIndex], readInfos.readPoses(read.readInfoIndex));
+				resultRead.expandedReadPosStart = readInfos.expandedReadPosStart(read.readInfoIndex);
+				resultRead.expandedReadPosEnd = readInfos.expandedReadPosEnd(read.readInfoIndex);
+				resultRead.readLength = readInfos.readLength(read.readInfoIndex);
+				resultRead.readLengthHPC = readInfos.readLengthHPC(read.readInfoIndex);
+				resultReads.push_back(resultRead);
 			}
 		}
-		else
+	});
+	return ReadPathStore::concatenate(readParts, numThreads);
+}
+
+// the same paths as from a ReadPathStore, written straight into a read path file
+// readInfoIndex of the path group reads is the index of the path among the paths of its read in readInfos
+// path group reads are sorted by read so each read of readInfos is read once and the result is written in read order,
+// the paths of a read stay in path group order so the file has the same contents as spilling the ReadPathStore version
+// reads are converted in batches of chunks in parallel and each batch written in order
+std::unique_ptr<SpilledReadPaths> getResolvedReadPaths(const ResolvableUnitigGraph& resolvableGraph, const std::vector<PathGroup>& readPaths, const SpilledReadPaths& readInfos, const std::string& fileName, const size_t numThreads)
+{
+	RankBitvector newIndex = getNewUnitigIndex(resolvableGraph);
+	// (read ordinal, path group, read in path group)
+	std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> pathReads;
+	for (size_t i = 0; i < readPaths.size(); i++)
+	{
+		if (readPaths[i].path.size() == 0) continue;
+		for (size_t j = 0; j < readPaths[i].reads.size(); j++)
 		{
-			assert(fixPath.size() >= 2);
-			for (size_t i = 1; i < fixPath.size()-1; i++)
-			{
-				for (size_t j = 0; j < result.unitigCoverage[fixPath[i].first].size(); j++)
-				{
-					result.unitigCoverage[fixPath[i].first][j] += path.reads.size();
-				}
-			}
-			for (const auto& read : path.reads)
+			pathReads.emplace_back(resolvableGraph.readNames[readPaths[i].reads[j].readNameIndex].first, i, j);
+		}
+	}
+	sortMultithreaded(pathReads, numThreads, [](const std::tuple<uint32_t, uint32_t, uint32_t>& left, const std::tuple<uint32_t, uint32_t, uint32_t>& right) { return left < right; });
+	const size_t minChunkSize = 4096;
+	std::vector<size_t> chunkStarts;
+	for (size_t i = 0; i < pathReads.size(); )
+	{
+		chunkStarts.push_back(i);
+		i = std::min(pathReads.size(), i + minChunkSize);
+		while (i < pathReads.size() && std::get<0>(pathReads[i]) == std::get<0>(pathReads[i-1])) i += 1;
+	}
+	chunkStarts.push_back(pathReads.size());
+	const size_t numChunks = chunkStarts.size()-1;
+	const size_t batchSize = numThreads * 16;
+	std::unique_ptr<SpilledReadPaths> result = std::make_unique<SpilledReadPaths>(fileName, readInfos.numReads());
+	std::vector<std::vector<std::pair<uint32_t, std::vector<uint8_t>>>> blocks;
+	for (size_t batchStart = 0; batchStart < numChunks; batchStart += batchSize)
+	{
+		const size_t batchEnd = std::min(numChunks, batchStart + batchSize);
+		blocks.clear();
+		blocks.resize(batchEnd - batchStart);
+		iterateChunksMultithreaded(batchEnd - batchStart, numThreads, 1, [&resolvableGraph, &readPaths, &readInfos, &newIndex, &pathReads, &chunkStarts, &blocks, batchStart](size_t start, size_t end)
+		{
+			std::vector<ReadPath> resultPaths;
+			for (size_t chunk = start; chunk < end; chunk++)
 			{
-				for (size_t i = read.leftClip; i < result.unitigCoverage[fixPath[0].first].size(); i++)
+				size_t i = chunkStarts[batchStart + chunk];
+				while (i < chunkStarts[batchStart + chunk + 1])
 				{
-					size_t index = i;
-					if (!fixPath[0].second) index = result.unitigCoverage[fixPath[0].first].size()-1-i;
-					result.unitigCoverage[fixPath[0].first][index] += 1;
+					const uint32_t readOrdinal = std::get<0>(pathReads[i]);
+					std::vector<std::pair<size_t, ReadPath>> rawPaths = readInfos.getPaths(readOrdinal);
+					resultPaths.clear();
+					for (; i < chunkStarts[batchStart + chunk + 1] && std::get<0>(pathReads[i]) == readOrdinal; i++)
+					{
+						const PathGroup& path = readPaths[std::get<1>(pathReads[i])];
+						const auto& read = path.reads[std::get<2>(pathReads[i])];
+						assert(read.readInfoIndex < rawPaths.size());
+						const ReadPath& rawPath = rawPaths[read.readInfoIndex].second;
+						resultPaths.push_back(getResolvedReadPath(getNewPath(path, newIndex), read, resolvableGraph.readNames[read.readNameIndex], rawPath.readPoses));
+						resultPaths.back().expandedReadPosStart = rawPath.expandedReadPosStart;
+						resultPaths.back().expandedReadPosEnd = rawPath.expandedReadPosEnd;
+						resultPaths.back().readLength = rawPath.readLength;
+						resultPaths.back().readLengthHPC = rawPath.readLengthHPC;
+					}
+					blocks[chunk].emplace_back(readOrdinal, SpilledReadPaths::encodeRead(resultPaths));
 				}
 			}
-			for (const auto& read : path.reads)
+		});
+		for (const auto& chunkBlocks : blocks)
+		{
+			for (const auto& block : chunkBlocks)
 			{
-				for (size_t i = 0; i < result.unitigCoverage[fixPath.back().first].size() - read.rightClip; i++)
-				{
-					size_t index = i;
-					if (!fixPath.back().second) index = result.unitigCoverage[fixPath.back().first].size()-1-i;
-					result.unitigCoverage[fixPath.back().first][index] += 1;
-				}
+				result->addRead(block.first, block.second);
 			}
 		}
-		for (size_t j = 1; j < fixPath.size(); j++)
-		{
-			result.setEdgeCoverage(fixPath[j-1], fixPath[j], result.edgeCoverage(fixPath[j-1], fixPath[j]) + path.reads.size());
-		}
-		for (const auto& read : path.reads)
-		{
-			resultReads.emplace_back();
-			resultReads.back().path = std::vector<Node> { fixPath.begin(), fixPath.end() };
-			resultReads.back().readName = resolvableGraph.readNames[read.readNameIndex];
-			resultReads.back().readPoses = { readInfos[read.readInfoIndex].readPoses.begin() + read.readPosStartIndex, readInfos[read.readInfoIndex].readPoses.begin() + read.readPosEndIndex };
-			resultReads.back().expandedReadPosStart = readInfos[read.readInfoIndex].expandedReadPosStart;
-			resultReads.back().expandedReadPosEnd = readInfos[read.readInfoIndex].expandedReadPosEnd;
-			resultReads.back().leftClip = read.leftClip;
-			resultReads.back().rightClip = read.rightClip;
-			resultReads.back().readLength = readInfos[read.readInfoIndex].readLength;
-			resultReads.back().readLengthHPC = readInfos[read.readInfoIndex].readLengthHPC;
-		}
-	}
-	for (size_t i = 0; i < result.unitigCoverage.size(); i++)
-	{
-		for (size_t j = 0; j < result.unitigCoverage[i].size(); j++)
-		{
-			assert(result.unitigCoverage[i][j] > 0);
-		}
 	}
-	return std::make_pair(result, resultReads);
+	result->finishAdding();
+	return result;
 }
 
 std::vector<std::pair<size_t, bool>> extend(const ResolvableUnitigGraph& resolvableGraph, const std::pair<size_t, bool> start)
@@ -886,16 +1427,16 @@ std::vector<std::pair<size_t, bool>> extend(const ResolvableUnitigGraph& resolva
 	return result;
 }
 
-void erasePath(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const size_t i)
+// returns the reads of the erased path
+std::vector<PathGroup::Read> erasePath(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const size_t i)
 {
 	assert(readPaths[i].path.size() > 0);
-	for (size_t j = 0; j < readPaths[i].path.size(); j++)
-	{
-		// resolvableGraph.readsCrossingNode[readPaths[i].path[j].first].erase(std::make_pair(i, j));
-		if (resolvableGraph.precalcedUnitigCoverages.size() > readPaths[i].path[j].first) resolvableGraph.precalcedUnitigCoverages[readPaths[i].path[j].first] = 0;
-	}
+	resolvableGraph.erasePathCounts(readPaths, i);
+	std::vector<PathGroup::Read> result;
+	std::swap(result, readPaths[i].reads);
+	// the slot stays until compact, keep the node array allocated instead of freeing it path by path
 	readPaths[i].path.clear();
-	readPaths[i].reads.clear();
+	return result;
 }
 
 void addPath(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, PathGroup&& newPath)
@@ -962,13 +1503,8 @@ void addPath(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& rea
 			assert(resolvableGraph.edges[reverse(newPath.path[i])].count(reverse(newPath.path[i-1])) == 1);
 		}
 	}
-	size_t newIndex = readPaths.size();
-	for (size_t j = 0; j < newPath.path.size(); j++)
-	{
-		resolvableGraph.readsCrossingNode[newPath.path[j].first].emplace_back(newIndex, j);
-		if (resolvableGraph.precalcedUnitigCoverages.size() > newPath.path[j].first) resolvableGraph.precalcedUnitigCoverages[newPath.path[j].first] = 0;
-	}
 	readPaths.emplace_back(std::move(newPath));
+	resolvableGraph.addPathCounts(readPaths, readPaths.size()-1);
 }
 
 void addPathButFirstMaybeTrim(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, PathGroup&& newPath)
@@ -1191,7 +1727,7 @@ void replacePathNodes(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGr
 				extraRightClip += leftClip[unitigindex][posindex];
 			}
 		}
-		std::swap(newPath.reads, readPaths[i].reads);
+		newPath.reads = erasePath(resolvableGraph, readPaths, i);
 		if (extraLeftClip > 0 || extraRightClip > 0)
 		{
 			for (auto& read : newPath.reads)
@@ -1201,72 +1737,95 @@ void replacePathNodes(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGr
 			}
 		}
 		addPathButFirstMaybeTrim(resolvableGraph, readPaths, std::move(newPath));
-		erasePath(resolvableGraph, readPaths, i);
 	}
 }
 
-// todo maybe fix? or does it matter?
-void cutRemovedEdgesFromPaths(ResolvableUnitigGraph& graph, std::vector<ReadPath>& readPaths)
+// appends path i to result if all its edges are in the graph, otherwise its pieces split at the missing edges to cutPaths
+void cutPath(const ResolvableUnitigGraph& graph, const ReadPathStore& readPaths, const size_t i, ReadPathStore& result, ReadPathStore& cutPaths)
 {
-	for (size_t i = 0; i < readPaths.size(); i++)
+	VectorView<Node> path = readPaths.path(i);
+	bool remove = false;
+	for (size_t j = 1; j < path.size(); j++)
 	{
-		if (readPaths[i].path.size() == 0) continue;
-		bool remove = false;
-		size_t lastStart = 0;
-		for (size_t j = 1; j < readPaths[i].path.size(); j++)
-		{
-			if (graph.edges[readPaths[i].path[j-1]].count(readPaths[i].path[j]) == 1) continue;
-			remove = true;
-		}
-		if (!remove) continue;
-		std::vector<size_t> pathStartPoses;
-		std::vector<size_t> pathEndPoses;
-		size_t pos = 0;
-		for (size_t j = 0; j < readPaths[i].path.size(); j++)
-		{
-			pathStartPoses.push_back(pos);
-			pos += graph.unitigs[readPaths[i].path[j].id()].size();
-			pathEndPoses.push_back(pos);
-		}
-		for (size_t j = 1; j < readPaths[i].path.size(); j++)
-		{
-			if (graph.edges[readPaths[i].path[j-1]].count(readPaths[i].path[j]) == 1) continue;
-			ReadPath newPath;
-			newPath.readName = readPaths[i].readName;
-			newPath.readLength = readPaths[i].readLength;
-			newPath.readLengthHPC = readPaths[i].readLengthHPC;
-			newPath.path.insert(newPath.path.end(), readPaths[i].path.begin() + lastStart, readPaths[i].path.begin() + j);
-			newPath.leftClip = 0;
-			if (lastStart == 0) newPath.leftClip = readPaths[i].leftClip;
-			newPath.rightClip = 0;
-			size_t wantedStart = 0;
-			if (pathStartPoses[lastStart] > readPaths[i].leftClip) wantedStart = pathStartPoses[lastStart] - readPaths[i].leftClip;
-			assert(readPaths[i].leftClip < pathEndPoses[j-1]);
-			size_t wantedEnd = pathEndPoses[j-1] - readPaths[i].leftClip;
-			assert(wantedEnd < readPaths[i].readPoses.size());
-			newPath.readPoses.insert(newPath.readPoses.end(), readPaths[i].readPoses.begin() + wantedStart, readPaths[i].readPoses.begin() + wantedEnd);
-			readPaths.emplace_back(std::move(newPath));
-			lastStart = j;
-		}
-		assert(lastStart != 0);
+		if (graph.edges[path[j-1]].count(path[j]) == 1) continue;
+		remove = true;
+	}
+	if (!remove)
+	{
+		result.push_back(readPaths, i);
+		return;
+	}
+	const ReadPath original = readPaths.get(i);
+	size_t lastStart = 0;
+	std::vector<size_t> pathStartPoses;
+	std::vector<size_t> pathEndPoses;
+	size_t pos = 0;
+	for (size_t j = 0; j < original.path.size(); j++)
+	{
+		pathStartPoses.push_back(pos);
+		pos += graph.unitigs[original.path[j].id()].size();
+		pathEndPoses.push_back(pos);
+	}
+	for (size_t j = 1; j < original.path.size(); j++)
+	{
+		if (graph.edges[original.path[j-1]].count(original.path[j]) == 1) continue;
 		ReadPath newPath;
-		newPath.readName = readPaths[i].readName;
-		newPath.readLength = readPaths[i].readLength;
-		newPath.readLengthHPC = readPaths[i].readLengthHPC;
-		newPath.path.insert(newPath.path.end(), readPaths[i].path.begin() + lastStart, readPaths[i].path.end());
+		newPath.readName = original.readName;
+		newPath.readLength = original.readLength;
+		newPath.readLengthHPC = original.readLengthHPC;
+		newPath.path.insert(newPath.path.end(), original.path.begin() + lastStart, original.path.begin() + j);
 		newPath.leftClip = 0;
-		if (lastStart == 0) newPath.leftClip = readPaths[i].leftClip;
-		newPath.rightClip = readPaths[i].rightClip;
+		if (lastStart == 0) newPath.leftClip = original.leftClip;
+		newPath.rightClip = 0;
 		size_t wantedStart = 0;
-		if (pathStartPoses[lastStart] > readPaths[i].leftClip) wantedStart = pathStartPoses[lastStart] - readPaths[i].leftClip;
-		assert(readPaths[i].leftClip < pathEndPoses.back());
-		assert(pathEndPoses.back() > readPaths[i].leftClip + readPaths[i].rightClip);
-		size_t wantedEnd = pathEndPoses.back() - readPaths[i].leftClip - readPaths[i].rightClip;
-		assert(wantedEnd == readPaths[i].readPoses.size());
-		newPath.readPoses.insert(newPath.readPoses.end(), readPaths[i].readPoses.begin() + wantedStart, readPaths[i].readPoses.begin() + wantedEnd);
-		readPaths.emplace_back(std::move(newPath));
-		readPaths[i].path.clear();
+		if (pathStartPoses[lastStart] > original.leftClip) wantedStart = pathStartPoses[lastStart] - original.leftClip;
+		assert(original.leftClip < pathEndPoses[j-1]);
+		size_t wantedEnd = pathEndPoses[j-1] - original.leftClip;
+		assert(wantedEnd < original.readPoses.size());
+		newPath.readPoses.insert(newPath.readPoses.end(), original.readPoses.begin() + wantedStart, original.readPoses.begin() + wantedEnd);
+		cutPaths.push_back(newPath);
+		lastStart = j;
+	}
+	assert(lastStart != 0);
+	ReadPath newPath;
+	newPath.readName = original.readName;
+	newPath.readLength = original.readLength;
+	newPath.readLengthHPC = original.readLengthHPC;
+	newPath.path.insert(newPath.path.end(), original.path.begin() + lastStart, original.path.end());
+	newPath.leftClip = 0;
+	if (lastStart == 0) newPath.leftClip = original.leftClip;
+	newPath.rightClip = original.rightClip;
+	size_t wantedStart = 0;
+	if (pathStartPoses[lastStart] > original.leftClip) wantedStart = pathStartPoses[lastStart] - original.leftClip;
+	assert(original.leftClip < pathEndPoses.back());
+	assert(pathEndPoses.back() > original.leftClip + original.rightClip);
+	size_t wantedEnd = pathEndPoses.back() - original.leftClip - original.rightClip;
+	assert(wantedEnd == original.readPoses.size());
+	newPath.readPoses.insert(newPath.readPoses.end(), original.readPoses.begin() + wantedStart, original.readPoses.begin() + wantedEnd);
+	cutPaths.push_back(newPath);
+}
+
+// todo maybe fix? or does it matter?
+// paths which contain edges that are not in the graph are split at them, the pieces go after the uncut paths
+// ranges of paths are cut in parallel, each into its own uncut and cut parts which are concatenated in order
+ReadPathStore cutRemovedEdgesFromPaths(const ResolvableUnitigGraph& graph, const ReadPathStore& readPaths, const size_t numThreads)
+{
+	const size_t numRanges = getNumRanges(readPaths.size(), numThreads);
+	std::vector<std::unique_ptr<ReadPathStore>> parts;
+	for (size_t i = 0; i < numRanges * 2; i++)
+	{
+		parts.emplace_back(new ReadPathStore);
 	}
+	iterateRangesMultithreaded(readPaths.size(), numThreads, [&graph, &readPaths, &parts, numRanges](size_t range, size_t start, size_t end)
+	{
+		ReadPathStore& result = *parts[range];
+		ReadPathStore& cutPaths = *parts[numRanges + range];
+		for (size_t i = start; i < end; i++)
+		{
+			cutPath(graph, readPaths, i, result, cutPaths);
+		}
+	});
+	return ReadPathStore::concatenate(parts, numThreads);
 }
 
 std::vector<std::pair<size_t, bool>> getUnitigPath(const ResolvableUnitigGraph& resolvableGraph, const size_t unitig)
@@ -1320,7 +1879,7 @@ size_t replaceUnitigPath(ResolvableUnitigGraph& resolvableGraph, const std::vect
 	resolvableGraph.unitigs.emplace_back();
 	resolvableGraph.edges.emplace_back();
 	resolvableGraph.unitigRemoved.emplace_back(false);
-	resolvableGraph.readsCrossingNode.emplace_back();
+	resolvableGraph.resizeCrossingReads(resolvableGraph.readsCrossingNode.size()+1);
 	for (size_t i = 0; i < newUnitig.size(); i++)
 	{
 		assert(i == 0 || resolvableGraph.edges[reverse(newUnitig[i])].size() == 1);
@@ -1506,7 +2065,7 @@ void createFakeEdgeNode(ResolvableUnitigGraph& resolvableGraph, const HashList&
 	resolvableGraph.unitigLeftClipBp.push_back(leftClipBp);
 	resolvableGraph.edges.emplace_back();
 	resolvableGraph.unitigRemoved.emplace_back(false);
-	resolvableGraph.readsCrossingNode.emplace_back();
+	resolvableGraph.resizeCrossingReads(resolvableGraph.readsCrossingNode.size()+1);
 	assert(resolvables.count(to.first) == 0 || unresolvables.count(to.first) == 1);
 	resolvableGraph.edges[std::make_pair(newIndex, true)].emplace(to);
 	resolvableGraph.edges[reverse(to)].emplace(std::make_pair(newIndex, false));
@@ -1599,7 +2158,7 @@ void createEdgeNode(ResolvableUnitigGraph& resolvableGraph, const HashList& hash
 	resolvableGraph.unitigLeftClipBp.push_back(leftClipBp);
 	resolvableGraph.edges.emplace_back();
 	resolvableGraph.unitigRemoved.emplace_back(false);
-	resolvableGraph.readsCrossingNode.emplace_back();
+	resolvableGraph.resizeCrossingReads(resolvableGraph.readsCrossingNode.size()+1);
 	if (resolvables.count(to.first) == 0 || unresolvables.count(to.first) == 1)
 	{
 		resolvableGraph.edges[std::make_pair(newIndex, true)].emplace(to);
@@ -1668,7 +2227,7 @@ size_t getTrimAmountToCheck(const ResolvableUnitigGraph& resolvableGraph, const
 	return 0;
 }
 
-std::vector<ResolveTriplet> getRawTriplets(const ResolvableUnitigGraph& resolvableGraph, const phmap::flat_hash_set<size_t>& resolvables, const std::vector<PathGroup>& readPaths, size_t node, size_t minCoverage, bool partTriplets)
+RawTripletCoverage countRawTripletCoverage(const ResolvableUnitigGraph& resolvableGraph, const std::vector<PathGroup>& readPaths, size_t node, bool partTriplets)
 {
 	phmap::flat_hash_map<std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>>, size_t> tripletCoverage;
 	for (const std::pair<uint32_t, uint32_t> pospair : resolvableGraph.iterateCrossingReads(node, readPaths))
@@ -1862,11 +2421,11 @@ std::vector<ResolveTriplet> getRawTriplets(const ResolvableUnitigGraph& resolvab
 			size_t coverage = 0;
 			for (const auto& read : readPaths[pair.first].reads)
 			{
-				minLeftClip = std::min(minLeftClip, read.rightClip);
+				minLeftClip = std::min(minLeftClip, (size_t)read.rightClip);
 			}
 			for (const auto& read : readPaths[pair.second].reads)
 			{
-				minRightClip = std::min(minRightClip, read.leftClip);
+				minRightClip = std::min(minRightClip, (size_t)read.leftClip);
 			}
 			std::unordered_set<size_t> rightReadNames;
 			for (const auto& read : readPaths[pair.second].reads)
@@ -1894,8 +2453,27 @@ std::vector<ResolveTriplet> getRawTriplets(const ResolvableUnitigGraph& resolvab
 			}
 		}
 	}
+	RawTripletCoverage result;
+	result.counted = true;
+	result.fwEdgeCount = resolvableGraph.edges[std::make_pair(node, true)].size();
+	result.bwEdgeCount = resolvableGraph.edges[std::make_pair(node, false)].size();
+	result.coverage.insert(result.coverage.end(), tripletCoverage.begin(), tripletCoverage.end());
+	if (partTriplets)
+	{
+		result.partCounted = true;
+		result.partCoverage.insert(result.partCoverage.end(), partTripletCoverage.begin(), partTripletCoverage.end());
+	}
+	return result;
+}
+
+// triplet coverages are reused from earlier rounds if nothing they depend on changed
+// only writes the cache entry of node, so different nodes can be counted from different threads at the same time
+std::vector<ResolveTriplet> getRawTriplets(const ResolvableUnitigGraph& resolvableGraph, const phmap::flat_hash_set<size_t>& resolvables, const std::vector<PathGroup>& readPaths, size_t node, size_t minCoverage, bool partTriplets)
+{
+	if (!resolvableGraph.rawTripletsCached(node, partTriplets)) resolvableGraph.rawTripletCache[node] = countRawTripletCoverage(resolvableGraph, readPaths, node, partTriplets);
+	const RawTripletCoverage& cached = resolvableGraph.rawTripletCache[node];
 	std::vector<ResolveTriplet> coveredTriplets;
-	for (auto pair : tripletCoverage)
+	for (auto pair : cached.coverage)
 	{
 		if (pair.second < minCoverage) continue;
 		coveredTriplets.emplace_back(pair.first.first, pair.first.second, pair.second);
@@ -1905,7 +2483,7 @@ std::vector<ResolveTriplet> getRawTriplets(const ResolvableUnitigGraph& resolvab
 		bool canAddPartTriplets = true;
 		std::unordered_set<std::pair<size_t, bool>> uniqueBwMatches;
 		std::unordered_set<std::pair<size_t, bool>> uniqueFwMatches;
-		for (auto pair : partTripletCoverage)
+		for (auto pair : cached.partCoverage)
 		{
 			if (pair.second < minCoverage) continue;
 			if (uniqueBwMatches.count(pair.first.first) == 1)
@@ -1934,7 +2512,7 @@ std::vector<ResolveTriplet> getRawTriplets(const ResolvableUnitigGraph& resolvab
 		if (canAddPartTriplets)
 		{
 			coveredTriplets.clear();
-			for (auto pair : partTripletCoverage)
+			for (auto pair : cached.partCoverage)
 			{
 				if (pair.second < minCoverage) continue;
 				coveredTriplets.emplace_back(pair.first.first, pair.first.second, pair.second);
@@ -2203,271 +2781,327 @@ std::vector<ResolveTriplet> getValidTriplets(const ResolvableUnitigGraph& resolv
 	return triplets;
 }
 
-void replacePaths(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const BigVectorSet& actuallyResolvables, const phmap::flat_hash_map<std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>>, size_t>& newEdgeNodes)
+// getValidTriplets for each of nodes, result[i] has the triplets of nodes[i]
+std::vector<std::vector<ResolveTriplet>> getValidTripletsMultithreaded(const ResolvableUnitigGraph& resolvableGraph, const phmap::flat_hash_set<size_t>& resolvables, const std::vector<PathGroup>& readPaths, const std::vector<size_t>& nodes, size_t minCoverage, bool unconditional, bool guesswork, const bool copycountFilterHeuristic, const size_t numThreads)
 {
-	phmap::flat_hash_set<size_t> relevantReads;
-	for (const auto node : actuallyResolvables)
-	{
-		for (const auto pospair : resolvableGraph.iterateCrossingReads(node, readPaths)) relevantReads.insert(pospair.first);
-	}
-	for (const size_t i : relevantReads)
+	// getValidTriplets recounts the coverages of the node and its neighbors if they were invalidated
+	// do those writes here so the threads only read the graph
+	if (guesswork)
 	{
-		PathGroup newPath;
-		std::vector<size_t> nodePosStarts;
-		std::vector<size_t> nodePosEnds;
-		size_t runningKmerStartPos = 0;
-		size_t runningKmerEndPos = 0;
-		std::vector<size_t> breakFromInvalidEdge;
-		for (size_t j = 0; j < readPaths[i].path.size(); j++)
+		for (const size_t node : nodes)
 		{
-			runningKmerStartPos = runningKmerEndPos;
-			runningKmerEndPos += resolvableGraph.unitigs[readPaths[i].path[j].first].size();
-			size_t overlap = 0;
-			if (j > 0)
+			resolvableGraph.getCoverage(readPaths, node);
+			for (auto edge : resolvableGraph.edges[std::make_pair(node, true)])
 			{
-				overlap = resolvableGraph.overlaps.at(canon(readPaths[i].path[j-1], readPaths[i].path[j]));
-				runningKmerEndPos -= overlap;
+				resolvableGraph.getCoverage(readPaths, edge.first);
 			}
-			if (!actuallyResolvables.get(readPaths[i].path[j].first))
+			for (auto edge : resolvableGraph.edges[std::make_pair(node, false)])
 			{
-				newPath.path.push_back(readPaths[i].path[j]);
-				size_t start = 0;
-				if (j > 0)
-				{
-					start = runningKmerStartPos;
-					// assert(start == getNumberOfHashes(resolvableGraph, 0, 0, std::vector<std::pair<size_t, bool>> { readPaths[i].path.begin(), readPaths[i].path.begin() + j }));
-					assert(start >= overlap);
-					start -= overlap;
-				}
-				nodePosStarts.push_back(start);
-				size_t end = runningKmerEndPos;
-				// assert(end == getNumberOfHashes(resolvableGraph, 0, 0, std::vector<std::pair<size_t, bool>> { readPaths[i].path.begin(), readPaths[i].path.begin() + j + 1 }));
-				nodePosEnds.push_back(end);
-				continue;
+				resolvableGraph.getCoverage(readPaths, edge.first);
 			}
-			if (j > 0 && j < readPaths[i].path.size()-1 && !actuallyResolvables.get(readPaths[i].path[j-1].first) && !actuallyResolvables.get(readPaths[i].path[j+1].first))
+		}
+	}
+	std::vector<std::vector<ResolveTriplet>> result;
+	result.resize(nodes.size());
+	iterateChunksMultithreaded(nodes.size(), numThreads, 16, [&resolvableGraph, &resolvables, &readPaths, &nodes, &result, minCoverage, unconditional, guesswork, copycountFilterHeuristic](size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			result[i] = getValidTriplets(resolvableGraph, resolvables, readPaths, nodes[i], minCoverage, unconditional, guesswork, copycountFilterHeuristic);
+		}
+	});
+	return result;
+}
+
+// the paths which replace oldPath once the resolved nodes are split into edge nodes, empty if nothing of it remains
+std::vector<PathGroup> getReplacementPaths(const ResolvableUnitigGraph& resolvableGraph, const PathGroup& oldPath, const BigVectorSet& actuallyResolvables, const phmap::flat_hash_map<std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>>, size_t>& newEdgeNodes)
+{
+	std::vector<PathGroup> result;
+	PathGroup newPath;
+	std::vector<size_t> nodePosStarts;
+	std::vector<size_t> nodePosEnds;
+	size_t runningKmerStartPos = 0;
+	size_t runningKmerEndPos = 0;
+	std::vector<size_t> breakFromInvalidEdge;
+	for (size_t j = 0; j < oldPath.path.size(); j++)
+	{
+		runningKmerStartPos = runningKmerEndPos;
+		runningKmerEndPos += resolvableGraph.unitigs[oldPath.path[j].first].size();
+		size_t overlap = 0;
+		if (j > 0)
+		{
+			overlap = resolvableGraph.overlaps.at(canon(oldPath.path[j-1], oldPath.path[j]));
+			runningKmerEndPos -= overlap;
+		}
+		if (!actuallyResolvables.get(oldPath.path[j].first))
+		{
+			newPath.path.push_back(oldPath.path[j]);
+			size_t start = 0;
+			if (j > 0)
 			{
-				if (newEdgeNodes.count(std::make_pair(reverse(readPaths[i].path[j]), reverse(readPaths[i].path[j-1]))) == 0 && newEdgeNodes.count(std::make_pair(readPaths[i].path[j-1], readPaths[i].path[j])) == 0)
-				{
-					if (newEdgeNodes.count(std::make_pair(readPaths[i].path[j], readPaths[i].path[j+1])) == 0 && newEdgeNodes.count(std::make_pair(reverse(readPaths[i].path[j+1]), reverse(readPaths[i].path[j]))) == 0)
-					{
-						assert(breakFromInvalidEdge.size() == 0 || breakFromInvalidEdge.back() != newPath.path.size());
-						if (newPath.path.size() >= 1) breakFromInvalidEdge.push_back(newPath.path.size());
-						continue;
-					}
-				}
+				start = runningKmerStartPos;
+				// assert(start == getNumberOfHashes(resolvableGraph, 0, 0, std::vector<std::pair<size_t, bool>> { oldPath.path.begin(), oldPath.path.begin() + j }));
+				assert(start >= overlap);
+				start -= overlap;
 			}
-			if (j > 0 && actuallyResolvables.get(readPaths[i].path[j-1].first) && newEdgeNodes.count(std::make_pair(reverse(readPaths[i].path[j]), reverse(readPaths[i].path[j-1]))) == 0 && newEdgeNodes.count(std::make_pair(readPaths[i].path[j-1], readPaths[i].path[j])) == 0)
+			nodePosStarts.push_back(start);
+			size_t end = runningKmerEndPos;
+			// assert(end == getNumberOfHashes(resolvableGraph, 0, 0, std::vector<std::pair<size_t, bool>> { oldPath.path.begin(), oldPath.path.begin() + j + 1 }));
+			nodePosEnds.push_back(end);
+			continue;
+		}
+		if (j > 0 && j < oldPath.path.size()-1 && !actuallyResolvables.get(oldPath.path[j-1].first) && !actuallyResolvables.get(oldPath.path[j+1].first))
+		{
+			if (newEdgeNodes.count(std::make_pair(reverse(oldPath.path[j]), reverse(oldPath.path[j-1]))) == 0 && newEdgeNodes.count(std::make_pair(oldPath.path[j-1], oldPath.path[j])) == 0)
 			{
-				if (breakFromInvalidEdge.size() == 0 || breakFromInvalidEdge.back() != newPath.path.size())
+				if (newEdgeNodes.count(std::make_pair(oldPath.path[j], oldPath.path[j+1])) == 0 && newEdgeNodes.count(std::make_pair(reverse(oldPath.path[j+1]), reverse(oldPath.path[j]))) == 0)
 				{
+					assert(breakFromInvalidEdge.size() == 0 || breakFromInvalidEdge.back() != newPath.path.size());
 					if (newPath.path.size() >= 1) breakFromInvalidEdge.push_back(newPath.path.size());
+					continue;
 				}
-				continue;
-			}
-			if (j > 0 && newEdgeNodes.count(std::make_pair(reverse(readPaths[i].path[j]), reverse(readPaths[i].path[j-1]))) == 1)
-			{
-				size_t start = runningKmerStartPos;
-				// assert(start == getNumberOfHashes(resolvableGraph, 0, 0, std::vector<std::pair<size_t, bool>> { readPaths[i].path.begin(), readPaths[i].path.begin() + j }));
-				if (!actuallyResolvables.get(readPaths[i].path[j-1].first))
-				{
-					assert(start >= overlap);
-					start -= overlap;
-				}
-				else
-				{
-					assert(start >= resolvableGraph.unitigs[readPaths[i].path[j-1].first].size());
-					start -= resolvableGraph.unitigs[readPaths[i].path[j-1].first].size();
-				}
-				nodePosStarts.push_back(start);
-				size_t end = runningKmerEndPos;
-				// assert(end == getNumberOfHashes(resolvableGraph, 0, 0, std::vector<std::pair<size_t, bool>> { readPaths[i].path.begin(), readPaths[i].path.begin() + j + 1 }));
-				nodePosEnds.push_back(end);
-				newPath.path.emplace_back(newEdgeNodes.at(std::make_pair(reverse(readPaths[i].path[j]), reverse(readPaths[i].path[j-1]))), false);
-			}
-			if (j < readPaths[i].path.size()-1 && newEdgeNodes.count(std::make_pair(readPaths[i].path[j], readPaths[i].path[j+1])) == 1)
-			{
-				size_t start = 0;
-				if (j > 0)
-				{
-					start = runningKmerStartPos;
-					// assert(start == getNumberOfHashes(resolvableGraph, 0, 0, std::vector<std::pair<size_t, bool>> { readPaths[i].path.begin(), readPaths[i].path.begin() + j }));
-					assert(start >= overlap);
-					start -= overlap;
-				}
-				nodePosStarts.push_back(start);
-				size_t end = runningKmerEndPos;
-				// assert(end == getNumberOfHashes(resolvableGraph, 0, 0, std::vector<std::pair<size_t, bool>> { readPaths[i].path.begin(), readPaths[i].path.begin() + j + 1 }));
-				if (actuallyResolvables.get(readPaths[i].path[j+1].first))
-				{
-					end += resolvableGraph.unitigs[readPaths[i].path[j+1].first].size();
-					end -= resolvableGraph.overlaps.at(canon(readPaths[i].path[j], readPaths[i].path[j+1]));
-					// assert(end == getNumberOfHashes(resolvableGraph, 0, 0, std::vector<std::pair<size_t, bool>> { readPaths[i].path.begin(), readPaths[i].path.begin() + j + 2 }));
-				}
-				nodePosEnds.push_back(end);
-				newPath.path.emplace_back(newEdgeNodes.at(std::make_pair(readPaths[i].path[j], readPaths[i].path[j+1])), true);
 			}
 		}
-		std::reverse(breakFromInvalidEdge.begin(), breakFromInvalidEdge.end());
-		size_t kmerPathLength = runningKmerEndPos;
-		assert(kmerPathLength == getNumberOfHashes(resolvableGraph, 0, 0, readPaths[i].path));
-		if (newPath.path.size() == 0)
+		if (j > 0 && actuallyResolvables.get(oldPath.path[j-1].first) && newEdgeNodes.count(std::make_pair(reverse(oldPath.path[j]), reverse(oldPath.path[j-1]))) == 0 && newEdgeNodes.count(std::make_pair(oldPath.path[j-1], oldPath.path[j])) == 0)
 		{
-			erasePath(resolvableGraph, readPaths, i);
+			if (breakFromInvalidEdge.size() == 0 || breakFromInvalidEdge.back() != newPath.path.size())
+			{
+				if (newPath.path.size() >= 1) breakFromInvalidEdge.push_back(newPath.path.size());
+			}
 			continue;
 		}
-		std::swap(readPaths[i].reads, newPath.reads);
-		assert(nodePosStarts.size() == nodePosEnds.size());
-		assert(nodePosEnds.size() == newPath.path.size());
-		assert(nodePosEnds.back() <= kmerPathLength);
-		if (nodePosStarts[0] != 0 || nodePosEnds.back() != kmerPathLength)
+		if (j > 0 && newEdgeNodes.count(std::make_pair(reverse(oldPath.path[j]), reverse(oldPath.path[j-1]))) == 1)
 		{
-			size_t startRemove = nodePosStarts[0];
-			for (auto& read : newPath.reads)
+			size_t start = runningKmerStartPos;
+			// assert(start == getNumberOfHashes(resolvableGraph, 0, 0, std::vector<std::pair<size_t, bool>> { oldPath.path.begin(), oldPath.path.begin() + j }));
+			if (!actuallyResolvables.get(oldPath.path[j-1].first))
 			{
-				if (nodePosStarts[0] > read.leftClip)
-				{
-					read.readPosStartIndex = read.readPosStartIndex + nodePosStarts[0] - read.leftClip;
-					read.leftClip = 0;
-				}
-				else
-				{
-					assert(read.leftClip >= nodePosStarts[0]);
-					read.leftClip -= nodePosStarts[0];
-				}
-				if (nodePosEnds.back() < kmerPathLength - read.rightClip)
-				{
-					size_t extraClip = (kmerPathLength - read.rightClip) - nodePosEnds.back();
-					assert(extraClip < read.readPosEndIndex - read.readPosStartIndex);
-					read.readPosEndIndex -= extraClip;
-					read.rightClip = 0;
-				}
-				else
-				{
-					assert(read.rightClip >= (kmerPathLength - nodePosEnds.back()));
-					read.rightClip -= (kmerPathLength - nodePosEnds.back());
-				}
-				assert(nodePosEnds.back() - nodePosStarts[0] == (read.readPosEndIndex - read.readPosStartIndex) + read.leftClip + read.rightClip);
+				assert(start >= overlap);
+				start -= overlap;
 			}
-			for (size_t j = 0; j < nodePosStarts.size(); j++)
+			else
 			{
-				assert(nodePosStarts[j] >= startRemove);
-				nodePosStarts[j] -= startRemove;
-				assert(nodePosEnds[j] >= startRemove);
-				nodePosEnds[j] -= startRemove;
+				assert(start >= resolvableGraph.unitigs[oldPath.path[j-1].first].size());
+				start -= resolvableGraph.unitigs[oldPath.path[j-1].first].size();
 			}
+			nodePosStarts.push_back(start);
+			size_t end = runningKmerEndPos;
+			// assert(end == getNumberOfHashes(resolvableGraph, 0, 0, std::vector<std::pair<size_t, bool>> { oldPath.path.begin(), oldPath.path.begin() + j + 1 }));
+			nodePosEnds.push_back(end);
+			newPath.path.emplace_back(newEdgeNodes.at(std::make_pair(reverse(oldPath.path[j]), reverse(oldPath.path[j-1]))), false);
 		}
-		assert(nodePosStarts[0] == 0);
-		size_t lastStart = 0;
-		for (size_t j = 1; j < newPath.path.size(); j++)
+		if (j < oldPath.path.size()-1 && newEdgeNodes.count(std::make_pair(oldPath.path[j], oldPath.path[j+1])) == 1)
 		{
-			assert(resolvableGraph.edges[newPath.path[j-1]].count(newPath.path[j]) == resolvableGraph.edges[reverse(newPath.path[j])].count(reverse(newPath.path[j-1])));
-			assert(breakFromInvalidEdge.size() == 0 || breakFromInvalidEdge.back() >= j);
-			if (resolvableGraph.edges[newPath.path[j-1]].count(newPath.path[j]) == 0 || (breakFromInvalidEdge.size() > 0 && breakFromInvalidEdge.back() == j))
+			size_t start = 0;
+			if (j > 0)
 			{
-				if (breakFromInvalidEdge.size() > 0 && breakFromInvalidEdge.back() == j)
-				{
-					breakFromInvalidEdge.pop_back();
-				}
-				PathGroup path;
-				path.path.insert(path.path.end(), newPath.path.begin() + lastStart, newPath.path.begin() + j);
-				path.reads.reserve(newPath.reads.size());
-				for (const auto& read : newPath.reads)
-				{
-					size_t posesStart = nodePosStarts[lastStart];
-					size_t posesEnd = nodePosEnds[j-1];
-					size_t leftClipRemove = 0;
-					size_t rightClipRemove = 0;
-					if (posesEnd < read.leftClip + (read.readPosEndIndex - read.readPosStartIndex))
-					{
-						rightClipRemove = read.rightClip;
-						posesEnd -= read.leftClip;
-					}
-					else if (posesEnd < read.leftClip + read.rightClip + (read.readPosEndIndex - read.readPosStartIndex))
-					{
-						rightClipRemove = (read.leftClip + read.rightClip + (read.readPosEndIndex - read.readPosStartIndex)) - posesEnd;
-						posesEnd = (read.readPosEndIndex - read.readPosStartIndex);
-					}
-					if (posesStart > read.leftClip)
-					{
-						leftClipRemove = read.leftClip;
-						posesStart = posesStart - read.leftClip;
-					}
-					else if (posesStart > 0)
-					{
-						leftClipRemove = posesStart;
-						posesStart = 0;
-					}
-					if (posesEnd-posesStart > read.readPosEndIndex - read.readPosStartIndex)
-					{
-						posesEnd = read.readPosEndIndex - read.readPosStartIndex + posesStart;
-					}
-					assert(posesStart < posesEnd);
-					assert(posesEnd <= (read.readPosEndIndex - read.readPosStartIndex));
-					path.reads.emplace_back();
-					path.reads.back().readInfoIndex = read.readInfoIndex;
-					path.reads.back().readPosZeroOffset = read.readPosZeroOffset;
-					path.reads.back().readPosStartIndex = read.readPosStartIndex + posesStart;
-					path.reads.back().readPosEndIndex = read.readPosStartIndex + posesEnd;
-					path.reads.back().leftClip = read.leftClip;
-					path.reads.back().rightClip = read.rightClip;
-					assert(path.reads.back().leftClip >= leftClipRemove);
-					path.reads.back().leftClip -= leftClipRemove;
-					assert(path.reads.back().rightClip >= rightClipRemove);
-					path.reads.back().rightClip -= rightClipRemove;
-					path.reads.back().readNameIndex = read.readNameIndex;
-				}
-				addPathButFirstMaybeTrim(resolvableGraph, readPaths, std::move(path));
-				lastStart = j;
+				start = runningKmerStartPos;
+				// assert(start == getNumberOfHashes(resolvableGraph, 0, 0, std::vector<std::pair<size_t, bool>> { oldPath.path.begin(), oldPath.path.begin() + j }));
+				assert(start >= overlap);
+				start -= overlap;
+			}
+			nodePosStarts.push_back(start);
+			size_t end = runningKmerEndPos;
+			// assert(end == getNumberOfHashes(resolvableGraph, 0, 0, std::vector<std::pair<size_t, bool>> { oldPath.path.begin(), oldPath.path.begin() + j + 1 }));
+			if (actuallyResolvables.get(oldPath.path[j+1].first))
+			{
+				end += resolvableGraph.unitigs[oldPath.path[j+1].first].size();
+				end -= resolvableGraph.overlaps.at(canon(oldPath.path[j], oldPath.path[j+1]));
+				// assert(end == getNumberOfHashes(resolvableGraph, 0, 0, std::vector<std::pair<size_t, bool>> { oldPath.path.begin(), oldPath.path.begin() + j + 2 }));
 			}
+			nodePosEnds.push_back(end);
+			newPath.path.emplace_back(newEdgeNodes.at(std::make_pair(oldPath.path[j], oldPath.path[j+1])), true);
 		}
-		PathGroup path;
-		path.path.insert(path.path.end(), newPath.path.begin() + lastStart, newPath.path.end());
-		path.reads.reserve(newPath.reads.size());
-		for (const auto& read : newPath.reads)
+	}
+	std::reverse(breakFromInvalidEdge.begin(), breakFromInvalidEdge.end());
+	size_t kmerPathLength = runningKmerEndPos;
+	assert(kmerPathLength == getNumberOfHashes(resolvableGraph, 0, 0, oldPath.path));
+	if (newPath.path.size() == 0) return result;
+	newPath.reads = oldPath.reads;
+	assert(nodePosStarts.size() == nodePosEnds.size());
+	assert(nodePosEnds.size() == newPath.path.size());
+	assert(nodePosEnds.back() <= kmerPathLength);
+	if (nodePosStarts[0] != 0 || nodePosEnds.back() != kmerPathLength)
+	{
+		size_t startRemove = nodePosStarts[0];
+		for (auto& read : newPath.reads)
 		{
-			size_t posesStart = nodePosStarts[lastStart];
-			size_t posesEnd = nodePosEnds.back();
-			size_t leftClipRemove = 0;
-			size_t rightClipRemove = 0;
-			assert(posesEnd <= read.leftClip + read.rightClip + (read.readPosEndIndex - read.readPosStartIndex));
-			if (posesEnd < read.leftClip + (read.readPosEndIndex - read.readPosStartIndex))
+			if (nodePosStarts[0] > read.leftClip)
+			{
+				read.readPosStartIndex = read.readPosStartIndex + nodePosStarts[0] - read.leftClip;
+				read.leftClip = 0;
+			}
+			else
+			{
+				assert(read.leftClip >= nodePosStarts[0]);
+				read.leftClip -= nodePosStarts[0];
+			}
+			if (nodePosEnds.back() < kmerPathLength - read.rightClip)
 			{
-				rightClipRemove = read.rightClip;
-				posesEnd -= read.leftClip;
+				size_t extraClip = (kmerPathLength - read.rightClip) - nodePosEnds.back();
+				assert(extraClip < read.readPosEndIndex - read.readPosStartIndex);
+				read.readPosEndIndex -= extraClip;
+				read.rightClip = 0;
 			}
 			else
 			{
-				rightClipRemove = (read.leftClip + read.rightClip + (read.readPosEndIndex - read.readPosStartIndex)) - posesEnd;
-				posesEnd = (read.readPosEndIndex - read.readPosStartIndex);
+				assert(read.rightClip >= (kmerPathLength - nodePosEnds.back()));
+				read.rightClip -= (kmerPathLength - nodePosEnds.back());
 			}
-			if (posesStart > read.leftClip)
+			assert(nodePosEnds.back() - nodePosStarts[0] == (read.readPosEndIndex - read.readPosStartIndex) + read.leftClip + read.rightClip);
+		}
+		for (size_t j = 0; j < nodePosStarts.size(); j++)
+		{
+			assert(nodePosStarts[j] >= startRemove);
+			nodePosStarts[j] -= startRemove;
+			assert(nodePosEnds[j] >= startRemove);
+			nodePosEnds[j] -= startRemove;
+		}
+	}
+	assert(nodePosStarts[0] == 0);
+	size_t lastStart = 0;
+	for (size_t j = 1; j < newPath.path.size(); j++)
+	{
+		assert(resolvableGraph.edges[newPath.path[j-1]].count(newPath.path[j]) == resolvableGraph.edges[reverse(newPath.path[j])].count(reverse(newPath.path[j-1])));
+		assert(breakFromInvalidEdge.size() == 0 || breakFromInvalidEdge.back() >= j);
+		if (resolvableGraph.edges[newPath.path[j-1]].count(newPath.path[j]) == 0 || (breakFromInvalidEdge.size() > 0 && breakFromInvalidEdge.back() == j))
+		{
+			if (breakFromInvalidEdge.size() > 0 && breakFromInvalidEdge.back() == j)
 			{
-				leftClipRemove = read.leftClip;
-				posesStart = posesStart - read.leftClip;
+				breakFromInvalidEdge.pop_back();
 			}
-			else if (posesStart > 0)
+			PathGroup path;
+			path.path.insert(path.path.end(), newPath.path.begin() + lastStart, newPath.path.begin() + j);
+			path.reads.reserve(newPath.reads.size());
+			for (const auto& read : newPath.reads)
 			{
-				leftClipRemove = posesStart;
-				posesStart = 0;
+				size_t posesStart = nodePosStarts[lastStart];
+				size_t posesEnd = nodePosEnds[j-1];
+				size_t leftClipRemove = 0;
+				size_t rightClipRemove = 0;
+				if (posesEnd < read.leftClip + (read.readPosEndIndex - read.readPosStartIndex))
+				{
+					rightClipRemove = read.rightClip;
+					posesEnd -= read.leftClip;
+				}
+				else if (posesEnd < read.leftClip + read.rightClip + (read.readPosEndIndex - read.readPosStartIndex))
+				{
+					rightClipRemove = (read.leftClip + read.rightClip + (read.readPosEndIndex - read.readPosStartIndex)) - posesEnd;
+					posesEnd = (read.readPosEndIndex - read.readPosStartIndex);
+				}
+				if (posesStart > read.leftClip)
+				{
+					leftClipRemove = read.leftClip;
+					posesStart = posesStart - read.leftClip;
+				}
+				else if (posesStart > 0)
+				{
+					leftClipRemove = posesStart;
+					posesStart = 0;
+				}
+				if (posesEnd-posesStart > read.readPosEndIndex - read.readPosStartIndex)
+				{
+					posesEnd = read.readPosEndIndex - read.readPosStartIndex + posesStart;
+				}
+				assert(posesStart < posesEnd);
+				assert(posesEnd <= (read.readPosEndIndex - read.readPosStartIndex));
+				path.reads.emplace_back();
+				path.reads.back().readInfoIndex = read.readInfoIndex;
+				path.reads.back().readPosZeroOffset = read.readPosZeroOffset;
+				path.reads.back().readPosStartIndex = read.readPosStartIndex + posesStart;
+				path.reads.back().readPosEndIndex = read.readPosStartIndex + posesEnd;
+				path.reads.back().leftClip = read.leftClip;
+				path.reads.back().rightClip = read.rightClip;
+				assert(path.reads.back().leftClip >= leftClipRemove);
+				path.reads.back().leftClip -= leftClipRemove;
+				assert(path.reads.back().rightClip >= rightClipRemove);
+				path.reads.back().rightClip -= rightClipRemove;
+				path.reads.back().readNameIndex = read.readNameIndex;
 			}
-			assert(posesStart < posesEnd);
-			assert(posesEnd <= (read.readPosEndIndex - read.readPosStartIndex));
-			path.reads.emplace_back();
-			path.reads.back().readInfoIndex = read.readInfoIndex;
-			path.reads.back().readPosZeroOffset = read.readPosZeroOffset;
-			path.reads.back().readPosStartIndex = read.readPosStartIndex + posesStart;
-			path.reads.back().readPosEndIndex = read.readPosStartIndex + posesEnd;
-			path.reads.back().leftClip = read.leftClip;
-			path.reads.back().rightClip = read.rightClip;
-			assert(path.reads.back().leftClip >= leftClipRemove);
-			path.reads.back().leftClip -= leftClipRemove;
-			assert(path.reads.back().rightClip >= rightClipRemove);
-			path.reads.back().rightClip -= rightClipRemove;
-			path.reads.back().readNameIndex = read.readNameIndex;
+			result.push_back(std::move(path));
+			lastStart = j;
+		}
+	}
+	PathGroup path;
+	path.path.insert(path.path.end(), newPath.path.begin() + lastStart, newPath.path.end());
+	path.reads.reserve(newPath.reads.size());
+	for (const auto& read : newPath.reads)
+	{
+		size_t posesStart = nodePosStarts[lastStart];
+		size_t posesEnd = nodePosEnds.back();
+		size_t leftClipRemove = 0;
+		size_t rightClipRemove = 0;
+		assert(posesEnd <= read.leftClip + read.rightClip + (read.readPosEndIndex - read.readPosStartIndex));
+		if (posesEnd < read.leftClip + (read.readPosEndIndex - read.readPosStartIndex))
+		{
+			rightClipRemove = read.rightClip;
+			posesEnd -= read.leftClip;
+		}
+		else
+		{
+			rightClipRemove = (read.leftClip + read.rightClip + (read.readPosEndIndex - read.readPosStartIndex)) - posesEnd;
+			posesEnd = (read.readPosEndIndex - read.readPosStartIndex);
+		}
+		if (posesStart > read.leftClip)
+		{
+			leftClipRemove = read.leftClip;
+			posesStart = posesStart - read.leftClip;
+		}
+		else if (posesStart > 0)
+		{
+			leftClipRemove = posesStart;
+			posesStart = 0;
+		}
+		assert(posesStart < posesEnd);
+		assert(posesEnd <= (read.readPosEndIndex - read.readPosStartIndex));
+		path.reads.emplace_back();
+		path.reads.back().readInfoIndex = read.readInfoIndex;
+		path.reads.back().readPosZeroOffset = read.readPosZeroOffset;
+		path.reads.back().readPosStartIndex = read.readPosStartIndex + posesStart;
+		path.reads.back().readPosEndIndex = read.readPosStartIndex + posesEnd;
+		path.reads.back().leftClip = read.leftClip;
+		path.reads.back().rightClip = read.rightClip;
+		assert(path.reads.back().leftClip >= leftClipRemove);
+		path.reads.back().leftClip -= leftClipRemove;
+		assert(path.reads.back().rightClip >= rightClipRemove);
+		path.reads.back().rightClip -= rightClipRemove;
+		path.reads.back().readNameIndex = read.readNameIndex;
+	}
+	result.push_back(std::move(path));
+	return result;
+}
+
+void replacePaths(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const BigVectorSet& actuallyResolvables, const phmap::flat_hash_map<std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>>, size_t>& newEdgeNodes, const size_t numThreads)
+{
+	std::vector<size_t> relevantReads;
+	{
+		phmap::flat_hash_set<size_t> relevantReadSet;
+		for (const auto node : actuallyResolvables)
+		{
+			for (const auto pospair : resolvableGraph.iterateCrossingReads(node, readPaths)) relevantReadSet.insert(pospair.first);
+		}
+		relevantReads.insert(relevantReads.end(), relevantReadSet.begin(), relevantReadSet.end());
+	}
+	// rewriting a path only reads the graph so they can be done in parallel
+	// adding and erasing paths is done afterwards in the same order as a single threaded loop to keep path indices deterministic
+	std::vector<std::vector<PathGroup>> replacements;
+	replacements.resize(relevantReads.size());
+	iterateChunksMultithreaded(relevantReads.size(), numThreads, 64, [&resolvableGraph, &readPaths, &actuallyResolvables, &newEdgeNodes, &relevantReads, &replacements](size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			replacements[i] = getReplacementPaths(resolvableGraph, readPaths[relevantReads[i]], actuallyResolvables, newEdgeNodes);
+		}
+	});
+	for (size_t i = 0; i < relevantReads.size(); i++)
+	{
+		for (auto& path : replacements[i])
+		{
+			addPathButFirstMaybeTrim(resolvableGraph, readPaths, std::move(path));
 		}
-		addPathButFirstMaybeTrim(resolvableGraph, readPaths, std::move(path));
-		erasePath(resolvableGraph, readPaths, i);
+		erasePath(resolvableGraph, readPaths, relevantReads[i]);
+		std::vector<PathGroup> tmp;
+		std::swap(tmp, replacements[i]);
 	}
 }
 
@@ -2480,7 +3114,7 @@ public:
 	phmap::flat_hash_map<std::pair<size_t, bool>, size_t> maybeTrimmable;
 };
 
-ResolutionResult resolve(ResolvableUnitigGraph& resolvableGraph, const HashList& hashlist, std::vector<PathGroup>& readPaths, const phmap::flat_hash_set<size_t>& resolvables, const size_t minCoverage, const bool unconditional, const bool guesswork, const bool copycountFilterHeuristic, std::ostream& log)
+ResolutionResult resolve(ResolvableUnitigGraph& resolvableGraph, const HashList& hashlist, std::vector<PathGroup>& readPaths, const phmap::flat_hash_set<size_t>& resolvables, const size_t minCoverage, const bool unconditional, const bool guesswork, const bool copycountFilterHeuristic, const size_t numThreads, std::ostream& log)
 {
 	static BigVectorSet actuallyResolvables;
 	ResolutionResult result;
@@ -2506,10 +3140,25 @@ ResolutionResult resolve(ResolvableUnitigGraph& resolvableGraph, const HashList&
 			}
 		}
 	}
+	// the graph and paths don't change until the edge nodes are added so each node's triplets are only needed once
+	phmap::flat_hash_map<size_t, std::vector<ResolveTriplet>> validTriplets;
+	{
+		std::vector<size_t> tripletNodes;
+		for (auto node : resolvables)
+		{
+			if (unresolvables.count(node) == 1) continue;
+			tripletNodes.push_back(node);
+		}
+		auto triplets = getValidTripletsMultithreaded(resolvableGraph, resolvables, readPaths, tripletNodes, minCoverage, unconditional, guesswork, copycountFilterHeuristic, numThreads);
+		for (size_t i = 0; i < tripletNodes.size(); i++)
+		{
+			validTriplets[tripletNodes[i]] = std::move(triplets[i]);
+		}
+	}
 	for (auto node : resolvables)
 	{
 		if (unresolvables.count(node) == 1) continue;
-		auto triplets = getValidTriplets(resolvableGraph, resolvables, readPaths, node, minCoverage, unconditional, guesswork, copycountFilterHeuristic);
+		const auto& triplets = validTriplets.at(node);
 		if (triplets.size() == 0)
 		{
 			unresolvables.insert(node);
@@ -2526,7 +3175,7 @@ ResolutionResult resolve(ResolvableUnitigGraph& resolvableGraph, const HashList&
 		{
 			if (unresolvables.count(node) == 1) continue;
 			phmap::flat_hash_map<std::pair<size_t, bool>, size_t> fakeEdgeCount;
-			auto triplets = getValidTriplets(resolvableGraph, resolvables, readPaths, node, minCoverage, unconditional, guesswork, copycountFilterHeuristic);
+			const auto& triplets = validTriplets.at(node);
 			bool unresolve = false;
 			for (auto triplet : triplets)
 			{
@@ -2585,7 +3234,7 @@ ResolutionResult resolve(ResolvableUnitigGraph& resolvableGraph, const HashList&
 	std::unordered_map<size_t, std::vector<ResolveTriplet>> tripletsPerNode;
 	for (auto node : actuallyResolvables)
 	{
-		tripletsPerNode[node] = getValidTriplets(resolvableGraph, resolvables, readPaths, node, minCoverage, unconditional, guesswork, copycountFilterHeuristic);
+		tripletsPerNode[node] = std::move(validTriplets.at(node));
 	}
 	assert(actuallyResolvables.activeSize() == resolvables.size() - unresolvables.size());
 	phmap::flat_hash_map<std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>>, size_t> newEdgeNodes;
@@ -2810,12 +3459,14 @@ ResolutionResult resolve(ResolvableUnitigGraph& resolvableGraph, const HashList&
 		resolvableGraph.unitigRemoved[node] = true;
 		std::pair<size_t, bool> fw { node, true };
 		std::pair<size_t, bool> bw { node, false };
-		for (auto edge : resolvableGraph.edges[fw])
+		std::vector<std::pair<size_t, bool>> fwEdges { resolvableGraph.edges[fw].begin(), resolvableGraph.edges[fw].end() };
+		for (auto edge : fwEdges)
 		{
 			assert(resolvableGraph.edges[reverse(edge)].count(reverse(fw)) == 1);
 			resolvableGraph.edges[reverse(edge)].erase(reverse(fw));
 		}
-		for (auto edge : resolvableGraph.edges[bw])
+		std::vector<std::pair<size_t, bool>> bwEdges { resolvableGraph.edges[bw].begin(), resolvableGraph.edges[bw].end() };
+		for (auto edge : bwEdges)
 		{
 			assert(resolvableGraph.edges[reverse(edge)].count(reverse(bw)) == 1);
 			resolvableGraph.edges[reverse(edge)].erase(reverse(bw));
@@ -2823,7 +3474,7 @@ ResolutionResult resolve(ResolvableUnitigGraph& resolvableGraph, const HashList&
 		resolvableGraph.edges[fw].clear();
 		resolvableGraph.edges[bw].clear();
 	}
-	replacePaths(resolvableGraph, readPaths, actuallyResolvables, newEdgeNodes);
+	replacePaths(resolvableGraph, readPaths, actuallyResolvables, newEdgeNodes, numThreads);
 	actuallyResolvables.clear();
 	assert(resolvables.size() > unresolvables.size());
 	result.nodesResolved = resolvables.size() - unresolvables.size();
@@ -2831,7 +3482,8 @@ ResolutionResult resolve(ResolvableUnitigGraph& resolvableGraph, const HashList&
 	return result;
 }
 
-size_t getEdgeCoverage(const ResolvableUnitigGraph& resolvableGraph, const std::vector<PathGroup>& readPaths, std::pair<size_t, bool> from, std::pair<size_t, bool> to, size_t maxCount)
+// counts the reads crossing the edge from the crossing reads, for checking edgeReadCounts
+size_t countEdgeCoverage(const ResolvableUnitigGraph& resolvableGraph, const std::vector<PathGroup>& readPaths, std::pair<size_t, bool> from, std::pair<size_t, bool> to)
 {
 	size_t result = 0;
 	if (resolvableGraph.getCrossingCount(to.first) < resolvableGraph.getCrossingCount(from.first))
@@ -2847,20 +3499,18 @@ size_t getEdgeCoverage(const ResolvableUnitigGraph& resolvableGraph, const std::
 		if (j < readPaths[i].path.size()-1 && readPaths[i].path[j] == from && readPaths[i].path[j+1] == to)
 		{
 			result += readPaths[i].reads.size();
-			if (result > maxCount) return result;
 		}
 		if (j > 0 && readPaths[i].path[j] == reverse(from) && readPaths[i].path[j-1] == reverse(to))
 		{
 			result += readPaths[i].reads.size();
-			if (result > maxCount) return result;
 		}
 	}
 	return result;
 }
 
-size_t getEdgeCoverage(const ResolvableUnitigGraph& resolvableGraph, const std::vector<PathGroup>& readPaths, std::pair<size_t, bool> from, std::pair<size_t, bool> to)
+size_t getEdgeCoverage(const ResolvableUnitigGraph& resolvableGraph, std::pair<size_t, bool> from, std::pair<size_t, bool> to)
 {
-	return getEdgeCoverage(resolvableGraph, readPaths, from, to, std::numeric_limits<size_t>::max());
+	return resolvableGraph.edgeReadCounts.get(canon(from, to));
 }
 
 void checkValidity(const ResolvableUnitigGraph& graph, const std::vector<PathGroup>& readPaths)
@@ -2871,6 +3521,9 @@ void checkValidity(const ResolvableUnitigGraph& graph, const std::vector<PathGro
 	assert(graph.unitigs.size() == graph.unitigLeftClipBp.size());
 	assert(graph.unitigs.size() == graph.unitigRemoved.size());
 	assert(graph.unitigs.size() == graph.readsCrossingNode.size());
+	assert(graph.unitigs.size() == graph.liveCrossingCount.size());
+	assert(graph.unitigs.size() == graph.deadCrossingCount.size());
+	assert(graph.unitigs.size() == graph.coveredKmers.size());
 	for (size_t i = 0; i < graph.unitigs.size(); i++)
 	{
 		if (graph.unitigRemoved[i])
@@ -2890,7 +3543,8 @@ void checkValidity(const ResolvableUnitigGraph& graph, const std::vector<PathGro
 		std::pair<size_t, bool> bw { i, false };
 		for (auto edge : graph.edges[fw])
 		{
-			assert(getEdgeCoverage(graph, readPaths, fw, edge) > 0);
+			assert(getEdgeCoverage(graph, fw, edge) > 0);
+			assert(getEdgeCoverage(graph, fw, edge) == countEdgeCoverage(graph, readPaths, fw, edge));
 			assert(!graph.unitigRemoved[edge.first]);
 			assert(graph.edges[reverse(edge)].count(reverse(fw)) == 1);
 			assert(graph.edges[fw].size() >= 2 || graph.edges[reverse(edge)].size() >= 2 || edge.first == i);
@@ -2899,7 +3553,8 @@ void checkValidity(const ResolvableUnitigGraph& graph, const std::vector<PathGro
 		}
 		for (auto edge : graph.edges[bw])
 		{
-			assertPrintReads(getEdgeCoverage(graph, readPaths, bw, edge) > 0, graph, readPaths, i);
+			assertPrintReads(getEdgeCoverage(graph, bw, edge) > 0, graph, readPaths, i);
+			assert(getEdgeCoverage(graph, bw, edge) == countEdgeCoverage(graph, readPaths, bw, edge));
 			assert(!graph.unitigRemoved[edge.first]);
 			assert(graph.edges[reverse(edge)].count(reverse(bw)) == 1);
 			assert(graph.edges[bw].size() >= 2 || graph.edges[reverse(edge)].size() >= 2 || edge.first == i);
@@ -2998,15 +3653,14 @@ void checkValidity(const ResolvableUnitigGraph& graph, const std::vector<PathGro
 	}
 	for (size_t i = 0; i < graph.unitigs.size(); i++)
 	{
-		if (i == graph.precalcedUnitigCoverages.size()) break;
 		if (graph.unitigRemoved[i]) continue;
-		if (graph.precalcedUnitigCoverages[i] == 0) continue;
-		double recalcedCoverage = graph.calculateCoverage(readPaths, i);
-		if (!(graph.precalcedUnitigCoverages[i] > recalcedCoverage - 0.01 && graph.precalcedUnitigCoverages[i] < recalcedCoverage + 0.01))
+		if (graph.coveredKmers[i] == CoveredKmersNotCounted) continue;
+		size_t recountedKmers = graph.countCoveredKmers(readPaths, i);
+		if (graph.coveredKmers[i] != recountedKmers)
 		{
-			std::cerr << graph.precalcedUnitigCoverages[i] << " " << recalcedCoverage << std::endl;
+			std::cerr << graph.coveredKmers[i] << " " << recountedKmers << std::endl;
 		}
-		assert(graph.precalcedUnitigCoverages[i] > recalcedCoverage - 0.01 && graph.precalcedUnitigCoverages[i] < recalcedCoverage + 0.01);
+		assert(graph.coveredKmers[i] == recountedKmers);
 	}
 }
 
@@ -3018,6 +3672,8 @@ void removeEdgesAndNodes(ResolvableUnitigGraph& resolvableGraph, std::vector<Pat
 		assert(edge == canon(edge.first, edge.second));
 		assert(resolvableGraph.edges[edge.first].count(edge.second) == 1);
 		assert(resolvableGraph.edges[reverse(edge.second)].count(reverse(edge.first)) == 1);
+		resolvableGraph.markChanged(edge.first.first);
+		resolvableGraph.markChanged(edge.second.first);
 		resolvableGraph.edges[edge.first].erase(edge.second);
 		if (edge.first != reverse(edge.second))
 		{
@@ -3034,14 +3690,17 @@ void removeEdgesAndNodes(ResolvableUnitigGraph& resolvableGraph, std::vector<Pat
 	for (auto node : removeNodes)
 	{
 		assert(!resolvableGraph.unitigRemoved[node]);
+		resolvableGraph.markChanged(node);
 		for (auto edge : resolvableGraph.edges[std::make_pair(node, true)])
 		{
+			resolvableGraph.markChanged(edge.first);
 			if (edge.first == node) continue;
 			assert(resolvableGraph.edges[reverse(edge)].count(std::make_pair(node, false)) == 1);
 			resolvableGraph.edges[reverse(edge)].erase(std::make_pair(node, false));
 		}
 		for (auto edge : resolvableGraph.edges[std::make_pair(node, false)])
 		{
+			resolvableGraph.markChanged(edge.first);
 			if (edge.first == node) continue;
 			assert(resolvableGraph.edges[reverse(edge)].count(std::make_pair(node, true)) == 1);
 			resolvableGraph.edges[reverse(edge)].erase(std::make_pair(node, true));
@@ -3187,6 +3846,7 @@ void removeEdgesAndNodes(ResolvableUnitigGraph& resolvableGraph, std::vector<Pat
 	for (auto node : removeNodes)
 	{
 		resolvableGraph.readsCrossingNode[node].clear();
+		resolvableGraph.liveCrossingCount[node] = 0;
 		resolvableGraph.unitigRemoved[node] = true;
 	}
 }
@@ -3211,50 +3871,73 @@ struct UntippingResult
 	phmap::flat_hash_set<size_t> maybeUnitigifiable;
 };
 
-void tryRemoveTip(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const HashList& hashlist, const double maxRemovableCoverage, const double minSafeCoverage, const size_t maxRemovableLength, const size_t i, UntippingResult& result)
+// whether tip i would be removed, only reads the graph
+// depends only on i, its neighbors and their edges, so the answer stays valid until one of them is marked changed
+bool isRemovableTip(const ResolvableUnitigGraph& resolvableGraph, const std::vector<PathGroup>& readPaths, const double maxRemovableCoverage, const double minSafeCoverage, const size_t i)
 {
 	assert(!resolvableGraph.unitigRemoved[i]);
 	bool fwHasSafeEdge = false;
 	for (auto edge : resolvableGraph.edges[std::make_pair(i, true)])
 	{
-		if (resolvableGraph.getCoverage(readPaths, edge.first) < minSafeCoverage) return;
-		if (getEdgeCoverage(resolvableGraph, readPaths, std::make_pair(i, true), edge, maxRemovableCoverage) > maxRemovableCoverage) return;
+		if (resolvableGraph.getCoverage(readPaths, edge.first) < minSafeCoverage) return false;
+		if (getEdgeCoverage(resolvableGraph, std::make_pair(i, true), edge) > maxRemovableCoverage) return false;
 		for (auto edge2 : resolvableGraph.edges[reverse(edge)])
 		{
 			if (edge2.first == i) continue;
-			if (getEdgeCoverage(resolvableGraph, readPaths, reverse(edge), edge2, minSafeCoverage) >= minSafeCoverage)
+			if (getEdgeCoverage(resolvableGraph, reverse(edge), edge2) >= minSafeCoverage)
 			{
 				fwHasSafeEdge = true;
 				break;
 			}
 		}
 	}
-	if (resolvableGraph.edges[std::make_pair(i, true)].size() > 0 && !fwHasSafeEdge) return;
+	if (resolvableGraph.edges[std::make_pair(i, true)].size() > 0 && !fwHasSafeEdge) return false;
 	bool bwHasSafeEdge = false;
 	for (auto edge : resolvableGraph.edges[std::make_pair(i, false)])
 	{
-		if (resolvableGraph.getCoverage(readPaths, edge.first) < minSafeCoverage) return;
-		if (getEdgeCoverage(resolvableGraph, readPaths, std::make_pair(i, false), edge, maxRemovableCoverage) > maxRemovableCoverage) return;
+		if (resolvableGraph.getCoverage(readPaths, edge.first) < minSafeCoverage) return false;
+		if (getEdgeCoverage(resolvableGraph, std::make_pair(i, false), edge) > maxRemovableCoverage) return false;
 		for (auto edge2 : resolvableGraph.edges[reverse(edge)])
 		{
 			if (edge2.first == i) continue;
-			if (getEdgeCoverage(resolvableGraph, readPaths, reverse(edge), edge2, minSafeCoverage) >= minSafeCoverage)
+			if (getEdgeCoverage(resolvableGraph, reverse(edge), edge2) >= minSafeCoverage)
 			{
 				bwHasSafeEdge = true;
 				break;
 			}
 		}
 	}
-	if (resolvableGraph.edges[std::make_pair(i, false)].size() > 0 && !bwHasSafeEdge) return;
+	if (resolvableGraph.edges[std::make_pair(i, false)].size() > 0 && !bwHasSafeEdge) return false;
+	return true;
+}
+
+// whether node i or one of its neighbors changed since the last clearChangedNodes
+bool neighborhoodChanged(const ResolvableUnitigGraph& resolvableGraph, const size_t i)
+{
+	if (resolvableGraph.nodeChanged[i]) return true;
+	for (auto edge : resolvableGraph.edges[std::make_pair(i, true)])
+	{
+		if (resolvableGraph.nodeChanged[edge.first]) return true;
+	}
+	for (auto edge : resolvableGraph.edges[std::make_pair(i, false)])
+	{
+		if (resolvableGraph.nodeChanged[edge.first]) return true;
+	}
+	return false;
+}
+
+void removeTip(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const size_t i, UntippingResult& result)
+{
 	for (auto edge : resolvableGraph.edges[std::make_pair(i, true)]) result.maybeUnitigifiable.insert(edge.first);
 	for (auto edge : resolvableGraph.edges[std::make_pair(i, false)]) result.maybeUnitigifiable.insert(edge.first);
 	removeNode(resolvableGraph, readPaths, i);
 	result.nodesRemoved += 1;
 }
 
-UntippingResult tryRemoveCrosslinks(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const double maxRemovableCoverage, const double minSafeCoverage, const std::pair<size_t, bool> start)
+// the crosslinks of start which would be removed, only reads the graph
+std::vector<std::pair<size_t, bool>> getRemovableCrosslinks(const ResolvableUnitigGraph& resolvableGraph, const double maxRemovableCoverage, const double minSafeCoverage, const std::pair<size_t, bool> start)
 {
-	UntippingResult result;
+	std::vector<std::pair<size_t, bool>> removeThese;
 	assert(resolvableGraph.edges[start].size() >= 2);
 	bool possibleToRemove = false;
 	for (auto edge : resolvableGraph.edges[start])
@@ -3264,12 +3947,12 @@ UntippingResult tryRemoveCrosslinks(ResolvableUnitigGraph& resolvableGraph, std:
 			possibleToRemove = true;
 		}
 	}
-	if (!possibleToRemove) return result;
+	if (!possibleToRemove) return removeThese;
 	bool hasSafe = false;
 	std::vector<std::pair<size_t, bool>> checkThese;
 	for (auto edge : resolvableGraph.edges[start])
 	{
-		size_t coverage = getEdgeCoverage(resolvableGraph, readPaths, start, edge);
+		size_t coverage = getEdgeCoverage(resolvableGraph, start, edge);
 		if (coverage >= minSafeCoverage)
 		{
 			hasSafe = true;
@@ -3279,8 +3962,7 @@ UntippingResult tryRemoveCrosslinks(ResolvableUnitigGraph& resolvableGraph, std:
 			checkThese.push_back(edge);
 		}
 	}
-	if (!hasSafe) return result;
-	std::vector<std::pair<size_t, bool>> removeThese;
+	if (!hasSafe) return removeThese;
 	for (auto edge : checkThese)
 	{
 		bool otherHasSafe = false;
@@ -3288,14 +3970,19 @@ UntippingResult tryRemoveCrosslinks(ResolvableUnitigGraph& resolvableGraph, std:
 		for (auto edge2 : resolvableGraph.edges[reverse(edge)])
 		{
 			if (edge2 == reverse(start)) continue;
-			if (getEdgeCoverage(resolvableGraph, readPaths, reverse(edge), edge2) >= minSafeCoverage)
+			if (getEdgeCoverage(resolvableGraph, reverse(edge), edge2) >= minSafeCoverage)
 			{
 				otherHasSafe = true;
 			}
 		}
 		if (otherHasSafe) removeThese.push_back(edge);
 	}
-	if (removeThese.size() == 0) return result;
+	return removeThese;
+}
+
+void removeCrosslinks(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const std::pair<size_t, bool> start, const std::vector<std::pair<size_t, bool>>& removeThese, UntippingResult& result)
+{
+	if (removeThese.size() == 0) return;
 	std::unordered_set<size_t> removedNodes;
 	std::unordered_set<std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>>> removedEdges;
 	for (auto edge : removeThese)
@@ -3304,36 +3991,58 @@ UntippingResult tryRemoveCrosslinks(ResolvableUnitigGraph& resolvableGraph, std:
 		result.maybeUnitigifiable.insert(edge.first);
 	}
 	result.maybeUnitigifiable.insert(start.first);
-	result.edgesRemoved = removeThese.size();
+	result.edgesRemoved += removeThese.size();
 	removeEdgesAndNodes(resolvableGraph, readPaths, removedNodes, removedEdges);
-	return result;
 }
 
-UntippingResult removeLowCoverageCrosslinks(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const double maxRemovableCoverage, const double minSafeCoverage)
+// candidates are evaluated in parallel against the graph as it is before any removal, then applied in the sequential order
+// a candidate whose neighborhood was changed by an earlier removal is evaluated again, so the result is the same as evaluating one by one
+UntippingResult removeLowCoverageCrosslinks(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const double maxRemovableCoverage, const double minSafeCoverage, const size_t numThreads)
 {
 	UntippingResult result;
+	std::vector<std::pair<size_t, bool>> candidates;
 	for (size_t i = 0; i < resolvableGraph.unitigs.size(); i++)
 	{
 		if (resolvableGraph.unitigRemoved[i]) continue;
-		if (resolvableGraph.edges[std::make_pair(i, true)].size() >= 2)
+		if (resolvableGraph.edges[std::make_pair(i, true)].size() >= 2) candidates.emplace_back(i, true);
+		if (resolvableGraph.edges[std::make_pair(i, false)].size() >= 2) candidates.emplace_back(i, false);
+	}
+	std::vector<std::vector<std::pair<size_t, bool>>> decisions;
+	decisions.resize(candidates.size());
+	iterateChunksMultithreaded(candidates.size(), numThreads, 256, [&resolvableGraph, &candidates, &decisions, maxRemovableCoverage, minSafeCoverage](size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
 		{
-			auto partResult = tryRemoveCrosslinks(resolvableGraph, readPaths, maxRemovableCoverage, minSafeCoverage, std::make_pair(i, true));
-			result.nodesRemoved += partResult.nodesRemoved;
-			result.edgesRemoved += partResult.edgesRemoved;
-			result.maybeUnitigifiable.insert(partResult.maybeUnitigifiable.begin(), partResult.maybeUnitigifiable.end());
+			decisions[i] = getRemovableCrosslinks(resolvableGraph, maxRemovableCoverage, minSafeCoverage, candidates[i]);
 		}
-		if (resolvableGraph.edges[std::make_pair(i, false)].size() >= 2)
+	});
+	resolvableGraph.clearChangedNodes();
+	size_t candidateIndex = 0;
+	for (size_t i = 0; i < resolvableGraph.unitigs.size(); i++)
+	{
+		for (bool fw : { true, false })
 		{
-			auto partResult = tryRemoveCrosslinks(resolvableGraph, readPaths, maxRemovableCoverage, minSafeCoverage, std::make_pair(i, false));
-			result.nodesRemoved += partResult.nodesRemoved;
-			result.edgesRemoved += partResult.edgesRemoved;
-			result.maybeUnitigifiable.insert(partResult.maybeUnitigifiable.begin(), partResult.maybeUnitigifiable.end());
+			std::pair<size_t, bool> start { i, fw };
+			bool wasCandidate = candidateIndex < candidates.size() && candidates[candidateIndex] == start;
+			if (wasCandidate) candidateIndex += 1;
+			if (resolvableGraph.unitigRemoved[i]) continue;
+			if (resolvableGraph.edges[start].size() < 2) continue;
+			if (wasCandidate && !neighborhoodChanged(resolvableGraph, i))
+			{
+				removeCrosslinks(resolvableGraph, readPaths, start, decisions[candidateIndex-1], result);
+			}
+			else
+			{
+				removeCrosslinks(resolvableGraph, readPaths, start, getRemovableCrosslinks(resolvableGraph, maxRemovableCoverage, minSafeCoverage, start), result);
+			}
 		}
 	}
+	assert(candidateIndex == candidates.size());
 	return result;
 }
 
-UntippingResult removeLowCoverageTips(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const HashList& hashlist, const double maxRemovableCoverage, const double minSafeCoverage, const size_t maxRemovableLength, const phmap::flat_hash_set<size_t>& maybeUntippable)
+// tips are evaluated in parallel and applied in the sequential order like in removeLowCoverageCrosslinks
+UntippingResult removeLowCoverageTips(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const HashList& hashlist, const double maxRemovableCoverage, const double minSafeCoverage, const size_t maxRemovableLength, const phmap::flat_hash_set<size_t>& maybeUntippable, const size_t numThreads)
 {
 	UntippingResult result;
 	for (size_t i = resolvableGraph.lastTippableChecked; i < resolvableGraph.unitigs.size(); i++)
@@ -3362,6 +4071,26 @@ UntippingResult removeLowCoverageTips(ResolvableUnitigGraph& resolvableGraph, st
 		resolvableGraph.everTippable.push_back(i);
 	}
 	resolvableGraph.lastTippableChecked = resolvableGraph.unitigs.size();
+	// isRemovableTip reads neighbor coverages, count them here so the threads only read the graph
+	for (const size_t i : resolvableGraph.everTippable)
+	{
+		if (resolvableGraph.unitigRemoved[i]) continue;
+		for (auto edge : resolvableGraph.edges[std::make_pair(i, true)]) resolvableGraph.getCoverage(readPaths, edge.first);
+		for (auto edge : resolvableGraph.edges[std::make_pair(i, false)]) resolvableGraph.getCoverage(readPaths, edge.first);
+	}
+	std::vector<uint8_t> removable;
+	removable.resize(resolvableGraph.everTippable.size(), 0);
+	iterateChunksMultithreaded(resolvableGraph.everTippable.size(), numThreads, 256, [&resolvableGraph, &readPaths, &removable, maxRemovableCoverage, minSafeCoverage](size_t start, size_t end)
+	{
+		for (size_t index = start; index < end; index++)
+		{
+			size_t i = resolvableGraph.everTippable[index];
+			if (resolvableGraph.unitigRemoved[i]) continue;
+			removable[index] = isRemovableTip(resolvableGraph, readPaths, maxRemovableCoverage, minSafeCoverage, i) ? 1 : 0;
+		}
+	});
+	resolvableGraph.clearChangedNodes();
+	// entries are only swapped with entries after index, so everTippable[index] is still the node evaluated at index
 	for (size_t index = resolvableGraph.everTippable.size()-1; index < resolvableGraph.everTippable.size(); index--)
 	{
 		size_t i = resolvableGraph.everTippable[index];
@@ -3371,7 +4100,9 @@ UntippingResult removeLowCoverageTips(ResolvableUnitigGraph& resolvableGraph, st
 			resolvableGraph.everTippable.pop_back();
 			continue;
 		}
-		tryRemoveTip(resolvableGraph, readPaths, hashlist, maxRemovableCoverage, minSafeCoverage, maxRemovableLength, i, result);
+		bool removeThis = removable[index] == 1;
+		if (neighborhoodChanged(resolvableGraph, i)) removeThis = isRemovableTip(resolvableGraph, readPaths, maxRemovableCoverage, minSafeCoverage, i);
+		if (removeThis) removeTip(resolvableGraph, readPaths, i, result);
 	}
 	return result;
 }
@@ -3390,9 +4121,25 @@ struct CleaningResult
 	phmap::flat_hash_set<std::pair<size_t, bool>> checked;
 };
 
-CleaningResult cleanComponent(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const size_t minLongLength, const size_t minUnresolvableLength, const size_t maxUnresolvableLength, std::pair<size_t, bool> start)
+struct ComponentCleaning
 {
-	CleaningResult result;
+	ComponentCleaning() :
+		checked(),
+		valid(false),
+		removedEdges(),
+		removedNodes()
+	{}
+	phmap::flat_hash_set<std::pair<size_t, bool>> checked;
+	bool valid;
+	std::unordered_set<std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>>> removedEdges;
+	std::unordered_set<size_t> removedNodes;
+};
+
+// the edges and nodes which cleaning the component of start would remove, only reads the graph
+// lengths and coverages of the component must already be counted if called from multiple threads
+ComponentCleaning getComponentCleaning(const ResolvableUnitigGraph& resolvableGraph, const std::vector<PathGroup>& readPaths, const size_t minLongLength, const size_t minUnresolvableLength, const size_t maxUnresolvableLength, std::pair<size_t, bool> start)
+{
+	ComponentCleaning result;
 	std::vector<std::pair<size_t, bool>> stack;
 	stack.push_back(start);
 	std::vector<std::pair<size_t, bool>> componentNodeSides;
@@ -3429,7 +4176,7 @@ CleaningResult cleanComponent(ResolvableUnitigGraph& resolvableGraph, std::vecto
 		size_t edgeCopyCountSum = 0;
 		for (auto edge : resolvableGraph.edges[pair])
 		{
-			int coverage = getEdgeCoverage(resolvableGraph, readPaths, pair, edge);
+			int coverage = getEdgeCoverage(resolvableGraph, pair, edge);
 			size_t edgeCopyCount = (coverage + resolvableGraph.averageCoverage / 2) / resolvableGraph.averageCoverage;
 			if (estimatedCopyCount <= 1 && coverage < resolvableGraph.averageCoverage * ((double)edgeCopyCount - 0.4))
 			{
@@ -3454,139 +4201,172 @@ CleaningResult cleanComponent(ResolvableUnitigGraph& resolvableGraph, std::vecto
 	{
 		return result;
 	}
-	std::unordered_set<std::pair<std::pair<size_t, bool>, std::pair<size_t, bool>>> removedEdges;
-	std::unordered_set<size_t> removedNodes;
+	result.valid = true;
 	for (auto pair : componentNodeSides)
 	{
 		for (auto edge : resolvableGraph.edges[pair])
 		{
-			int coverage = getEdgeCoverage(resolvableGraph, readPaths, pair, edge);
+			int coverage = getEdgeCoverage(resolvableGraph, pair, edge);
 			size_t edgeCopyCount = (coverage + resolvableGraph.averageCoverage / 2) / resolvableGraph.averageCoverage;
-			if (edgeCopyCount == 0) removedEdges.insert(canon(pair, edge));
+			if (edgeCopyCount == 0) result.removedEdges.insert(canon(pair, edge));
 		}
 		double coverage = resolvableGraph.getCoverage(readPaths, pair.first);
 		size_t estimatedCopyCount = (coverage + resolvableGraph.averageCoverage / 2) / resolvableGraph.averageCoverage;
-		if (estimatedCopyCount == 0) removedNodes.insert(pair.first);
+		if (estimatedCopyCount == 0) result.removedNodes.insert(pair.first);
 	}
-	for (auto edge : removedEdges)
+	return result;
+}
+
+CleaningResult cleanComponent(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, ComponentCleaning& cleaning)
+{
+	CleaningResult result;
+	std::swap(result.checked, cleaning.checked);
+	if (!cleaning.valid) return result;
+	for (auto edge : cleaning.removedEdges)
 	{
-		if (removedNodes.count(edge.first.first) == 0) result.maybeUnitigifiable.insert(edge.first.first);
-		if (removedNodes.count(edge.second.first) == 0) result.maybeUnitigifiable.insert(edge.second.first);
+		if (cleaning.removedNodes.count(edge.first.first) == 0) result.maybeUnitigifiable.insert(edge.first.first);
+		if (cleaning.removedNodes.count(edge.second.first) == 0) result.maybeUnitigifiable.insert(edge.second.first);
 	}
-	result.nodesRemoved = removedNodes.size();
-	result.edgesRemoved = removedEdges.size();
-	removeEdgesAndNodes(resolvableGraph, readPaths, removedNodes, removedEdges);
+	result.nodesRemoved = cleaning.removedNodes.size();
+	result.edgesRemoved = cleaning.removedEdges.size();
+	removeEdgesAndNodes(resolvableGraph, readPaths, cleaning.removedNodes, cleaning.removedEdges);
 	return result;
 }
 
-CleaningResult cleanComponentsByCopynumber(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const size_t minLongLength, const size_t minUnresolvableLength, const size_t maxUnresolvableLength, const phmap::flat_hash_set<size_t>& checkThese, const size_t minNew)
+size_t sideIndex(const std::pair<size_t, bool> side)
 {
-	CleaningResult result;
-	std::unordered_set<std::pair<size_t, bool>> checked;
-	std::vector<size_t> checkTheseDeterministic { checkThese.begin(), checkThese.end() };
-	std::sort(checkTheseDeterministic.begin(), checkTheseDeterministic.end());
-	for (auto i : checkTheseDeterministic)
+	return side.first * 2 + (side.second ? 1 : 0);
+}
+
+bool sideChecked(const std::vector<bool>& checked, const std::pair<size_t, bool> side)
+{
+	return checked[sideIndex(side)];
+}
+
+bool sideChecked(const phmap::flat_hash_set<std::pair<size_t, bool>>& checked, const std::pair<size_t, bool> side)
+{
+	return checked.count(side) == 1;
+}
+
+void setSideChecked(std::vector<bool>& checked, const std::pair<size_t, bool> side)
+{
+	checked[sideIndex(side)] = true;
+}
+
+void setSideChecked(phmap::flat_hash_set<std::pair<size_t, bool>>& checked, const std::pair<size_t, bool> side)
+{
+	checked.insert(side);
+}
+
+// first side of each component in the order of the sides of startNodes, for cleaning the whole graph
+// components are found with a parallel union-find over all node sides, which also counts the length and coverage of every node
+std::vector<std::pair<size_t, bool>> getComponentStartsOfGraph(ResolvableUnitigGraph& resolvableGraph, const std::vector<PathGroup>& readPaths, const size_t minLongLength, const std::vector<size_t>& startNodes, const size_t numThreads)
+{
+	const size_t numNodes = resolvableGraph.unitigs.size();
+	if (resolvableGraph.precalcedUnitigLengths.size() < numNodes) resolvableGraph.precalcedUnitigLengths.resize(numNodes, 0);
+	ConcurrentUnionFind components { numNodes * 2 };
+	iterateChunksMultithreaded(numNodes, numThreads, 1024, [&resolvableGraph, &readPaths, &components, minLongLength](size_t start, size_t end)
 	{
-		if (resolvableGraph.unitigRemoved[i]) continue;
-		if (checked.count(std::make_pair(i, true)) == 0)
+		for (size_t i = start; i < end; i++)
 		{
-			auto part = cleanComponent(resolvableGraph, readPaths, minLongLength, minUnresolvableLength, maxUnresolvableLength, std::make_pair(i, true));
-			for (auto node : part.checked)
-			{
-				if (checkThese.count(node.first) == 1 || node.first >= minNew) checked.insert(node);
-			}
-			for (auto node : part.maybeUnitigifiable)
+			if (resolvableGraph.unitigRemoved[i]) continue;
+			// counts the length and coverage of every node here so evaluating the components only reads them
+			double coverage = resolvableGraph.getCoverage(readPaths, i);
+			size_t estimatedCopyCount = (coverage + resolvableGraph.averageCoverage / 2) / resolvableGraph.averageCoverage;
+			if (resolvableGraph.unitigLength(i) < minLongLength || estimatedCopyCount == 0) components.merge(sideIndex(std::make_pair(i, true)), sideIndex(std::make_pair(i, false)));
+			for (bool fw : { true, false })
 			{
-				result.maybeUnitigifiable.insert(node);
+				for (auto edge : resolvableGraph.edges[std::make_pair(i, fw)]) components.merge(sideIndex(std::make_pair(i, fw)), sideIndex(reverse(edge)));
 			}
-			result.nodesRemoved += part.nodesRemoved;
-			result.edgesRemoved += part.edgesRemoved;
 		}
-		if (checked.count(std::make_pair(i, false)) == 0)
+	});
+	std::vector<bool> componentHasStart;
+	componentHasStart.resize(numNodes * 2, false);
+	std::vector<std::pair<size_t, bool>> componentStarts;
+	for (const size_t i : startNodes)
+	{
+		if (resolvableGraph.unitigRemoved[i]) continue;
+		for (bool fw : { true, false })
 		{
-			assert(!resolvableGraph.unitigRemoved[i]);
-			auto part = cleanComponent(resolvableGraph, readPaths, minLongLength, minUnresolvableLength, maxUnresolvableLength, std::make_pair(i, false));
-			for (auto node : part.checked)
-			{
-				if (checkThese.count(node.first) == 1 || node.first >= minNew) checked.insert(node);
-			}
-			for (auto node : part.maybeUnitigifiable)
-			{
-				result.maybeUnitigifiable.insert(node);
-			}
-			result.nodesRemoved += part.nodesRemoved;
-			result.edgesRemoved += part.edgesRemoved;
+			size_t component = components.find(sideIndex(std::make_pair(i, fw)));
+			if (componentHasStart[component]) continue;
+			componentHasStart[component] = true;
+			componentStarts.emplace_back(i, fw);
 		}
 	}
-	for (size_t i = minNew; i < resolvableGraph.unitigs.size(); i++)
+	return componentStarts;
+}
+
+// first side of each component in the order of the sides of startNodes, for cleaning the components touched by a resolve step
+// components are found by traversing from startNodes with the same joins as getComponentCleaning, which also counts the lengths and coverages in them
+std::vector<std::pair<size_t, bool>> getComponentStartsFrom(ResolvableUnitigGraph& resolvableGraph, const std::vector<PathGroup>& readPaths, const size_t minLongLength, const std::vector<size_t>& startNodes)
+{
+	std::vector<std::pair<size_t, bool>> componentStarts;
+	phmap::flat_hash_set<std::pair<size_t, bool>> visited;
+	std::vector<std::pair<size_t, bool>> stack;
+	for (const size_t i : startNodes)
 	{
 		if (resolvableGraph.unitigRemoved[i]) continue;
-		if (checked.count(std::make_pair(i, true)) == 0)
-		{
-			auto part = cleanComponent(resolvableGraph, readPaths, minLongLength, minUnresolvableLength, maxUnresolvableLength, std::make_pair(i, true));
-			for (auto node : part.checked)
-			{
-				if (checkThese.count(node.first) == 1 || node.first >= minNew) checked.insert(node);
-			}
-			for (auto node : part.maybeUnitigifiable)
-			{
-				result.maybeUnitigifiable.insert(node);
-			}
-			result.nodesRemoved += part.nodesRemoved;
-			result.edgesRemoved += part.edgesRemoved;
-		}
-		if (checked.count(std::make_pair(i, false)) == 0)
+		for (bool fw : { true, false })
 		{
-			assert(!resolvableGraph.unitigRemoved[i]);
-			auto part = cleanComponent(resolvableGraph, readPaths, minLongLength, minUnresolvableLength, maxUnresolvableLength, std::make_pair(i, false));
-			for (auto node : part.checked)
-			{
-				if (checkThese.count(node.first) == 1 || node.first >= minNew) checked.insert(node);
-			}
-			for (auto node : part.maybeUnitigifiable)
+			if (visited.count(std::make_pair(i, fw)) == 1) continue;
+			componentStarts.emplace_back(i, fw);
+			stack.emplace_back(i, fw);
+			while (stack.size() > 0)
 			{
-				result.maybeUnitigifiable.insert(node);
+				auto top = stack.back();
+				stack.pop_back();
+				if (visited.count(top) == 1) continue;
+				visited.insert(top);
+				double coverage = resolvableGraph.getCoverage(readPaths, top.first);
+				size_t estimatedCopyCount = (coverage + resolvableGraph.averageCoverage / 2) / resolvableGraph.averageCoverage;
+				if (resolvableGraph.unitigLength(top.first) < minLongLength || estimatedCopyCount == 0) stack.push_back(reverse(top));
+				for (auto edge : resolvableGraph.edges[top]) stack.push_back(reverse(edge));
 			}
-			result.nodesRemoved += part.nodesRemoved;
-			result.edgesRemoved += part.edgesRemoved;
 		}
 	}
-	return result;
+	return componentStarts;
 }
 
-CleaningResult cleanComponentsByCopynumber(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const size_t minLongLength, const size_t minUnresolvableLength, const size_t maxUnresolvableLength)
+// cleans the components of both sides of startNodes in order, marking the sides of a cleaned component checked if isTracked(node)
+// the first start of each component is evaluated in parallel, lengths and coverages of the components must already be counted
+// the evaluations are applied in the same order as cleaning one component at a time, re-evaluating if an earlier removal changed the component
+template <typename F, typename CheckedSides>
+CleaningResult cleanComponentsInOrder(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const size_t minLongLength, const size_t minUnresolvableLength, const size_t maxUnresolvableLength, const std::vector<size_t>& startNodes, const std::vector<std::pair<size_t, bool>>& componentStarts, F isTracked, CheckedSides& checked, const size_t numThreads)
 {
 	CleaningResult result;
-	std::vector<bool> fwChecked;
-	std::vector<bool> bwChecked;
-	fwChecked.resize(resolvableGraph.unitigs.size(), false);
-	bwChecked.resize(resolvableGraph.unitigs.size(), false);
-	for (size_t i = 0; i < resolvableGraph.unitigs.size(); i++)
+	std::vector<ComponentCleaning> cleanings;
+	cleanings.resize(componentStarts.size());
+	iterateChunksMultithreaded(componentStarts.size(), numThreads, 16, [&resolvableGraph, &readPaths, &componentStarts, &cleanings, minLongLength, minUnresolvableLength, maxUnresolvableLength](size_t start, size_t end)
 	{
-		if (resolvableGraph.unitigRemoved[i]) continue;
-		if (!fwChecked[i])
+		for (size_t i = start; i < end; i++)
 		{
-			auto part = cleanComponent(resolvableGraph, readPaths, minLongLength, minUnresolvableLength, maxUnresolvableLength, std::make_pair(i, true));
-			for (auto node : part.checked)
-			{
-				if (node.second) fwChecked[node.first] = true;
-				if (!node.second) bwChecked[node.first] = true;
-			}
-			for (auto node : part.maybeUnitigifiable)
-			{
-				result.maybeUnitigifiable.insert(node);
-			}
-			result.nodesRemoved += part.nodesRemoved;
-			result.edgesRemoved += part.edgesRemoved;
+			cleanings[i] = getComponentCleaning(resolvableGraph, readPaths, minLongLength, minUnresolvableLength, maxUnresolvableLength, componentStarts[i]);
 		}
-		if (!bwChecked[i])
+	});
+	resolvableGraph.clearChangedNodes();
+	size_t componentIndex = 0;
+	for (const size_t i : startNodes)
+	{
+		for (bool fw : { true, false })
 		{
-			assert(!resolvableGraph.unitigRemoved[i]);
-			auto part = cleanComponent(resolvableGraph, readPaths, minLongLength, minUnresolvableLength, maxUnresolvableLength, std::make_pair(i, false));
+			std::pair<size_t, bool> start { i, fw };
+			bool isComponentStart = componentIndex < componentStarts.size() && componentStarts[componentIndex] == start;
+			if (isComponentStart) componentIndex += 1;
+			if (resolvableGraph.unitigRemoved[i]) continue;
+			if (sideChecked(checked, start)) continue;
+			ComponentCleaning cleaning;
+			if (isComponentStart) std::swap(cleaning, cleanings[componentIndex-1]);
+			bool changed = !isComponentStart;
+			for (auto node : cleaning.checked)
+			{
+				if (resolvableGraph.nodeChanged[node.first]) changed = true;
+			}
+			if (changed) cleaning = getComponentCleaning(resolvableGraph, readPaths, minLongLength, minUnresolvableLength, maxUnresolvableLength, start);
+			auto part = cleanComponent(resolvableGraph, readPaths, cleaning);
 			for (auto node : part.checked)
 			{
-				if (node.second) fwChecked[node.first] = true;
-				if (!node.second) bwChecked[node.first] = true;
+				if (isTracked(node.first)) setSideChecked(checked, node);
 			}
 			for (auto node : part.maybeUnitigifiable)
 			{
@@ -3596,9 +4376,37 @@ CleaningResult cleanComponentsByCopynumber(ResolvableUnitigGraph& resolvableGrap
 			result.edgesRemoved += part.edgesRemoved;
 		}
 	}
+	assert(componentIndex == componentStarts.size());
 	return result;
 }
 
+CleaningResult cleanComponentsByCopynumber(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const size_t minLongLength, const size_t minUnresolvableLength, const size_t maxUnresolvableLength, const phmap::flat_hash_set<size_t>& checkThese, const size_t minNew, const size_t numThreads)
+{
+	std::vector<size_t> startNodes { checkThese.begin(), checkThese.end() };
+	std::sort(startNodes.begin(), startNodes.end());
+	for (size_t i = minNew; i < resolvableGraph.unitigs.size(); i++)
+	{
+		startNodes.push_back(i);
+	}
+	std::vector<std::pair<size_t, bool>> componentStarts = getComponentStartsFrom(resolvableGraph, readPaths, minLongLength, startNodes);
+	phmap::flat_hash_set<std::pair<size_t, bool>> checked;
+	return cleanComponentsInOrder(resolvableGraph, readPaths, minLongLength, minUnresolvableLength, maxUnresolvableLength, startNodes, componentStarts, [&checkThese, minNew](size_t node) { return checkThese.count(node) == 1 || node >= minNew; }, checked, numThreads);
+}
+
+CleaningResult cleanComponentsByCopynumber(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const size_t minLongLength, const size_t minUnresolvableLength, const size_t maxUnresolvableLength, const size_t numThreads)
+{
+	std::vector<size_t> startNodes;
+	startNodes.reserve(resolvableGraph.unitigs.size());
+	for (size_t i = 0; i < resolvableGraph.unitigs.size(); i++)
+	{
+		startNodes.push_back(i);
+	}
+	std::vector<std::pair<size_t, bool>> componentStarts = getComponentStartsOfGraph(resolvableGraph, readPaths, minLongLength, startNodes, numThreads);
+	std::vector<bool> checked;
+	checked.resize(resolvableGraph.unitigs.size() * 2, false);
+	return cleanComponentsInOrder(resolvableGraph, readPaths, minLongLength, minUnresolvableLength, maxUnresolvableLength, startNodes, componentStarts, [](size_t node) { return true; }, checked, numThreads);
+}
+
 bool canTrimRecursive(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const std::pair<size_t, bool> pos, const size_t trimAmount)
 {
 	assert(trimAmount > 0);
@@ -3631,14 +4439,14 @@ bool canTrimRecursive(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGr
 		{
 			for (size_t k = 0; k < readPaths[i].reads.size(); k++)
 			{
-				maxReadTrim = std::min(maxReadTrim, readPaths[i].reads[k].leftClip);
+				maxReadTrim = std::min(maxReadTrim, (size_t)readPaths[i].reads[k].leftClip);
 			}
 		}
 		else if (j == readPaths[i].path.size()-1 && readPaths[i].path[j] == pos)
 		{
 			for (size_t k = 0; k < readPaths[i].reads.size(); k++)
 			{
-				maxReadTrim = std::min(maxReadTrim, readPaths[i].reads[k].rightClip);
+				maxReadTrim = std::min(maxReadTrim, (size_t)readPaths[i].reads[k].rightClip);
 			}
 		}
 		else
@@ -3656,7 +4464,7 @@ void trimEndRecursive(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGr
 	if (resolvableGraph.precalcedUnitigLengths.size() > pos.first) resolvableGraph.precalcedUnitigLengths[pos.first] = 0;
 	assert(trimAmount > 0);
 	assert(resolvableGraph.unitigs[pos.first].size() > trimAmount);
-	if (resolvableGraph.precalcedUnitigCoverages.size() > pos.first) resolvableGraph.precalcedUnitigCoverages[pos.first] = 0;
+	resolvableGraph.invalidateCoverage(pos.first);
 	for (auto edge : resolvableGraph.edges[pos])
 	{
 		assert(resolvableGraph.overlaps.at(canon(pos, edge)) >= trimAmount);
@@ -3731,14 +4539,14 @@ void maybeTrim(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& r
 		{
 			for (size_t k = 0; k < readPaths[i].reads.size(); k++)
 			{
-				maxReadTrim = std::min(maxReadTrim, readPaths[i].reads[k].leftClip);
+				maxReadTrim = std::min(maxReadTrim, (size_t)readPaths[i].reads[k].leftClip);
 			}
 		}
 		else if (j == readPaths[i].path.size()-1 && readPaths[i].path[j] == pos)
 		{
 			for (size_t k = 0; k < readPaths[i].reads.size(); k++)
 			{
-				maxReadTrim = std::min(maxReadTrim, readPaths[i].reads[k].rightClip);
+				maxReadTrim = std::min(maxReadTrim, (size_t)readPaths[i].reads[k].rightClip);
 			}
 		}
 		else
@@ -3893,49 +4701,368 @@ phmap::flat_hash_set<size_t> filterToOnlyLocallyRepetitives(const ResolvableUnit
 	return result;
 }
 
-void resolveRound(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const HashList& hashlist, const size_t minCoverage, const size_t maxResolveLength, const size_t maxUnconditionalResolveLength, const bool guesswork, const bool copycountFilterHeuristic, const bool onlyLocalResolve, const bool doCleaning, std::ostream& log)
+// progress of resolveUnitigs at a resolveRound boundary
+struct ResolutionProgress
 {
-	checkValidity(resolvableGraph, readPaths);
-	std::priority_queue<size_t, std::vector<size_t>, UnitigLengthComparer> queue { UnitigLengthComparer { resolvableGraph } };
-	for (size_t i = 0; i < resolvableGraph.unitigs.size(); i++)
+	// which resolveRound call of resolveUnitigs, 2 when both are done
+	size_t roundIndex;
+	size_t lastTopSize;
+	size_t nodesRemoved;
+	std::vector<size_t> queueNodes;
+};
+
+// where resolveRound saves its progress, no checkpoints if fileName is empty
+// the raw read paths are saved too since path group reads refer to them by index, and their order depends on thread timing
+// numInitialUnitigs and parameters are stored to catch resuming with a checkpoint from different input or parameters
+struct ResolutionCheckpointer
+{
+	std::string fileName;
+	size_t numRawReadPaths;
+	// raw paths are in exactly one of these
+	const ReadPathStore* rawReadPaths;
+	const SpilledReadPaths* spilledRawReadPaths;
+	size_t numInitialUnitigs;
+	std::vector<size_t> parameters;
+	size_t intervalSeconds;
+	std::chrono::steady_clock::time_point lastWrite;
+};
+
+const std::string ResolutionCheckpointMagic = "MBG resolution checkpoint v6";
+
+// pairs have padding bytes, so they are written as separate fields to keep uninitialized memory out of the checkpoint
+void writeNodeSides(std::ostream& file, const std::vector<std::pair<size_t, bool>>& sides)
+{
+	std::vector<size_t> packed;
+	packed.reserve(sides.size());
+	for (auto side : sides)
 	{
-		if (resolvableGraph.unitigRemoved[i]) continue;
-		queue.emplace(i);
+		packed.push_back(side.first * 2 + (side.second ? 1 : 0));
+	}
+	Serializer::write(file, packed);
+}
+
+void readNodeSides(std::istream& file, std::vector<std::pair<size_t, bool>>& sides)
+{
+	std::vector<size_t> packed;
+	Serializer::read(file, packed);
+	sides.clear();
+	sides.reserve(packed.size());
+	for (const size_t side : packed)
+	{
+		sides.emplace_back(side / 2, (side & 1) == 1);
+	}
+}
+
+// written to a temporary file which replaces the old checkpoint once complete, so a crash while writing keeps the previous one
+void writeResolutionCheckpoint(ResolutionCheckpointer& checkpointer, const ResolvableUnitigGraph& resolvableGraph, const std::vector<PathGroup>& readPaths, const ResolutionProgress& progress)
+{
+	std::string tmpFileName = checkpointer.fileName + ".tmp";
+	{
+		std::ofstream file { tmpFileName, std::ios::binary };
+		Serializer::write(file, ResolutionCheckpointMagic);
+		Serializer::write(file, checkpointer.numRawReadPaths);
+		Serializer::write(file, checkpointer.numInitialUnitigs);
+		Serializer::write(file, resolvableGraph.kmerSize);
+		Serializer::write(file, checkpointer.parameters);
+		Serializer::write(file, progress.roundIndex);
+		Serializer::write(file, progress.lastTopSize);
+		Serializer::write(file, progress.nodesRemoved);
+		Serializer::write(file, progress.queueNodes);
+		Serializer::write(file, resolvableGraph.unitigs.size());
+		for (size_t i = 0; i < resolvableGraph.unitigs.size(); i++)
+		{
+			writeNodeSides(file, resolvableGraph.unitigs[i]);
+			Serializer::write(file, resolvableGraph.readsCrossingNode[i]);
+			for (bool fw : { true, false })
+			{
+				std::vector<std::pair<size_t, bool>> edges { resolvableGraph.edges[std::make_pair(i, fw)].begin(), resolvableGraph.edges[std::make_pair(i, fw)].end() };
+				writeNodeSides(file, edges);
+			}
+		}
+		Serializer::write(file, resolvableGraph.unitigLeftClipBp);
+		Serializer::write(file, resolvableGraph.unitigRightClipBp);
+		std::vector<uint8_t> removed { resolvableGraph.unitigRemoved.begin(), resolvableGraph.unitigRemoved.end() };
+		Serializer::write(file, removed);
+		std::vector<std::pair<size_t, bool>> overlapFroms;
+		std::vector<std::pair<size_t, bool>> overlapTos;
+		std::vector<size_t> overlapValues;
+		overlapFroms.reserve(resolvableGraph.overlaps.size());
+		overlapTos.reserve(resolvableGraph.overlaps.size());
+		overlapValues.reserve(resolvableGraph.overlaps.size());
+		for (size_t i = 0; i < resolvableGraph.overlaps.numNodes(); i++)
+		{
+			for (bool fw : { true, false })
+			{
+				for (auto pair : resolvableGraph.overlaps.getValuesFrom(std::make_pair(i, fw)))
+				{
+					overlapFroms.emplace_back(i, fw);
+					overlapTos.push_back(pair.first);
+					overlapValues.push_back(pair.second);
+				}
+			}
+		}
+		writeNodeSides(file, overlapFroms);
+		writeNodeSides(file, overlapTos);
+		Serializer::write(file, overlapValues);
+		Serializer::write(file, resolvableGraph.everTippable);
+		Serializer::write(file, resolvableGraph.lastTippableChecked);
+		std::vector<uint32_t> readOrdinals;
+		std::vector<size_t> readPartStarts;
+		readOrdinals.reserve(resolvableGraph.readNames.size());
+		readPartStarts.reserve(resolvableGraph.readNames.size());
+		for (const ReadName& name : resolvableGraph.readNames)
+		{
+			readOrdinals.push_back(name.first);
+			readPartStarts.push_back(name.second);
+		}
+		Serializer::write(file, readOrdinals);
+		Serializer::write(file, readPartStarts);
+		Serializer::write(file, resolvableGraph.averageCoverage);
+		Serializer::write(file, readPaths.size());
+		for (const auto& path : readPaths)
+		{
+			Serializer::write(file, path.path);
+			Serializer::write(file, path.reads);
+		}
+		if (checkpointer.spilledRawReadPaths != nullptr)
+		{
+			checkpointer.spilledRawReadPaths->write(file);
+		}
+		else
+		{
+			checkpointer.rawReadPaths->write(file);
+		}
+		if (!file.good())
+		{
+			std::cerr << "Could not write resolution checkpoint to " << tmpFileName << ", continuing without it" << std::endl;
+			return;
+		}
+	}
+	if (std::rename(tmpFileName.c_str(), checkpointer.fileName.c_str()) != 0)
+	{
+		std::cerr << "Could not replace resolution checkpoint " << checkpointer.fileName << ", continuing without it" << std::endl;
+		return;
+	}
+	checkpointer.lastWrite = std::chrono::steady_clock::now();
+}
+
+bool resolutionCheckpointDue(const ResolutionCheckpointer& checkpointer)
+{
+	if (checkpointer.fileName == "") return false;
+	return std::chrono::steady_clock::now() - checkpointer.lastWrite >= std::chrono::seconds(checkpointer.intervalSeconds);
+}
+
+// a bad checkpoint is a user error rather than a bug, so these exit without a core dump
+void checkCheckpointRead(const std::istream& file, const std::string& fileName)
+{
+	if (file.good()) return;
+	std::cerr << "Resolution checkpoint " << fileName << " is truncated" << std::endl;
+	std::exit(1);
+}
+
+// count is read from the file, and each counted item takes at least minBytesPerItem of the rest of the file
+void checkCheckpointCount(std::istream& file, const std::string& fileName, const size_t fileSize, const size_t count, const size_t minBytesPerItem)
+{
+	checkCheckpointRead(file, fileName);
+	size_t pos = file.tellg();
+	assert(pos <= fileSize);
+	if (count <= (fileSize - pos) / minBytesPerItem) return;
+	std::cerr << "Resolution checkpoint " << fileName << " is truncated" << std::endl;
+	std::exit(1);
+}
+
+// returns false if the checkpoint file does not exist
+// raw paths are read into spilledRawReadPaths if it is not null, otherwise into rawReadPaths
+bool readResolutionCheckpoint(const ResolutionCheckpointer& checkpointer, ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, ReadPathStore& rawReadPaths, SpilledReadPaths* spilledRawReadPaths, ResolutionProgress& progress)
+{
+	std::ifstream file { checkpointer.fileName, std::ios::binary };
+	if (!file.good()) return false;
+	file.seekg(0, std::ios::end);
+	const size_t fileSize = file.tellg();
+	file.seekg(0, std::ios::beg);
+	std::string magic;
+	Serializer::read(file, magic);
+	size_t numRawReadPaths = 0;
+	size_t numInitialUnitigs = 0;
+	size_t kmerSize = 0;
+	std::vector<size_t> parameters;
+	Serializer::read(file, numRawReadPaths);
+	Serializer::read(file, numInitialUnitigs);
+	Serializer::read(file, kmerSize);
+	Serializer::read(file, parameters);
+	checkCheckpointRead(file, checkpointer.fileName);
+	if (magic != ResolutionCheckpointMagic || numRawReadPaths != checkpointer.numRawReadPaths || numInitialUnitigs != checkpointer.numInitialUnitigs || kmerSize != resolvableGraph.kmerSize || parameters != checkpointer.parameters)
+	{
+		std::cerr << "Resolution checkpoint " << checkpointer.fileName << " does not match the input reads and parameters" << std::endl;
+		std::exit(1);
+	}
+	Serializer::read(file, progress.roundIndex);
+	Serializer::read(file, progress.lastTopSize);
+	Serializer::read(file, progress.nodesRemoved);
+	Serializer::read(file, progress.queueNodes);
+	size_t numUnitigs = 0;
+	Serializer::read(file, numUnitigs);
+	// unitig k-mers, crossing reads and the edges of both ends are each at least a length field
+	checkCheckpointCount(file, checkpointer.fileName, fileSize, numUnitigs, 4 * sizeof(size_t));
+	resolvableGraph.unitigs.clear();
+	resolvableGraph.unitigs.resize(numUnitigs);
+	resolvableGraph.readsCrossingNode.clear();
+	resolvableGraph.rawTripletCache.clear();
+	resolvableGraph.resizeCrossingReads(numUnitigs);
+	resolvableGraph.edges.resize(0);
+	resolvableGraph.edges.resize(numUnitigs);
+	for (size_t i = 0; i < numUnitigs; i++)
+	{
+		readNodeSides(file, resolvableGraph.unitigs[i]);
+		Serializer::read(file, resolvableGraph.readsCrossingNode[i]);
+		for (bool fw : { true, false })
+		{
+			std::vector<std::pair<size_t, bool>> edges;
+			readNodeSides(file, edges);
+			resolvableGraph.edges[std::make_pair(i, fw)].insert(edges.begin(), edges.end());
+		}
+		checkCheckpointRead(file, checkpointer.fileName);
+	}
+	Serializer::read(file, resolvableGraph.unitigLeftClipBp);
+	Serializer::read(file, resolvableGraph.unitigRightClipBp);
+	std::vector<uint8_t> removed;
+	Serializer::read(file, removed);
+	resolvableGraph.unitigRemoved.assign(removed.begin(), removed.end());
+	std::vector<std::pair<size_t, bool>> overlapFroms;
+	std::vector<std::pair<size_t, bool>> overlapTos;
+	std::vector<size_t> overlapValues;
+	readNodeSides(file, overlapFroms);
+	readNodeSides(file, overlapTos);
+	Serializer::read(file, overlapValues);
+	checkCheckpointRead(file, checkpointer.fileName);
+	if (overlapFroms.size() != overlapValues.size() || overlapTos.size() != overlapValues.size())
+	{
+		std::cerr << "Resolution checkpoint " << checkpointer.fileName << " is corrupted" << std::endl;
+		std::exit(1);
+	}
+	resolvableGraph.overlaps.clear();
+	for (size_t i = 0; i < overlapValues.size(); i++)
+	{
+		resolvableGraph.overlaps[std::make_pair(overlapFroms[i], overlapTos[i])] = overlapValues[i];
+	}
+	Serializer::read(file, resolvableGraph.everTippable);
+	Serializer::read(file, resolvableGraph.lastTippableChecked);
+	std::vector<uint32_t> readOrdinals;
+	std::vector<size_t> readPartStarts;
+	Serializer::read(file, readOrdinals);
+	Serializer::read(file, readPartStarts);
+	checkCheckpointRead(file, checkpointer.fileName);
+	if (readOrdinals.size() != readPartStarts.size())
+	{
+		std::cerr << "Resolution checkpoint " << checkpointer.fileName << " is corrupted" << std::endl;
+		std::exit(1);
+	}
+	resolvableGraph.readNames.clear();
+	resolvableGraph.readNames.reserve(readOrdinals.size());
+	for (size_t i = 0; i < readOrdinals.size(); i++)
+	{
+		resolvableGraph.readNames.emplace_back(readOrdinals[i], readPartStarts[i]);
+	}
+	Serializer::read(file, resolvableGraph.averageCoverage);
+	size_t numPaths = 0;
+	Serializer::read(file, numPaths);
+	// path and reads are each at least a length field
+	checkCheckpointCount(file, checkpointer.fileName, fileSize, numPaths, 2 * sizeof(size_t));
+	readPaths.clear();
+	readPaths.resize(numPaths);
+	for (size_t i = 0; i < numPaths; i++)
+	{
+		Serializer::read(file, readPaths[i].path);
+		Serializer::read(file, readPaths[i].reads);
+		checkCheckpointRead(file, checkpointer.fileName);
+	}
+	bool rawPathsConsistent = true;
+	if (spilledRawReadPaths != nullptr)
+	{
+		rawPathsConsistent = spilledRawReadPaths->read(file);
+	}
+	else
+	{
+		rawReadPaths.read(file);
+	}
+	checkCheckpointRead(file, checkpointer.fileName);
+	if (!rawPathsConsistent || (spilledRawReadPaths != nullptr ? spilledRawReadPaths->size() : rawReadPaths.size()) != numRawReadPaths)
+	{
+		std::cerr << "Resolution checkpoint " << checkpointer.fileName << " is corrupted" << std::endl;
+		std::exit(1);
 	}
+	resolvableGraph.precalcedUnitigLengths.clear();
+	resolvableGraph.coveredKmers.assign(numUnitigs, CoveredKmersNotCounted);
+	resolvableGraph.recountCrossingReads(readPaths);
+	resolvableGraph.recountEdgeReads(readPaths);
+	return true;
+}
+
+void resolveRound(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>& readPaths, const HashList& hashlist, const size_t minCoverage, const size_t maxResolveLength, const size_t maxUnconditionalResolveLength, const bool guesswork, const bool copycountFilterHeuristic, const bool onlyLocalResolve, const bool doCleaning, const size_t numThreads, const size_t roundIndex, ResolutionCheckpointer& checkpointer, const ResolutionProgress* resumeFrom, std::ostream& log)
+{
+	checkValidity(resolvableGraph, readPaths);
+	UnitigLengthQueue queue { resolvableGraph, maxResolveLength };
 	size_t lastTopSize = 0;
 	size_t nodesRemoved = 0;
+	if (resumeFrom != nullptr)
+	{
+		assert(resumeFrom->roundIndex == roundIndex);
+		for (const size_t node : resumeFrom->queueNodes)
+		{
+			queue.push(node);
+		}
+		lastTopSize = resumeFrom->lastTopSize;
+		nodesRemoved = resumeFrom->nodesRemoved;
+	}
+	else
+	{
+		for (size_t i = 0; i < resolvableGraph.unitigs.size(); i++)
+		{
+			if (resolvableGraph.unitigRemoved[i]) continue;
+			queue.push(i);
+		}
+	}
 	while (queue.size() > 0)
 	{
-		size_t topSize = resolvableGraph.unitigLength(queue.top());
+		if (resolutionCheckpointDue(checkpointer))
+		{
+			ResolutionProgress progress;
+			progress.roundIndex = roundIndex;
+			progress.lastTopSize = lastTopSize;
+			progress.nodesRemoved = nodesRemoved;
+			progress.queueNodes = queue.getAll();
+			writeResolutionCheckpoint(checkpointer, resolvableGraph, readPaths, progress);
+			log << "wrote resolution checkpoint after k=" << lastTopSize << std::endl;
+		}
+		size_t topSize = queue.topLength();
 		if (topSize >= maxResolveLength) break;
 		// assert(topSize >= lastTopSize);
 		lastTopSize = topSize;
 		phmap::flat_hash_set<size_t> resolvables;
 		phmap::flat_hash_set<size_t> thisLengthNodes;
-		while (queue.size() > 0 && resolvableGraph.unitigLength(queue.top()) == topSize)
+		for (const size_t node : queue.popShortest())
 		{
-			if (!resolvableGraph.unitigRemoved[queue.top()])
+			if (!resolvableGraph.unitigRemoved[node])
 			{
-				addPlusOneComponent(resolvableGraph, resolvables, queue.top(), topSize);
-				if (resolvableGraph.edges[std::make_pair(queue.top(), true)].size() >= 2 || resolvableGraph.edges[std::make_pair(queue.top(), false)].size() >= 2)
+				addPlusOneComponent(resolvableGraph, resolvables, node, topSize);
+				if (resolvableGraph.edges[std::make_pair(node, true)].size() >= 2 || resolvableGraph.edges[std::make_pair(node, false)].size() >= 2)
 				{
-					resolvables.emplace(queue.top());
+					resolvables.emplace(node);
 				}
-				else if (resolvableGraph.edges[std::make_pair(queue.top(), true)].size() >= 1 && resolvableGraph.edges[std::make_pair(queue.top(), false)].size() >= 1)
+				else if (resolvableGraph.edges[std::make_pair(node, true)].size() >= 1 && resolvableGraph.edges[std::make_pair(node, false)].size() >= 1)
 				{
-					assert(resolvableGraph.edges[std::make_pair(queue.top(), true)].size() == 1);
-					assert(resolvableGraph.edges[std::make_pair(queue.top(), false)].size() == 1);
-					if (resolvableGraph.unitigLength(resolvableGraph.edges[std::make_pair(queue.top(), true)].begin()->first) == topSize || resolvableGraph.unitigLength(resolvableGraph.edges[std::make_pair(queue.top(), false)].begin()->first) == topSize)
+					assert(resolvableGraph.edges[std::make_pair(node, true)].size() == 1);
+					assert(resolvableGraph.edges[std::make_pair(node, false)].size() == 1);
+					if (resolvableGraph.unitigLength(resolvableGraph.edges[std::make_pair(node, true)].begin()->first) == topSize || resolvableGraph.unitigLength(resolvableGraph.edges[std::make_pair(node, false)].begin()->first) == topSize)
 					{
-						if (resolvableGraph.edges[std::make_pair(queue.top(), true)].begin()->first != queue.top())
+						if (resolvableGraph.edges[std::make_pair(node, true)].begin()->first != node)
 						{
-							resolvables.emplace(queue.top());
+							resolvables.emplace(node);
 						}
 					}
 				}
 			}
-			thisLengthNodes.insert(queue.top());
-			queue.pop();
+			thisLengthNodes.insert(node);
 		}
 		if (onlyLocalResolve)
 		{
@@ -3949,9 +5076,10 @@ void resolveRound(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>
 		if (resolvables.size() == 0) continue;
 		assert(resolvables.size() > 0);
 		size_t oldSize = resolvableGraph.unitigs.size();
+		resolvableGraph.collectCrossingGarbage(readPaths, numThreads);
 		checkValidity(resolvableGraph, readPaths);
 		log << "try resolve k=" << topSize;
-		auto resolutionResult = resolve(resolvableGraph, hashlist, readPaths, resolvables, minCoverage, topSize < maxUnconditionalResolveLength, guesswork, copycountFilterHeuristic, log);
+		auto resolutionResult = resolve(resolvableGraph, hashlist, readPaths, resolvables, minCoverage, topSize < maxUnconditionalResolveLength, guesswork, copycountFilterHeuristic, numThreads, log);
 		log << ", replaced " << resolutionResult.nodesResolved << " nodes with " << resolutionResult.nodesAdded << " nodes";
 		nodesRemoved += resolutionResult.nodesResolved;
 		if (resolutionResult.nodesResolved == 0)
@@ -3984,7 +5112,7 @@ void resolveRound(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>
 				{
 					assert(unitigifiedHere[i].first[0] == std::make_pair(unitigifiedHere[i].second, true));
 					assert(!resolvableGraph.unitigRemoved[unitigifiedHere[i].second]);
-					queue.emplace(unitigifiedHere[i].second);
+					queue.push(unitigifiedHere[i].second);
 				}
 			}
 		}
@@ -4031,7 +5159,7 @@ void resolveRound(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>
 					{
 						assert(unitigifiedHere[i].first[0] == std::make_pair(unitigifiedHere[i].second, true));
 						assert(!resolvableGraph.unitigRemoved[unitigifiedHere[i].second]);
-						queue.emplace(unitigifiedHere[i].second);
+						queue.push(unitigifiedHere[i].second);
 					}
 				}
 			}
@@ -4040,7 +5168,7 @@ void resolveRound(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>
 		{
 			phmap::flat_hash_set<size_t> cleanables = thisLengthNodes;
 			cleanables.insert(resolutionResult.maybeUnitigifiable.begin(), resolutionResult.maybeUnitigifiable.end());
-			auto removed = cleanComponentsByCopynumber(resolvableGraph, readPaths, 50000, topSize, 0, cleanables, oldSize);
+			auto removed = cleanComponentsByCopynumber(resolvableGraph, readPaths, 50000, topSize, 0, cleanables, oldSize, numThreads);
 			if (removed.nodesRemoved > 0 || removed.edgesRemoved > 0)
 			{
 				log << "removed " << removed.nodesRemoved << " nodes and " << removed.edgesRemoved << " edges" << std::endl;
@@ -4058,18 +5186,18 @@ void resolveRound(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>
 					else
 					{
 						assert(unitigifiedHere[i].first[0] == std::make_pair(unitigifiedHere[i].second, true));
-						queue.emplace(unitigifiedHere[i].second);
+						queue.push(unitigifiedHere[i].second);
 					}
 				}
 			}
 		}
 		if (doCleaning)
 		{
-			auto removed = removeLowCoverageTips(resolvableGraph, readPaths, hashlist, 3, 10, 10000, resolutionResult.maybeUnitigifiable);
+			auto removed = removeLowCoverageTips(resolvableGraph, readPaths, hashlist, 3, 10, 10000, resolutionResult.maybeUnitigifiable, numThreads);
 			resolutionResult.maybeUnitigifiable.insert(removed.maybeUnitigifiable.begin(), removed.maybeUnitigifiable.end());
-			auto removed2 = removeLowCoverageTips(resolvableGraph, readPaths, hashlist, 2, 5, 10000, resolutionResult.maybeUnitigifiable);
-			auto removed3 = removeLowCoverageCrosslinks(resolvableGraph, readPaths, 1, 5);
-			auto removed4 = removeLowCoverageCrosslinks(resolvableGraph, readPaths, 2, 10);
+			auto removed2 = removeLowCoverageTips(resolvableGraph, readPaths, hashlist, 2, 5, 10000, resolutionResult.maybeUnitigifiable, numThreads);
+			auto removed3 = removeLowCoverageCrosslinks(resolvableGraph, readPaths, 1, 5, numThreads);
+			auto removed4 = removeLowCoverageCrosslinks(resolvableGraph, readPaths, 2, 10, numThreads);
 			nodesRemoved += removed.nodesRemoved + removed2.nodesRemoved;
 			if (removed.nodesRemoved + removed2.nodesRemoved > 0 || removed.edgesRemoved + removed2.edgesRemoved + removed3.edgesRemoved + removed4.edgesRemoved > 0)
 			{
@@ -4090,8 +5218,8 @@ void resolveRound(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>
 					else
 					{
 						assert(unitigifiedHere[i].first[0] == std::make_pair(unitigifiedHere[i].second, true));
-						queue.emplace(unitigifiedHere[i].second);
-						if (resolvableGraph.precalcedUnitigCoverages.size() > unitigifiedHere[i].second) resolvableGraph.precalcedUnitigCoverages[unitigifiedHere[i].second] = 0;
+						queue.push(unitigifiedHere[i].second);
+						resolvableGraph.invalidateCoverage(unitigifiedHere[i].second);
 					}
 				}
 			}
@@ -4100,17 +5228,15 @@ void resolveRound(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>
 		for (size_t i = oldSize; i < resolvableGraph.unitigs.size(); i++)
 		{
 			if (resolvableGraph.unitigRemoved[i]) continue;
-			queue.emplace(i);
+			queue.push(i);
 		}
 		if (nodesRemoved > resolvableGraph.unitigs.size() / 2 + 50)
 		{
 			std::vector<size_t> queueNodes;
-			while (queue.size() > 0)
+			for (const size_t node : queue.popAll())
 			{
-				auto top = queue.top();
-				queue.pop();
-				if (resolvableGraph.unitigRemoved[top]) continue;
-				queueNodes.emplace_back(top);
+				if (resolvableGraph.unitigRemoved[node]) continue;
+				queueNodes.emplace_back(node);
 			}
 			size_t oldSize = resolvableGraph.unitigs.size();
 			compact(resolvableGraph, readPaths, queueNodes);
@@ -4122,7 +5248,7 @@ void resolveRound(ResolvableUnitigGraph& resolvableGraph, std::vector<PathGroup>
 			{
 				assert(node < resolvableGraph.unitigs.size());
 				assert(!resolvableGraph.unitigRemoved[node]);
-				queue.emplace(node);
+				queue.push(node);
 			}
 		}
 	}
@@ -4143,56 +5269,66 @@ bool operator!=(const std::vector<std::pair<size_t, bool>>& left, const std::vec
 	return !(left == right);
 }
 
-std::pair<UnitigGraph, std::vector<ReadPath>> resolveUnitigs(const UnitigGraph& initial, const HashList& hashlist, std::vector<ReadPath>& rawReadPaths, const ReadpartIterator& partIterator, const size_t minCoverage, const size_t kmerSize, const size_t maxResolveLength, const size_t maxUnconditionalResolveLength, const bool keepGaps, const bool guesswork, const bool copycountFilterHeuristic, const bool onlyLocalResolve, const bool doCleaning, std::ostream& log)
+// groups read paths with identical node paths and does the initial cleaning before resolution
+std::vector<PathGroup> getPathGroups(ResolvableUnitigGraph& resolvableGraph, const ReadPathStore& rawReadPaths, const size_t maxResolveLength, const bool guesswork, const bool doCleaning, const HashList& hashlist, const size_t numThreads, std::ostream& log)
 {
-	auto resolvableGraph = getUnitigs(initial, minCoverage, hashlist, kmerSize, keepGaps, log);
-	log << rawReadPaths.size() << " raw read paths" << std::endl;
-	// todo maybe fix? or does it matter?
-	cutRemovedEdgesFromPaths(resolvableGraph, rawReadPaths);
-	std::sort(rawReadPaths.begin(), rawReadPaths.end(), [](const ReadPath& left, const ReadPath& right) { return left.path < right.path; });
-	std::vector<ReadPathInfo> readInfos;
+	// the raw paths are not moved, path group reads refer to them by index
+	std::vector<size_t> pathOrder;
+	pathOrder.reserve(rawReadPaths.size());
+	for (size_t i = 0; i < rawReadPaths.size(); i++)
+	{
+		pathOrder.push_back(i);
+	}
+	// ties are broken by index so the order of the reads in a group does not depend on the sort
+	sortMultithreaded(pathOrder, numThreads, [&rawReadPaths](size_t left, size_t right)
+	{
+		if (rawReadPaths.pathLess(left, right)) return true;
+		if (rawReadPaths.pathLess(right, left)) return false;
+		return left < right;
+	});
 	std::vector<PathGroup> readPaths;
 	{
 		std::unordered_map<ReadName, size_t> nameLookup;
-		for (size_t i = 0; i < rawReadPaths.size(); i++)
+		for (size_t orderi = 0; orderi < pathOrder.size(); orderi++)
 		{
-			if (rawReadPaths[i].path.size() == 0) continue;
-			assert(rawReadPaths[i].readPoses.size() > 0);
-			if (readPaths.size() == 0 || readPaths.back().path != rawReadPaths[i].path)
+			const size_t i = pathOrder[orderi];
+			VectorView<Node> rawPath = rawReadPaths.path(i);
+			assert(rawPath.size() > 0);
+			assert(rawReadPaths.numReadPoses(i) > 0);
+			if (readPaths.size() == 0 || !rawReadPaths.pathEqual(pathOrder[orderi-1], i))
 			{
 				readPaths.emplace_back();
-				readPaths.back().path.insert(readPaths.back().path.end(), rawReadPaths[i].path.begin(), rawReadPaths[i].path.end());
-				for (size_t j = 0; j < rawReadPaths[i].path.size(); j++)
+				readPaths.back().path.insert(readPaths.back().path.end(), rawPath.begin(), rawPath.end());
+				for (size_t j = 0; j < rawPath.size(); j++)
 				{
-					resolvableGraph.readsCrossingNode[rawReadPaths[i].path[j].id()].emplace_back(readPaths.size()-1, j);
+					resolvableGraph.readsCrossingNode[rawPath[j].id()].emplace_back(readPaths.size()-1, j);
 				}
 			}
 			assert(readPaths.size() > 0);
 			assert(readPaths.back().path.size() > 0);
-			assert(readPaths.back().path == rawReadPaths[i].path);
-			if (nameLookup.count(rawReadPaths[i].readName) == 0)
+			assert(readPaths.back().path.size() == rawPath.size());
+			assert(std::equal(rawPath.begin(), rawPath.end(), readPaths.back().path.begin()));
+			ReadName readName = rawReadPaths.readName(i);
+			if (nameLookup.count(readName) == 0)
 			{
 				size_t n = resolvableGraph.readNames.size();
-				resolvableGraph.readNames.push_back(rawReadPaths[i].readName);
-				nameLookup[rawReadPaths[i].readName] = n;
-			}
-			readInfos.emplace_back();
-			readInfos.back().readPoses = rawReadPaths[i].readPoses;
-			readInfos.back().expandedReadPosStart = rawReadPaths[i].expandedReadPosStart;
-			readInfos.back().expandedReadPosEnd = rawReadPaths[i].expandedReadPosEnd;
-			readInfos.back().readLength = rawReadPaths[i].readLength;
-			readInfos.back().readLengthHPC = rawReadPaths[i].readLengthHPC;
+				resolvableGraph.readNames.push_back(readName);
+				nameLookup[readName] = n;
+			}
 			readPaths.back().reads.emplace_back();
-			readPaths.back().reads.back().readInfoIndex = readInfos.size()-1;
-			readPaths.back().reads.back().readPosZeroOffset = rawReadPaths[i].readPoses[0];
-			readPaths.back().reads.back().readNameIndex = nameLookup[rawReadPaths[i].readName];
+			readPaths.back().reads.back().readInfoIndex = i;
+			readPaths.back().reads.back().readPosZeroOffset = rawReadPaths.firstReadPos(i);
+			readPaths.back().reads.back().readNameIndex = nameLookup[readName];
 			readPaths.back().reads.back().readPosStartIndex = 0;
-			readPaths.back().reads.back().readPosEndIndex = rawReadPaths[i].readPoses.size();
-			readPaths.back().reads.back().leftClip = rawReadPaths[i].leftClip;
-			readPaths.back().reads.back().rightClip = rawReadPaths[i].rightClip;
+			readPaths.back().reads.back().readPosEndIndex = rawReadPaths.numReadPoses(i);
+			readPaths.back().reads.back().leftClip = rawReadPaths.leftClip(i);
+			readPaths.back().reads.back().rightClip = rawReadPaths.rightClip(i);
 			assert(getNumberOfHashes(resolvableGraph, 0, 0, readPaths.back().path) == (readPaths.back().reads.back().readPosEndIndex - readPaths.back().reads.back().readPosStartIndex) + readPaths.back().reads.back().leftClip + readPaths.back().reads.back().rightClip);
 		}
 	}
+	resolvableGraph.recountCrossingReads(readPaths);
+	resolvableGraph.recountEdgeReads(readPaths);
+	resolvableGraph.coveredKmers.assign(resolvableGraph.unitigs.size(), CoveredKmersNotCounted);
 	log << rawReadPaths.size() << " raw read paths" << std::endl;
 	log << readPaths.size() << " read paths" << std::endl;
 	for (size_t i = 0; i < resolvableGraph.unitigs.size(); i++)
@@ -4202,13 +5338,13 @@ std::pair<UnitigGraph, std::vector<ReadPath>> resolveUnitigs(const UnitigGraph&
 	unitigifyAll(resolvableGraph, readPaths);
 	if (doCleaning)
 	{
-		auto removed = removeLowCoverageTips(resolvableGraph, readPaths, hashlist, 3, 10, 10000, phmap::flat_hash_set<size_t> {});
+		auto removed = removeLowCoverageTips(resolvableGraph, readPaths, hashlist, 3, 10, 10000, phmap::flat_hash_set<size_t> {}, numThreads);
 		if (removed.nodesRemoved > 0)
 		{
 			log << "removed " << removed.nodesRemoved << " tips" << std::endl;
 			unitigifyAll(resolvableGraph, readPaths);
 		}
-		auto removedEdges = removeLowCoverageCrosslinks(resolvableGraph, readPaths, 2, 10);
+		auto removedEdges = removeLowCoverageCrosslinks(resolvableGraph, readPaths, 2, 10, numThreads);
 		if (removedEdges.edgesRemoved > 0)
 		{
 			log << "removed " << removedEdges.edgesRemoved << " crosslinks" << std::endl;
@@ -4216,7 +5352,7 @@ std::pair<UnitigGraph, std::vector<ReadPath>> resolveUnitigs(const UnitigGraph&
 		}
 		if (guesswork)
 		{
-			auto removed2 = cleanComponentsByCopynumber(resolvableGraph, readPaths, 50000, 0, maxResolveLength);
+			auto removed2 = cleanComponentsByCopynumber(resolvableGraph, readPaths, 50000, 0, maxResolveLength, numThreads);
 			if (removed2.nodesRemoved > 0 || removed2.edgesRemoved > 0)
 			{
 				log << "removed " << removed2.nodesRemoved << " nodes and " << removed2.edgesRemoved << " edges" << std::endl;
@@ -4224,8 +5360,113 @@ std::pair<UnitigGraph, std::vector<ReadPath>> resolveUnitigs(const UnitigGraph&
 			}
 		}
 	}
-	resolveRound(resolvableGraph, readPaths, hashlist, minCoverage, maxResolveLength, maxUnconditionalResolveLength, guesswork, copycountFilterHeuristic, onlyLocalResolve, doCleaning, log);
-	resolveRound(resolvableGraph, readPaths, hashlist, 1, maxResolveLength, maxUnconditionalResolveLength, guesswork, copycountFilterHeuristic, onlyLocalResolve, doCleaning, log);
+	return readPaths;
+}
+
+// a spilled read path file finds the paths of a read by their index among the paths of the read, in the order of rawReadPaths
+void setReadInfoIndicesWithinReads(std::vector<PathGroup>& readPaths, const ReadPathStore& rawReadPaths, const size_t numReads)
+{
+	std::vector<uint32_t> indexWithinRead;
+	std::vector<uint32_t> readPathCount;
+	indexWithinRead.resize(rawReadPaths.size());
+	readPathCount.resize(numReads, 0);
+	for (size_t i = 0; i < rawReadPaths.size(); i++)
+	{
+		const uint32_t readOrdinal = rawReadPaths.readName(i).first;
+		assert(readOrdinal < numReads);
+		indexWithinRead[i] = readPathCount[readOrdinal];
+		readPathCount[readOrdinal] += 1;
+	}
+	for (auto& path : readPaths)
+	{
+		for (auto& read : path.reads)
+		{
+			read.readInfoIndex = indexWithinRead[read.readInfoIndex];
+		}
+	}
+}
+
+std::tuple<UnitigGraph, ReadPathStore, std::unique_ptr<SpilledReadPaths>> resolveUnitigs(const UnitigGraph& initial, const HashList& hashlist, ReadPathStore&& uncutReadPaths, const ReadpartIterator& partIterator, const size_t minCoverage, const size_t kmerSize, const size_t maxResolveLength, const size_t maxUnconditionalResolveLength, const bool keepGaps, const bool guesswork, const bool copycountFilterHeuristic, const bool onlyLocalResolve, const bool doCleaning, const size_t numThreads, const std::string& readPathFile, const std::string& checkpointFile, const size_t checkpointIntervalSeconds, const bool resumeResolution, std::ostream& log)
+{
+	auto resolvableGraph = getUnitigs(initial, minCoverage, hashlist, kmerSize, keepGaps, numThreads, log);
+	log << uncutReadPaths.size() << " raw read paths" << std::endl;
+	// todo maybe fix? or does it matter?
+	ReadPathStore rawReadPaths = cutRemovedEdgesFromPaths(resolvableGraph, uncutReadPaths, numThreads);
+	{
+		ReadPathStore tmp;
+		std::swap(tmp, uncutReadPaths);
+	}
+	const size_t numReads = partIterator.getReadNames().size();
+	// the resolution rounds only need the path groups, so with a read path file the raw paths wait on disk until the final paths are built
+	const std::string rawReadPathFile = readPathFile + ".raw";
+	std::unique_ptr<SpilledReadPaths> spilledRawReadPaths;
+	ResolutionCheckpointer checkpointer;
+	checkpointer.fileName = checkpointFile;
+	checkpointer.intervalSeconds = checkpointIntervalSeconds;
+	checkpointer.numRawReadPaths = rawReadPaths.size();
+	checkpointer.rawReadPaths = &rawReadPaths;
+	checkpointer.spilledRawReadPaths = nullptr;
+	checkpointer.numInitialUnitigs = initial.unitigs.size();
+	// readInfoIndex of the stored path groups depends on whether the raw paths are spilled
+	checkpointer.parameters = { maxResolveLength, maxUnconditionalResolveLength, minCoverage, keepGaps, guesswork, copycountFilterHeuristic, onlyLocalResolve, doCleaning, readPathFile != "" };
+	checkpointer.lastWrite = std::chrono::steady_clock::now();
+	std::vector<PathGroup> readPaths;
+	ResolutionProgress resumeProgress;
+	bool resumed = false;
+	if (resumeResolution)
+	{
+		assert(checkpointFile != "");
+		if (readPathFile != "") spilledRawReadPaths = std::make_unique<SpilledReadPaths>(rawReadPathFile, numReads);
+		resumed = readResolutionCheckpoint(checkpointer, resolvableGraph, readPaths, rawReadPaths, spilledRawReadPaths.get(), resumeProgress);
+		if (resumed)
+		{
+			log << "resumed resolution from checkpoint " << checkpointFile << " after k=" << resumeProgress.lastTopSize << std::endl;
+		}
+		else
+		{
+			log << "no resolution checkpoint at " << checkpointFile << ", starting from the beginning" << std::endl;
+		}
+	}
+	if (!resumed)
+	{
+		readPaths = getPathGroups(resolvableGraph, rawReadPaths, maxResolveLength, guesswork, doCleaning, hashlist, numThreads, log);
+		if (readPathFile != "")
+		{
+			setReadInfoIndicesWithinReads(readPaths, rawReadPaths, numReads);
+			spilledRawReadPaths.reset();
+			log << "Moving raw read paths to " << rawReadPathFile << std::endl;
+			spilledRawReadPaths = std::make_unique<SpilledReadPaths>(rawReadPathFile, std::move(rawReadPaths), numReads);
+		}
+	}
+	else if (readPathFile != "")
+	{
+		ReadPathStore tmp;
+		std::swap(tmp, rawReadPaths);
+	}
+	checkpointer.spilledRawReadPaths = spilledRawReadPaths.get();
+	if (!resumed || resumeProgress.roundIndex == 0)
+	{
+		resolveRound(resolvableGraph, readPaths, hashlist, minCoverage, maxResolveLength, maxUnconditionalResolveLength, guesswork, copycountFilterHeuristic, onlyLocalResolve, doCleaning, numThreads, 0, checkpointer, resumed ? &resumeProgress : nullptr, log);
+	}
+	if (!resumed || resumeProgress.roundIndex <= 1)
+	{
+		resolveRound(resolvableGraph, readPaths, hashlist, 1, maxResolveLength, maxUnconditionalResolveLength, guesswork, copycountFilterHeuristic, onlyLocalResolve, doCleaning, numThreads, 1, checkpointer, (resumed && resumeProgress.roundIndex == 1) ? &resumeProgress : nullptr, log);
+		if (checkpointFile != "")
+		{
+			// resolution is done, a resumed run can go straight to building the final graph
+			ResolutionProgress progress;
+			progress.roundIndex = 2;
+			progress.lastTopSize = maxResolveLength;
+			progress.nodesRemoved = 0;
+			writeResolutionCheckpoint(checkpointer, resolvableGraph, readPaths, progress);
+		}
+	}
 	checkValidity(resolvableGraph, readPaths);
-	return resolvableToUnitigs(resolvableGraph, readPaths, readInfos);
+	UnitigGraph result = resolvableToUnitigs(resolvableGraph, readPaths, numThreads);
+	if (spilledRawReadPaths != nullptr)
+	{
+		log << "Moving read paths to " << readPathFile << std::endl;
+		return std::make_tuple(std::move(result), ReadPathStore {}, getResolvedReadPaths(resolvableGraph, readPaths, *spilledRawReadPaths, readPathFile, numThreads));
+	}
+	return std::make_tuple(std::move(result), getResolvedReadPaths(resolvableGraph, readPaths, rawReadPaths, numThreads), std::unique_ptr<SpilledReadPaths> {});
 }
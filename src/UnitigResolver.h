@@ -2,6 +2,7 @@
 #define UnitigResolver_h
 
 #include <tuple>
+#include <memory>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -10,22 +11,10 @@
 #include "CumulativeVector.h"
 #include "ReadHelper.h"
 #include "Node.h"
+#include "ReadPathStore.h"
+#include "SpilledReadPaths.h"
 
-class ReadPath
-{
-public:
-	ReadName readName;
-	std::vector<Node> path;
-	std::vector<uint32_t> readPoses;
-	size_t expandedReadPosStart;
-	size_t expandedReadPosEnd;
-	size_t leftClip;
-	size_t rightClip;
-	size_t readLength;
-	size_t readLengthHPC;
-private:
-};
-
-std::pair<UnitigGraph, std::vector<ReadPath>> resolveUnitigs(const UnitigGraph& initial, const HashList& hashlist, std::vector<ReadPath>& readPaths, const ReadpartIterator& partIterator, const size_t minCoverage, const size_t kmerSize, const size_t maxResolveLength, const size_t maxUnconditionalResolveLength, const bool keepGaps, const bool guesswork, const bool copycountFilterHeuristic, const bool onlyLocalResolve, const bool doCleaning, std::ostream& log);
+// readPaths are consumed, with a readPathFile the resolved paths are returned spilled into it instead of in the ReadPathStore
+std::tuple<UnitigGraph, ReadPathStore, std::unique_ptr<SpilledReadPaths>> resolveUnitigs(const UnitigGraph& initial, const HashList& hashlist, ReadPathStore&& readPaths, const ReadpartIterator& partIterator, const size_t minCoverage, const size_t kmerSize, const size_t maxResolveLength, const size_t maxUnconditionalResolveLength, const bool keepGaps, const bool guesswork, const bool copycountFilterHeuristic, const bool onlyLocalResolve, const bool doCleaning, const size_t numThreads, const std::string& readPathFile, const std::string& checkpointFile, const size_t checkpointIntervalSeconds, const bool resumeResolution, std::ostream& log);
 
 #endif
@@ -0,0 +1,3 @@
+#include "Validation.h"
+
+ValidationLevel validationLevel = ValidationLevel::Cheap;
@@ -0,0 +1,34 @@
+#ifndef Validation_h
+#define Validation_h
+
+#include <cassert>
+
+// which consistency checks run on top of the plain asserts, set with --validation
+// Cheap: per item invariants in hot loops
+// Full: also whole-structure passes and per item checks which need extra lookups
+enum ValidationLevel
+{
+	None,
+	Cheap,
+	Full,
+};
+
+extern ValidationLevel validationLevel;
+
+// release builds (make release) compile the full level out, cheap checks are kept
+#ifdef MBG_RELEASE
+const bool fullValidationAvailable = false;
+#else
+const bool fullValidationAvailable = true;
+#endif
+
+inline bool validationEnabled(const ValidationLevel level)
+{
+	if (level == ValidationLevel::Full && !fullValidationAvailable) return false;
+	return validationLevel >= level;
+}
+
+#define assertCheap(expression) assert(!validationEnabled(ValidationLevel::Cheap) || (expression))
+#define assertFull(expression) assert(!validationEnabled(ValidationLevel::Full) || (expression))
+
+#endif
@@ -2,6 +2,7 @@
 #include <string>
 #include <cxxopts.hpp>
 #include "MBG.h"
+#include "Validation.h"
 
 int main(int argc, char** argv)
 {
@@ -25,6 +26,10 @@ int main(int argc, char** argv)
 		("R,resolve-maxk-allowgaps", "Allow multiplex resolution to add gaps up to this k-mer size", cxxopts::value<size_t>())
 		("node-name-prefix", "Add a prefix to output node names", cxxopts::value<std::string>())
 		("sequence-cache-file", "Use a temporary sequence cache file to speed up graph construction", cxxopts::value<std::string>())
+		("read-path-file", "Keep read paths in temporary files starting with this name instead of memory during multiplex resolution, building unitig sequences and writing paths", cxxopts::value<std::string>())
+		("resolution-checkpoint", "Save multiplex resolution progress to this file periodically", cxxopts::value<std::string>())
+		("resolution-checkpoint-interval", "Seconds between resolution checkpoints", cxxopts::value<size_t>()->default_value("600"))
+		("resume-resolution", "Continue multiplex resolution from the file given by --resolution-checkpoint if it exists")
 		("keep-gaps", "Don't remove low coverage nodes if it would leave a gap in the graph")
 		("hpc-variant-onecopy-coverage", "Separate k-mers based on hpc variants, using arg as single copy coverage", cxxopts::value<double>())
 		("do-unsafe-guesswork-resolutions", "Use extra heuristics during multiplex resolution")
@@ -33,6 +38,7 @@ int main(int argc, char** argv)
 		("output-homology-map", "Output a list of homologous k-mer locations", cxxopts::value<std::string>())
 		("no-kmer-filter-inside-unitig", "Don't filter out k-mers which are completely contained by two other k-mers")
 		("no-multiplex-cleaning", "Don't clean low coverage tips and structures during multiplex resolution")
+		("validation", "Internal consistency checks", cxxopts::value<std::string>()->default_value("cheap"))
 	;
 	auto params = options.parse(argc, argv);
 	if (params.count("v") == 1)
@@ -51,6 +57,10 @@ int main(int argc, char** argv)
 		std::cerr << "\tcollapse\tCollapse homopolymers" << std::endl;
 		std::cerr << "\tcollapse-dinuc\tCollapse homopolymers and mask dinucleotide errors" << std::endl;
 		std::cerr << "\tcollapse-msat\tCollapse homopolymers and mask microsatellite errors up to 6bp" << std::endl;
+		std::cerr << "Options for --validation:" << std::endl;
+		std::cerr << "\tnone\tOnly asserts" << std::endl;
+		std::cerr << "\tcheap\tAlso check per item invariants in hot loops (default)" << std::endl;
+		std::cerr << "\tfull\tAlso check whole graph consistency, slow. Not available in release builds" << std::endl;
 		exit(0);
 	}
 	bool paramError = false;
@@ -99,8 +109,13 @@ int main(int argc, char** argv)
 	bool filterWithinUnitig = true;
 	bool doCleaning = true;
 	std::string errorMaskingStr = "hpc";
+	std::string validationStr = "cheap";
 	std::string nodeNamePrefix = "";
 	std::string sequenceCacheFile = "";
+	std::string readPathFile = "";
+	std::string resolutionCheckpointFile = "";
+	size_t resolutionCheckpointInterval = 600;
+	bool resumeResolution = false;
 	std::string outputHomologyMap = "";
 	if (params.count("r") == 1) maxResolveLength = params["r"].as<size_t>();
 	if (params.count("R") == 1) maxUnconditionalResolveLength = params["R"].as<size_t>();
@@ -144,10 +159,40 @@ int main(int argc, char** argv)
 			paramError = true;
 		}
 	}
+	if (params.count("validation") == 1)
+	{
+		validationStr = params["validation"].as<std::string>();
+		if (validationStr == "none")
+		{
+			validationLevel = ValidationLevel::None;
+		}
+		else if (validationStr == "cheap")
+		{
+			validationLevel = ValidationLevel::Cheap;
+		}
+		else if (validationStr == "full" && fullValidationAvailable)
+		{
+			validationLevel = ValidationLevel::Full;
+		}
+		else if (validationStr == "full")
+		{
+			std::cerr << "--validation full is not available in release builds" << std::endl;
+			paramError = true;
+		}
+		else
+		{
+			std::cerr << "unknown parameter for --validation: \"" << validationStr << "\"" << std::endl;
+			paramError = true;
+		}
+	}
 	if (params.count("include-end-kmers") == 1) includeEndKmers = true;
 	if (params.count("output-sequence-paths") == 1) outputSequencePaths = params["output-sequence-paths"].as<std::string>();
 	if (params.count("node-name-prefix") == 1) nodeNamePrefix = params["node-name-prefix"].as<std::string>();
 	if (params.count("sequence-cache-file") == 1) sequenceCacheFile = params["sequence-cache-file"].as<std::string>();
+	if (params.count("read-path-file") == 1) readPathFile = params["read-path-file"].as<std::string>();
+	if (params.count("resolution-checkpoint") == 1) resolutionCheckpointFile = params["resolution-checkpoint"].as<std::string>();
+	if (params.count("resolution-checkpoint-interval") == 1) resolutionCheckpointInterval = params["resolution-checkpoint-interval"].as<size_t>();
+	if (params.count("resume-resolution") == 1) resumeResolution = true;
 	if (params.count("hpc-variant-onecopy-coverage") == 1) hpcVariantOnecopyCoverage = params["hpc-variant-onecopy-coverage"].as<double>();
 	if (params.count("copycount-filter-heuristic") == 1) copycountFilterHeuristic = true;
 	if (params.count("only-local-resolve") == 1) onlyLocalResolve = true;
@@ -195,6 +240,11 @@ int main(int argc, char** argv)
 		std::cerr << "-r (--resolve-maxk) and --blunt are not supported together" << std::endl;
 		paramError = true;
 	}
+	if (resumeResolution && resolutionCheckpointFile == "")
+	{
+		std::cerr << "--resume-resolution requires --resolution-checkpoint" << std::endl;
+		paramError = true;
+	}
 	if (paramError) std::abort();
 	
 	std::cerr << "Parameters: ";
@@ -215,8 +265,12 @@ int main(int argc, char** argv)
 	std::cerr << "onlylocal=" << (onlyLocalResolve ? "yes" : "no") << ",";
 	std::cerr << "filterwithinunitig=" << (filterWithinUnitig ? "yes" : "no") << ",";
 	std::cerr << "cleaning=" << (doCleaning ? "yes" : "no") << ",";
-	std::cerr << "cache=" << (sequenceCacheFile.size() > 0 ? "yes" : "no");
+	std::cerr << "cache=" << (sequenceCacheFile.size() > 0 ? "yes" : "no") << ",";
+	std::cerr << "pathfile=" << (readPathFile.size() > 0 ? "yes" : "no") << ",";
+	std::cerr << "checkpoint=" << (resolutionCheckpointFile.size() > 0 ? (resumeResolution ? "resume" : "yes") : "no") << ",";
+	if (resolutionCheckpointFile.size() > 0) std::cerr << "checkpointinterval=" << resolutionCheckpointInterval << ",";
+	std::cerr << "validation=" << validationStr;
 	std::cerr << std::endl;
 
-	runMBG(inputReads, outputGraph, kmerSize, windowSize, minCoverage, minUnitigCoverage, errorMasking, numThreads, includeEndKmers, outputSequencePaths, maxResolveLength, blunt, maxUnconditionalResolveLength, nodeNamePrefix, sequenceCacheFile, keepGaps, hpcVariantOnecopyCoverage, guesswork, copycountFilterHeuristic, onlyLocalResolve, outputHomologyMap, filterWithinUnitig, doCleaning);
+	runMBG(inputReads, outputGraph, kmerSize, windowSize, minCoverage, minUnitigCoverage, errorMasking, numThreads, includeEndKmers, outputSequencePaths, maxResolveLength, blunt, maxUnconditionalResolveLength, nodeNamePrefix, sequenceCacheFile, keepGaps, hpcVariantOnecopyCoverage, guesswork, copycountFilterHeuristic, onlyLocalResolve, outputHomologyMap, filterWithinUnitig, doCleaning, readPathFile, resolutionCheckpointFile, resolutionCheckpointInterval, resumeResolution);
 }
\ No newline at end of file
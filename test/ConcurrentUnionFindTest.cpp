@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "TestHelper.h"
+#include "ConcurrentUnionFind.h"
+
+namespace
+{
+	// merges the pairs split over numThreads threads, each thread in its own shuffled order
+	void mergeInThreads(ConcurrentUnionFind& unionFind, const std::vector<std::pair<size_t, size_t>>& pairs, const size_t numThreads)
+	{
+		std::vector<std::thread> threads;
+		for (size_t thread = 0; thread < numThreads; thread++)
+		{
+			threads.emplace_back([&unionFind, &pairs, numThreads, thread]()
+			{
+				std::vector<size_t> order;
+				for (size_t i = thread; i < pairs.size(); i += numThreads) order.push_back(i);
+				std::mt19937_64 rand { thread };
+				std::shuffle(order.begin(), order.end(), rand);
+				for (size_t i : order)
+				{
+					unionFind.merge(pairs[i].first, pairs[i].second);
+					// finds in between exercise path halving while others link roots
+					unionFind.find(pairs[(i * 7919) % pairs.size()].second);
+				}
+			});
+		}
+		for (size_t i = 0; i < threads.size(); i++)
+		{
+			threads[i].join();
+		}
+	}
+}
+
+MBG_TEST(ConcurrentUnionFindSingleThread)
+{
+	ConcurrentUnionFind unionFind { 10 };
+	CHECK(unionFind.size() == 10);
+	for (size_t i = 0; i < 10; i++) CHECK(unionFind.find(i) == i);
+	unionFind.merge(9, 7);
+	unionFind.merge(7, 8);
+	unionFind.merge(4, 8);
+	unionFind.merge(4, 9);
+	unionFind.merge(2, 2);
+	CHECK(unionFind.find(9) == 4);
+	CHECK(unionFind.find(8) == 4);
+	CHECK(unionFind.find(7) == 4);
+	CHECK(unionFind.find(2) == 2);
+	CHECK(unionFind.find(0) == 0);
+	unionFind.merge(8, 1);
+	for (size_t i : { 1, 4, 7, 8, 9 }) CHECK(unionFind.find(i) == 1);
+}
+
+MBG_TEST(ConcurrentUnionFindParallelMerges)
+{
+	const size_t numItems = 200000;
+	const size_t numSets = 97;
+	// sets are the residues mod numSets, merged both as chains and towards random earlier members
+	std::vector<std::pair<size_t, size_t>> pairs;
+	std::mt19937_64 rand { 5 };
+	for (size_t i = numSets; i < numItems; i++)
+	{
+		if (i % 3 == 0)
+		{
+			pairs.emplace_back(i, i - numSets);
+		}
+		else
+		{
+			size_t earlier = (rand() % (i / numSets)) * numSets + i % numSets;
+			pairs.emplace_back(earlier, i);
+		}
+	}
+	ConcurrentUnionFind unionFind { numItems };
+	mergeInThreads(unionFind, pairs, 8);
+	size_t wrong = 0;
+	for (size_t i = 0; i < numItems; i++)
+	{
+		if (unionFind.find(i) != i % numSets) wrong += 1;
+	}
+	CHECK(wrong == 0);
+}
+
+MBG_TEST(ConcurrentUnionFindParallelSingleSet)
+{
+	const size_t numItems = 100000;
+	// one chain with its links split round robin over the threads, the root is still item 0
+	std::vector<std::pair<size_t, size_t>> pairs;
+	for (size_t i = 1; i < numItems; i++)
+	{
+		pairs.emplace_back(numItems - i, numItems - i - 1);
+	}
+	ConcurrentUnionFind unionFind { numItems };
+	mergeInThreads(unionFind, pairs, 8);
+	size_t wrong = 0;
+	for (size_t i = 0; i < numItems; i++)
+	{
+		if (unionFind.find(i) != 0) wrong += 1;
+	}
+	CHECK(wrong == 0);
+}
@@ -0,0 +1,180 @@
+#include <memory>
+#include <sstream>
+#include "TestHelper.h"
+#include "ReadPathStore.h"
+#include "Serializer.h"
+
+namespace
+{
+	ReadPath makePath(uint32_t ordinal, size_t partStart, const std::vector<Node>& nodes, const std::vector<uint32_t>& poses)
+	{
+		ReadPath result;
+		result.readName = ReadName { ordinal, partStart };
+		result.path = nodes;
+		result.readPoses = poses;
+		result.expandedReadPosStart = ordinal * 3 + 1;
+		result.expandedReadPosEnd = ordinal * 3 + 2;
+		result.leftClip = ordinal % 5;
+		result.rightClip = ordinal % 7;
+		result.readLength = 1000 + ordinal;
+		result.readLengthHPC = 800 + ordinal;
+		return result;
+	}
+
+	bool samePath(const ReadPath& left, const ReadPath& right)
+	{
+		if (left.readName != right.readName) return false;
+		if (left.path.size() != right.path.size()) return false;
+		for (size_t i = 0; i < left.path.size(); i++)
+		{
+			if (left.path[i].id() != right.path[i].id() || left.path[i].forward() != right.path[i].forward()) return false;
+		}
+		return left.readPoses == right.readPoses
+			&& left.expandedReadPosStart == right.expandedReadPosStart
+			&& left.expandedReadPosEnd == right.expandedReadPosEnd
+			&& left.leftClip == right.leftClip
+			&& left.rightClip == right.rightClip
+			&& left.readLength == right.readLength
+			&& left.readLengthHPC == right.readLengthHPC;
+	}
+
+	// differences around the one, two and three byte varint boundaries and the largest position
+	std::vector<ReadPath> makeTestPaths()
+	{
+		std::vector<ReadPath> result;
+		result.push_back(makePath(0, 0, { Node { 0, true } }, { 0 }));
+		result.push_back(makePath(1, 0, { Node { 5, false }, Node { 6, true } }, { 0, 0, 127, 255, 383 }));
+		result.push_back(makePath(1, 1000, { Node { 7, true } }, { 128, 16511, 32895, 32895 }));
+		result.push_back(makePath(2, 0, { Node { 1, true }, Node { 2, true }, Node { 3, false } }, { 16384, 2113535, 4210688 }));
+		result.push_back(makePath(3, 0, { Node { 4000000000ull, true } }, { 1, 4294967295u }));
+		result.push_back(makePath(4, 17, { Node { 5, false }, Node { 6, true } }, { 268435455, 268435456, 536870912 }));
+		return result;
+	}
+
+	ReadPathStore makeStore(const std::vector<ReadPath>& paths)
+	{
+		ReadPathStore result;
+		for (const ReadPath& path : paths)
+		{
+			result.push_back(path);
+		}
+		return result;
+	}
+}
+
+MBG_TEST(ReadPathStoreVarintPositions)
+{
+	std::vector<ReadPath> paths = makeTestPaths();
+	ReadPathStore store = makeStore(paths);
+	CHECK(store.size() == paths.size());
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		CHECK(samePath(store.get(i), paths[i]));
+		CHECK(store.readPoses(i) == paths[i].readPoses);
+		CHECK(store.numReadPoses(i) == paths[i].readPoses.size());
+		CHECK(store.firstReadPos(i) == paths[i].readPoses[0]);
+		CHECK(store.readName(i) == paths[i].readName);
+		CHECK(store.path(i).size() == paths[i].path.size());
+	}
+}
+
+MBG_TEST(ReadPathStoreCopyPermuteConcatenate)
+{
+	std::vector<ReadPath> paths = makeTestPaths();
+	ReadPathStore store = makeStore(paths);
+	ReadPathStore copied;
+	for (size_t i = 0; i < store.size(); i++)
+	{
+		copied.push_back(store, i);
+	}
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		CHECK(samePath(copied.get(i), paths[i]));
+	}
+	std::vector<size_t> order { 5, 3, 1, 0, 2, 4 };
+	ReadPathStore permuted = store.permuted(order);
+	CHECK(permuted.size() == order.size());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		CHECK(samePath(permuted.get(i), paths[order[i]]));
+	}
+	std::vector<std::unique_ptr<ReadPathStore>> parts;
+	parts.emplace_back(new ReadPathStore { makeStore({ paths[0], paths[1] }) });
+	parts.emplace_back(new ReadPathStore);
+	parts.emplace_back(new ReadPathStore { makeStore({ paths[2], paths[3], paths[4] }) });
+	parts.emplace_back(new ReadPathStore { makeStore({ paths[5] }) });
+	ReadPathStore concatenated = ReadPathStore::concatenate(parts, 2);
+	CHECK(concatenated.size() == paths.size());
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		CHECK(samePath(concatenated.get(i), paths[i]));
+	}
+	for (const auto& part : parts)
+	{
+		CHECK(part->size() == 0);
+	}
+}
+
+MBG_TEST(ReadPathStoreCompareAndSetExpanded)
+{
+	std::vector<ReadPath> paths = makeTestPaths();
+	ReadPathStore store = makeStore(paths);
+	// paths 1 and 5 have the same nodes
+	CHECK(store.pathEqual(1, 5));
+	CHECK(!store.pathLess(1, 5));
+	CHECK(!store.pathLess(5, 1));
+	CHECK(!store.pathEqual(0, 3));
+	CHECK(store.pathLess(0, 3));
+	CHECK(!store.pathLess(3, 0));
+	store.setExpandedReadPosStart(2, 12345);
+	store.setExpandedReadPosEnd(2, 4294967295u);
+	CHECK(store.expandedReadPosStart(2) == 12345);
+	CHECK(store.expandedReadPosEnd(2) == 4294967295u);
+	CHECK(store.readPoses(2) == paths[2].readPoses);
+}
+
+MBG_TEST(ReadPathStoreWriteReadRoundTrip)
+{
+	std::vector<ReadPath> paths = makeTestPaths();
+	ReadPathStore store = makeStore(paths);
+	std::stringstream stream;
+	store.write(stream);
+	ReadPathStore loaded;
+	loaded.push_back(paths[0]);
+	loaded.read(stream);
+	CHECK(stream.good());
+	CHECK(loaded.size() == paths.size());
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		CHECK(samePath(loaded.get(i), paths[i]));
+	}
+	ReadPathStore empty;
+	std::stringstream emptyStream;
+	empty.write(emptyStream);
+	ReadPathStore loadedEmpty;
+	loadedEmpty.read(emptyStream);
+	CHECK(emptyStream.good());
+	CHECK(loadedEmpty.size() == 0);
+}
+
+MBG_TEST(ReadPathStoreTruncatedRead)
+{
+	ReadPathStore store = makeStore(makeTestPaths());
+	std::stringstream stream;
+	store.write(stream);
+	const std::string full = stream.str();
+	for (size_t length : { (size_t)0, (size_t)4, (size_t)8, full.size() / 3, full.size() / 2, full.size() - 1 })
+	{
+		std::stringstream truncated { full.substr(0, length) };
+		ReadPathStore loaded;
+		loaded.read(truncated);
+		CHECK(!truncated.good());
+	}
+	// a garbage length field fails the stream instead of allocating it
+	std::stringstream corrupted;
+	Serializer::write(corrupted, (size_t)1 << 60);
+	corrupted << full;
+	ReadPathStore loaded;
+	loaded.read(corrupted);
+	CHECK(!corrupted.good());
+}
@@ -0,0 +1,208 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "TestHelper.h"
+#include "MBG.h"
+
+namespace
+{
+	std::string reverseComplement(const std::string& seq)
+	{
+		std::string result { seq.rbegin(), seq.rend() };
+		for (char& c : result)
+		{
+			switch(c)
+			{
+				case 'A': c = 'T'; break;
+				case 'C': c = 'G'; break;
+				case 'G': c = 'C'; break;
+				case 'T': c = 'A'; break;
+			}
+		}
+		return result;
+	}
+
+	// random genome with repeats of several lengths in several copies so multiplex resolution takes many steps at different k, error free reads from both strands
+	void writeReads(const std::string& fileName)
+	{
+		std::mt19937_64 rand { 3 };
+		auto randomSequence = [&rand](size_t length)
+		{
+			std::string result;
+			for (size_t i = 0; i < length; i++) result += "ACGT"[rand() % 4];
+			return result;
+		};
+		std::vector<std::string> repeats;
+		for (size_t length : { 80, 200, 450, 900, 1800 })
+		{
+			repeats.push_back(randomSequence(length));
+		}
+		std::string genome;
+		for (size_t i = 0; i < 25; i++)
+		{
+			genome += randomSequence(1000 + rand() % 2000);
+			genome += repeats[rand() % repeats.size()];
+		}
+		genome += randomSequence(2000);
+		std::ofstream file { fileName };
+		for (size_t i = 0; i < genome.size() * 15 / 4000; i++)
+		{
+			size_t start = rand() % (genome.size() - 4000);
+			std::string read = genome.substr(start, 4000);
+			if (i % 2 == 1) read = reverseComplement(read);
+			file << ">read" << i << std::endl << read << std::endl;
+		}
+	}
+
+	std::string fileContents(const std::string& fileName)
+	{
+		std::ifstream file { fileName, std::ios::binary };
+		std::stringstream result;
+		result << file.rdbuf();
+		return result.str();
+	}
+
+	void writeFile(const std::string& fileName, const std::string& contents)
+	{
+		std::ofstream file { fileName, std::ios::binary };
+		file << contents;
+	}
+
+	// log buffer which keeps a copy of the checkpoint file and its k every time the resolver logs having written it
+	// the rest of the log is dropped
+	class CheckpointSnapshotBuffer : public std::stringbuf
+	{
+	public:
+		CheckpointSnapshotBuffer(const std::string& checkpoint) :
+			std::stringbuf(std::ios::out | std::ios::ate),
+			snapshots(),
+			snapshotK(),
+			checkpoint(checkpoint)
+		{
+		}
+		std::vector<std::string> snapshots;
+		std::vector<size_t> snapshotK;
+	protected:
+		int sync() override
+		{
+			const std::string marker = "wrote resolution checkpoint after k=";
+			std::string logged = str();
+			size_t lineEnd = logged.rfind('\n');
+			if (lineEnd == std::string::npos) return 0;
+			size_t found = logged.find(marker);
+			if (found < lineEnd)
+			{
+				snapshots.push_back(fileContents(checkpoint));
+				snapshotK.push_back(std::stoull(logged.substr(found + marker.size())));
+			}
+			str(logged.substr(lineEnd+1));
+			return 0;
+		}
+	private:
+		std::string checkpoint;
+	};
+
+	// runMBG logs to std::cerr, sent to logBuffer here so it does not bury the test results
+	void runLogged(std::streambuf* logBuffer, const std::string& reads, const std::string& graph, const std::string& paths, const std::string& readPathFile, const std::string& checkpoint, const bool resume)
+	{
+		std::streambuf* oldBuf = std::cerr.rdbuf(logBuffer);
+		runMBG({ reads }, graph, 51, 20, 2, 2, ErrorMasking::Hpc, 2, false, paths, 4000, false, 0, "", "", false, 0, false, false, false, "", true, true, readPathFile, checkpoint, 0, resume);
+		std::cerr.rdbuf(oldBuf);
+	}
+
+	void runQuietly(const std::string& reads, const std::string& graph, const std::string& paths, const std::string& readPathFile, const std::string& checkpoint, const bool resume)
+	{
+		std::stringstream log;
+		runLogged(log.rdbuf(), reads, graph, paths, readPathFile, checkpoint, resume);
+	}
+
+	// checkpoints written during and after a full run, resumed with and without read path files
+	void checkResume(const std::string& name, const std::string& readPathFile)
+	{
+		const std::string reads = getTempFileName(name + ".reads.fa");
+		const std::string checkpoint = getTempFileName(name + ".checkpoint");
+		const std::string graph = getTempFileName(name + ".graph.gfa");
+		const std::string paths = getTempFileName(name + ".paths.gaf");
+		const std::string resumedGraph = getTempFileName(name + ".resumed.gfa");
+		const std::string resumedPaths = getTempFileName(name + ".resumed.gaf");
+		writeReads(reads);
+		CheckpointSnapshotBuffer snapshotLog { checkpoint };
+		runLogged(&snapshotLog, reads, graph, paths, readPathFile, checkpoint, false);
+		const std::string graphContents = fileContents(graph);
+		const std::string pathsContents = fileContents(paths);
+		CHECK(graphContents.size() > 0);
+		CHECK(pathsContents.size() > 0);
+		const std::string checkpointContents = fileContents(checkpoint);
+		CHECK(checkpointContents.size() > 0);
+		// the final checkpoint goes straight to building the graph
+		runQuietly(reads, resumedGraph, resumedPaths, readPathFile, checkpoint, true);
+		CHECK(graphContents == fileContents(resumedGraph));
+		CHECK(pathsContents == fileContents(resumedPaths));
+		// the interval is 0 so every step wrote a checkpoint, resuming from early, middle and late ones in the first round and from the start of the second round
+		// restores the queue, k and round mid resolution
+		const std::vector<std::string>& snapshots = snapshotLog.snapshots;
+		const std::vector<size_t>& snapshotK = snapshotLog.snapshotK;
+		CHECK(snapshots.size() >= 3);
+		// k starts from 0 again in the second round
+		size_t secondRoundStart = 0;
+		for (size_t i = 1; i < snapshotK.size(); i++)
+		{
+			if (snapshotK[i] < snapshotK[i-1]) secondRoundStart = i;
+		}
+		CHECK(secondRoundStart > 0);
+		if (snapshots.size() >= 3 && secondRoundStart > 0)
+		{
+			for (size_t index : { (size_t)0, secondRoundStart / 2, secondRoundStart * 3 / 4, secondRoundStart })
+			{
+				CHECK(snapshots[index].size() > 0);
+				writeFile(checkpoint, snapshots[index]);
+				std::remove(resumedGraph.c_str());
+				std::remove(resumedPaths.c_str());
+				CheckpointSnapshotBuffer resumedLog { checkpoint };
+				runLogged(&resumedLog, reads, resumedGraph, resumedPaths, readPathFile, checkpoint, true);
+				// the resumed run writes the same checkpoints as the uninterrupted run from the one it resumed from onwards
+				std::vector<std::string> remaining { snapshots.begin() + index, snapshots.end() };
+				CHECK(resumedLog.snapshots.size() == remaining.size());
+				CHECK(resumedLog.snapshots == remaining);
+				CHECK(graphContents == fileContents(resumedGraph));
+				CHECK(pathsContents == fileContents(resumedPaths));
+			}
+		}
+		// a truncated checkpoint exits with an error instead of crashing, so it runs in a child process
+		writeFile(checkpoint, checkpointContents.substr(0, checkpointContents.size() / 2));
+		std::cerr.flush();
+		pid_t child = fork();
+		if (child == 0)
+		{
+			runQuietly(reads, resumedGraph, resumedPaths, readPathFile, checkpoint, true);
+			_exit(0);
+		}
+		CHECK(child > 0);
+		int status = 0;
+		CHECK(waitpid(child, &status, 0) == child);
+		CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 1);
+		for (const std::string& fileName : { reads, checkpoint, graph, paths, resumedGraph, resumedPaths })
+		{
+			std::remove(fileName.c_str());
+		}
+		// the exited child does not remove its spilled raw paths
+		if (readPathFile != "") std::remove((readPathFile + ".raw").c_str());
+	}
+}
+
+MBG_TEST(ResolutionCheckpointResume)
+{
+	checkResume("checkpoint", "");
+}
+
+MBG_TEST(ResolutionCheckpointResumeSpilled)
+{
+	checkResume("checkpointspilled", getTempFileName("checkpointspilled.readpaths"));
+}
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <vector>
+#include "TestHelper.h"
+#include "SmallVector.h"
+
+namespace
+{
+	template <typename Container>
+	std::vector<int> sortedItems(const Container& items)
+	{
+		std::vector<int> result { items.begin(), items.end() };
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+}
+
+MBG_TEST(SmallVectorSpillAndBack)
+{
+	SmallVector<int, 4> vec;
+	for (int i = 0; i < 4; i++) vec.push_back(i * 10);
+	CHECK(vec.size() == 4);
+	CHECK(vec.end() - vec.begin() == 4);
+	for (int i = 0; i < 4; i++) CHECK(vec[i] == i * 10);
+	// past the inline capacity, all items move to the spill vector
+	vec.push_back(40);
+	vec.push_back(50);
+	CHECK(vec.size() == 6);
+	CHECK(vec.end() - vec.begin() == 6);
+	for (int i = 0; i < 6; i++) CHECK(vec[i] == i * 10);
+	// erase swaps the last item in
+	vec.eraseAt(1);
+	CHECK(vec.size() == 5);
+	CHECK(vec[1] == 50);
+	CHECK((sortedItems(vec) == std::vector<int> { 0, 20, 30, 40, 50 }));
+	// back at the inline capacity, items move back inline
+	vec.eraseAt(4);
+	CHECK(vec.size() == 4);
+	CHECK((sortedItems(vec) == std::vector<int> { 0, 20, 30, 50 }));
+	vec.eraseAt(0);
+	CHECK(vec.size() == 3);
+	CHECK(vec[0] == 30);
+	CHECK((sortedItems(vec) == std::vector<int> { 20, 30, 50 }));
+	// spills again after having been inline
+	for (int i = 0; i < 3; i++) vec.push_back(100 + i);
+	CHECK(vec.size() == 6);
+	CHECK((sortedItems(vec) == std::vector<int> { 20, 30, 50, 100, 101, 102 }));
+	vec.clear();
+	CHECK(vec.size() == 0);
+	CHECK(vec.begin() == vec.end());
+	vec.push_back(7);
+	CHECK(vec.size() == 1 && vec[0] == 7);
+}
+
+MBG_TEST(SmallVectorEraseUntilEmpty)
+{
+	SmallVector<int, 2> vec;
+	std::vector<int> expected;
+	for (int i = 0; i < 9; i++)
+	{
+		vec.push_back(i);
+		expected.push_back(i);
+	}
+	while (vec.size() > 0)
+	{
+		size_t index = vec.size() / 2;
+		expected.erase(std::find(expected.begin(), expected.end(), vec[index]));
+		vec.eraseAt(index);
+		CHECK(vec.size() == expected.size());
+		CHECK(sortedItems(vec) == expected);
+	}
+}
+
+MBG_TEST(SmallVectorSetOperations)
+{
+	SmallVectorSet<int, 2> set;
+	set.emplace(5);
+	set.emplace(3);
+	set.emplace(5);
+	CHECK(set.size() == 2);
+	CHECK(set.count(5) == 1);
+	CHECK(set.count(3) == 1);
+	CHECK(set.count(4) == 0);
+	std::vector<int> more { 3, 8, 1, 8, 9 };
+	set.insert(more.begin(), more.end());
+	CHECK(set.size() == 5);
+	CHECK((sortedItems(set) == std::vector<int> { 1, 3, 5, 8, 9 }));
+	CHECK(set.erase(4) == 0);
+	CHECK(set.size() == 5);
+	CHECK(set.erase(3) == 1);
+	CHECK(set.erase(3) == 0);
+	CHECK(set.count(3) == 0);
+	CHECK(set.erase(9) == 1);
+	CHECK(set.erase(1) == 1);
+	CHECK(set.size() == 2);
+	CHECK((sortedItems(set) == std::vector<int> { 5, 8 }));
+	set.emplace(3);
+	CHECK(set.count(3) == 1);
+	set.clear();
+	CHECK(set.size() == 0);
+	CHECK(set.count(5) == 0);
+	CHECK(set.erase(5) == 0);
+}
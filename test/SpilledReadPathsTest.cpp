@@ -0,0 +1,141 @@
+#include <fstream>
+#include <sstream>
+#include "TestHelper.h"
+#include "SpilledReadPaths.h"
+#include "Serializer.h"
+
+namespace
+{
+	ReadPath makePath(uint32_t ordinal, size_t partStart, const std::vector<Node>& nodes, const std::vector<uint32_t>& poses, size_t expandedStart)
+	{
+		ReadPath result;
+		result.readName = ReadName { ordinal, partStart };
+		result.path = nodes;
+		result.readPoses = poses;
+		result.expandedReadPosStart = expandedStart;
+		result.expandedReadPosEnd = expandedStart + 100;
+		result.leftClip = 3;
+		result.rightClip = ordinal;
+		result.readLength = 100000 + ordinal;
+		result.readLengthHPC = 80000 + ordinal;
+		return result;
+	}
+
+	bool samePath(const ReadPath& left, const ReadPath& right)
+	{
+		if (left.readName != right.readName) return false;
+		if (left.path.size() != right.path.size()) return false;
+		for (size_t i = 0; i < left.path.size(); i++)
+		{
+			if (left.path[i].id() != right.path[i].id() || left.path[i].forward() != right.path[i].forward()) return false;
+		}
+		return left.readPoses == right.readPoses
+			&& left.expandedReadPosStart == right.expandedReadPosStart
+			&& left.expandedReadPosEnd == right.expandedReadPosEnd
+			&& left.leftClip == right.leftClip
+			&& left.rightClip == right.rightClip
+			&& left.readLength == right.readLength
+			&& left.readLengthHPC == right.readLengthHPC;
+	}
+
+	// reads 0, 2 and 5 of 7 have paths, read 2 in two parts and out of order in the store
+	std::vector<ReadPath> makeTestPaths()
+	{
+		std::vector<ReadPath> result;
+		result.push_back(makePath(2, 500, { Node { 9, true } }, { 510, 700 }, 1000));
+		result.push_back(makePath(5, 0, { Node { 4000000000ull, false }, Node { 1, true } }, { 0, 16384, 4294967295u }, 0));
+		result.push_back(makePath(0, 0, { Node { 1, true }, Node { 2, false }, Node { 3, true } }, { 5, 5, 133, 16517 }, 7));
+		result.push_back(makePath(2, 0, { Node { 8, false } }, { 20 }, 4294967195u));
+		result.push_back(makePath(2, 500, { Node { 10, true }, Node { 11, true } }, { 600, 601, 729 }, 1100));
+		return result;
+	}
+}
+
+MBG_TEST(SpilledReadPathsFromStore)
+{
+	std::vector<ReadPath> paths = makeTestPaths();
+	ReadPathStore store;
+	for (const ReadPath& path : paths) store.push_back(path);
+	const std::string fileName = getTempFileName("spilled.fromstore");
+	{
+		SpilledReadPaths spilled { fileName, std::move(store), 7 };
+		CHECK(store.size() == 0);
+		CHECK(spilled.size() == paths.size());
+		CHECK(spilled.numReads() == 7);
+		for (uint32_t read : { 1, 3, 4, 6 })
+		{
+			CHECK(spilled.getPaths(read).size() == 0);
+		}
+		auto read0 = spilled.getPaths((uint32_t)0);
+		CHECK(read0.size() == 1 && samePath(read0[0].second, paths[2]));
+		auto read5 = spilled.getPaths((uint32_t)5);
+		CHECK(read5.size() == 1 && samePath(read5[0].second, paths[1]));
+		// paths of a read keep their order in the store
+		auto read2 = spilled.getPaths((uint32_t)2);
+		CHECK(read2.size() == 3);
+		CHECK(read2.size() == 3 && samePath(read2[0].second, paths[0]) && samePath(read2[1].second, paths[3]) && samePath(read2[2].second, paths[4]));
+		auto part = spilled.getPaths(ReadName { 2, 500 });
+		CHECK(part.size() == 2 && samePath(part[0].second, paths[0]) && samePath(part[1].second, paths[4]));
+		CHECK(spilled.getPaths(ReadName { 2, 1 }).size() == 0);
+		CHECK(std::ifstream { fileName }.good());
+	}
+	CHECK(!std::ifstream { fileName }.good());
+}
+
+MBG_TEST(SpilledReadPathsSetExpandedInPlace)
+{
+	std::vector<ReadPath> paths = makeTestPaths();
+	ReadPathStore store;
+	for (const ReadPath& path : paths) store.push_back(path);
+	SpilledReadPaths spilled { getTempFileName("spilled.expanded"), std::move(store), 7 };
+	auto read2 = spilled.getPaths((uint32_t)2);
+	CHECK(read2.size() == 3);
+	spilled.setExpandedReadPosStart(read2[1].first, 0);
+	spilled.setExpandedReadPosEnd(read2[1].first, 4294967295u);
+	spilled.setExpandedReadPosEnd(read2[2].first, 128);
+	paths[3].expandedReadPosStart = 0;
+	paths[3].expandedReadPosEnd = 4294967295u;
+	paths[4].expandedReadPosEnd = 128;
+	auto changed = spilled.getPaths((uint32_t)2);
+	CHECK(changed.size() == 3 && samePath(changed[0].second, paths[0]) && samePath(changed[1].second, paths[3]) && samePath(changed[2].second, paths[4]));
+	auto read0 = spilled.getPaths((uint32_t)0);
+	CHECK(read0.size() == 1 && samePath(read0[0].second, paths[2]));
+}
+
+MBG_TEST(SpilledReadPathsAddReadsWriteRead)
+{
+	std::vector<ReadPath> paths = makeTestPaths();
+	SpilledReadPaths spilled { getTempFileName("spilled.added"), 7 };
+	spilled.addRead(0, SpilledReadPaths::encodeRead({ paths[2] }));
+	spilled.addRead(2, SpilledReadPaths::encodeRead({ paths[3], paths[0], paths[4] }));
+	spilled.addRead(5, SpilledReadPaths::encodeRead({ paths[1] }));
+	spilled.finishAdding();
+	CHECK(spilled.size() == paths.size());
+	CHECK(spilled.getPaths((uint32_t)6).size() == 0);
+	auto read2 = spilled.getPaths((uint32_t)2);
+	CHECK(read2.size() == 3 && samePath(read2[0].second, paths[3]) && samePath(read2[1].second, paths[0]));
+	std::stringstream stream;
+	spilled.write(stream);
+	const std::string full = stream.str();
+	SpilledReadPaths loaded { getTempFileName("spilled.loaded"), 7 };
+	CHECK(loaded.read(stream));
+	CHECK(loaded.size() == paths.size());
+	for (uint32_t read = 0; read < 7; read++)
+	{
+		auto expected = spilled.getPaths(read);
+		auto got = loaded.getPaths(read);
+		CHECK(expected.size() == got.size());
+		for (size_t i = 0; i < expected.size() && i < got.size(); i++)
+		{
+			CHECK(expected[i].first == got[i].first);
+			CHECK(samePath(expected[i].second, got[i].second));
+		}
+	}
+	// a different read count or a truncated stream is rejected
+	std::stringstream otherCount { full };
+	SpilledReadPaths wrongCount { getTempFileName("spilled.wrongcount"), 6 };
+	CHECK(!wrongCount.read(otherCount));
+	std::stringstream truncated { full.substr(0, full.size() - 1) };
+	SpilledReadPaths wrongSize { getTempFileName("spilled.truncated"), 7 };
+	CHECK(!wrongSize.read(truncated));
+}
@@ -0,0 +1,36 @@
+#ifndef TestHelper_h
+#define TestHelper_h
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// minimal test registry for the unit tests in test/, built and run by make test
+// a failed check prints its location and fails its test, the rest of the test still runs
+
+class TestCase
+{
+public:
+	std::string name;
+	std::function<void()> run;
+};
+
+std::vector<TestCase>& getTests();
+void reportFailure(const char* file, int line, const std::string& expression);
+// path in the system temporary directory, for tests which need files
+std::string getTempFileName(const std::string& name);
+
+class TestRegistration
+{
+public:
+	TestRegistration(const std::string& name, std::function<void()> run);
+};
+
+#define MBG_TEST(name) \
+	void name(); \
+	TestRegistration name##Registration { #name, name }; \
+	void name()
+
+#define CHECK(expression) do { if (!(expression)) reportFailure(__FILE__, __LINE__, #expression); } while (false)
+
+#endif
@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include "TestHelper.h"
+
+// failures of the currently running test
+size_t numFailures = 0;
+
+std::vector<TestCase>& getTests()
+{
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+void reportFailure(const char* file, int line, const std::string& expression)
+{
+	std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+	numFailures += 1;
+}
+
+std::string getTempFileName(const std::string& name)
+{
+	return (std::filesystem::temp_directory_path() / ("MBGTest." + name)).string();
+}
+
+TestRegistration::TestRegistration(const std::string& name, std::function<void()> run)
+{
+	getTests().push_back(TestCase { name, run });
+}
+
+// usage: MBGTest [test name...], runs all tests without arguments
+int main(int argc, char** argv)
+{
+	std::vector<std::string> selected { argv + 1, argv + argc };
+	size_t numRun = 0;
+	size_t numFailed = 0;
+	for (const TestCase& test : getTests())
+	{
+		if (selected.size() > 0 && std::find(selected.begin(), selected.end(), test.name) == selected.end()) continue;
+		numFailures = 0;
+		test.run();
+		numRun += 1;
+		if (numFailures > 0)
+		{
+			std::cerr << "FAILED " << test.name << std::endl;
+			numFailed += 1;
+		}
+		else
+		{
+			std::cerr << "ok " << test.name << std::endl;
+		}
+	}
+	std::cerr << numRun - numFailed << "/" << numRun << " tests passed" << std::endl;
+	return numFailed == 0 ? 0 : 1;
+}